@@ -23,6 +23,7 @@
 
 #include "pavucontrol.h"
 #include "ui_cardwidget.h"
+#include "portavailability.h"
 #include <QWidget>
 
 class PortInfo {
@@ -33,7 +34,6 @@ public:
       int available;
       int direction;
       int64_t latency_offset;
-      std::vector<QByteArray> profiles;
 };
 
 class CardWidget : public QWidget, public Ui::CardWidget {
@@ -42,17 +42,20 @@ public:
     CardWidget(QWidget *parent = nullptr);
 
     QByteArray name;
+    /* The server's name for the card, kept across reconnects */
+    QByteArray cardName;
     uint32_t index;
     bool updating;
 
     std::vector< std::pair<QByteArray,QByteArray> > profiles;
-    std::map<QByteArray, PortInfo> ports;
     QByteArray activeProfile;
     QByteArray noInOutProfile;
     QByteArray lastActiveProfile;
     bool hasSinks;
     bool hasSources;
 
+    PortAvailability availability;
+
     void prepareMenu();
 
 protected:
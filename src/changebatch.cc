@@ -0,0 +1,335 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "changebatch.h"
+#include "channel.h"
+
+#include <QJsonArray>
+#include <QJsonValue>
+
+ChangeBatch::ChangeBatch(const std::vector<QJsonObject> &records, const Callback &done) :
+    mRecords(records),
+    mDone(done),
+    mOutstanding(0) {
+}
+
+void ChangeBatch::error(int record, const QString &why) {
+    mErrors << QObject::tr("Record %1: %2").arg(record).arg(why);
+}
+
+/* The operation of a record is told apart by what it is passed as userdata */
+void *ChangeBatch::expect(int record) {
+    Pending p;
+    p.batch = this;
+    p.record = record;
+    mPending.push_back(p);
+    return &mPending.back();
+}
+
+void ChangeBatch::started(pa_operation *o, pa_context *c, int record) {
+    if (!o) {
+        error(record, QString::fromUtf8(pa_strerror(pa_context_errno(c))));
+        return;
+    }
+
+    mOutstanding++;
+    pa_operation_unref(o);
+}
+
+void ChangeBatch::success_cb(pa_context *c, int success, void *userdata) {
+    Pending *p = static_cast<Pending*>(userdata);
+    ChangeBatch *batch = p->batch;
+
+    if (!success)
+        batch->error(p->record, QString::fromUtf8(pa_strerror(pa_context_errno(c))));
+
+    /* The callback may delete the batch, and with it mDone */
+    if (--batch->mOutstanding == 0) {
+        const Callback done = batch->mDone;
+        done(batch);
+    }
+}
+
+/* Raw per-channel volumes, or one percentage for all channels */
+static bool parse_volume(const QJsonValue &v, pa_cvolume &volume) {
+    if (v.isDouble()) {
+        const double percent = v.toDouble();
+
+        /* Also false for NaN */
+        if (!(percent >= 0 && percent <= static_cast<double>(PA_VOLUME_MAX - PA_VOLUME_MUTED) / PA_VOLUME_NORM * 100))
+            return false;
+
+        pa_cvolume_set(&volume, 1, percent2PaVolume(qRound(percent)));
+        return pa_cvolume_valid(&volume);
+    }
+
+    const QJsonArray values = v.toArray();
+    if (!v.isArray() || values.isEmpty() || values.size() > PA_CHANNELS_MAX)
+        return false;
+
+    volume.channels = values.size();
+    for (int i = 0; i < values.size(); i++) {
+        const double raw = values[i].toDouble();
+
+        if (!values[i].isDouble() || !(raw >= 0 && raw <= PA_VOLUME_MAX))
+            return false;
+        volume.values[i] = static_cast<pa_volume_t>(qRound64(raw));
+    }
+
+    return pa_cvolume_valid(&volume);
+}
+
+/* Either a number, the index, or a string, the name */
+static bool parse_target(const QJsonValue &v, uint32_t &index, QByteArray &name) {
+    if (v.isDouble()) {
+        const double d = v.toDouble();
+
+        if (!(d >= 0 && d <= UINT32_MAX))
+            return false;
+        index = static_cast<uint32_t>(qRound64(d));
+        return true;
+    }
+
+    if (v.isString()) {
+        name = v.toString().toUtf8();
+        return !name.isEmpty();
+    }
+
+    return false;
+}
+
+static bool parse_record_target(const QJsonObject &o, uint32_t &index, QByteArray &name) {
+    if (o.contains(QLatin1String("index")))
+        return parse_target(o.value(QLatin1String("index")), index, name);
+
+    return parse_target(o.value(QLatin1String("name")), index, name);
+}
+
+void ChangeBatch::applySink(pa_context *c, const QJsonObject &o, int n) {
+    uint32_t index = PA_INVALID_INDEX;
+    QByteArray name;
+    pa_cvolume volume;
+
+    if (!parse_record_target(o, index, name)) {
+        error(n, QObject::tr("a sink needs an index or a name"));
+        return;
+    }
+
+    if (o.contains(QLatin1String("volume"))) {
+        if (!parse_volume(o.value(QLatin1String("volume")), volume))
+            error(n, QObject::tr("invalid volume"));
+        else if (name.isNull())
+            started(pa_context_set_sink_volume_by_index(c, index, &volume, success_cb, expect(n)), c, n);
+        else
+            started(pa_context_set_sink_volume_by_name(c, name.constData(), &volume, success_cb, expect(n)), c, n);
+    }
+
+    if (o.contains(QLatin1String("mute"))) {
+        const int mute = o.value(QLatin1String("mute")).toBool();
+
+        if (name.isNull())
+            started(pa_context_set_sink_mute_by_index(c, index, mute, success_cb, expect(n)), c, n);
+        else
+            started(pa_context_set_sink_mute_by_name(c, name.constData(), mute, success_cb, expect(n)), c, n);
+    }
+
+    if (o.value(QLatin1String("active_port")).isString()) {
+        const QByteArray port = o.value(QLatin1String("active_port")).toString().toUtf8();
+
+        if (name.isNull())
+            started(pa_context_set_sink_port_by_index(c, index, port.constData(), success_cb, expect(n)), c, n);
+        else
+            started(pa_context_set_sink_port_by_name(c, name.constData(), port.constData(), success_cb, expect(n)), c, n);
+    }
+
+    if (o.value(QLatin1String("default")).toBool()) {
+        if (name.isNull())
+            name = o.value(QLatin1String("name")).toString().toUtf8();
+
+        if (name.isEmpty())
+            error(n, QObject::tr("making a sink the default needs its name"));
+        else
+            started(pa_context_set_default_sink(c, name.constData(), success_cb, expect(n)), c, n);
+    }
+}
+
+void ChangeBatch::applySource(pa_context *c, const QJsonObject &o, int n) {
+    uint32_t index = PA_INVALID_INDEX;
+    QByteArray name;
+    pa_cvolume volume;
+
+    if (!parse_record_target(o, index, name)) {
+        error(n, QObject::tr("a source needs an index or a name"));
+        return;
+    }
+
+    if (o.contains(QLatin1String("volume"))) {
+        if (!parse_volume(o.value(QLatin1String("volume")), volume))
+            error(n, QObject::tr("invalid volume"));
+        else if (name.isNull())
+            started(pa_context_set_source_volume_by_index(c, index, &volume, success_cb, expect(n)), c, n);
+        else
+            started(pa_context_set_source_volume_by_name(c, name.constData(), &volume, success_cb, expect(n)), c, n);
+    }
+
+    if (o.contains(QLatin1String("mute"))) {
+        const int mute = o.value(QLatin1String("mute")).toBool();
+
+        if (name.isNull())
+            started(pa_context_set_source_mute_by_index(c, index, mute, success_cb, expect(n)), c, n);
+        else
+            started(pa_context_set_source_mute_by_name(c, name.constData(), mute, success_cb, expect(n)), c, n);
+    }
+
+    if (o.value(QLatin1String("active_port")).isString()) {
+        const QByteArray port = o.value(QLatin1String("active_port")).toString().toUtf8();
+
+        if (name.isNull())
+            started(pa_context_set_source_port_by_index(c, index, port.constData(), success_cb, expect(n)), c, n);
+        else
+            started(pa_context_set_source_port_by_name(c, name.constData(), port.constData(), success_cb, expect(n)), c, n);
+    }
+
+    if (o.value(QLatin1String("default")).toBool()) {
+        if (name.isNull())
+            name = o.value(QLatin1String("name")).toString().toUtf8();
+
+        if (name.isEmpty())
+            error(n, QObject::tr("making a source the default needs its name"));
+        else
+            started(pa_context_set_default_source(c, name.constData(), success_cb, expect(n)), c, n);
+    }
+}
+
+void ChangeBatch::applySinkInput(pa_context *c, const QJsonObject &o, int n) {
+    uint32_t index = PA_INVALID_INDEX, sink = PA_INVALID_INDEX;
+    QByteArray name, sink_name;
+    pa_cvolume volume;
+
+    if (!parse_target(o.value(QLatin1String("index")), index, name) || !name.isNull()) {
+        error(n, QObject::tr("a sink input needs an index"));
+        return;
+    }
+
+    if (o.contains(QLatin1String("volume"))) {
+        if (!parse_volume(o.value(QLatin1String("volume")), volume))
+            error(n, QObject::tr("invalid volume"));
+        else
+            started(pa_context_set_sink_input_volume(c, index, &volume, success_cb, expect(n)), c, n);
+    }
+
+    if (o.contains(QLatin1String("mute")))
+        started(pa_context_set_sink_input_mute(c, index, o.value(QLatin1String("mute")).toBool(), success_cb, expect(n)), c, n);
+
+    if (o.contains(QLatin1String("sink"))) {
+        if (!parse_target(o.value(QLatin1String("sink")), sink, sink_name))
+            error(n, QObject::tr("invalid sink"));
+        else if (sink_name.isNull())
+            started(pa_context_move_sink_input_by_index(c, index, sink, success_cb, expect(n)), c, n);
+        else
+            started(pa_context_move_sink_input_by_name(c, index, sink_name.constData(), success_cb, expect(n)), c, n);
+    }
+
+    if (o.value(QLatin1String("kill")).toBool())
+        started(pa_context_kill_sink_input(c, index, success_cb, expect(n)), c, n);
+}
+
+void ChangeBatch::applySourceOutput(pa_context *c, const QJsonObject &o, int n) {
+    uint32_t index = PA_INVALID_INDEX, source = PA_INVALID_INDEX;
+    QByteArray name, source_name;
+
+    if (!parse_target(o.value(QLatin1String("index")), index, name) || !name.isNull()) {
+        error(n, QObject::tr("a source output needs an index"));
+        return;
+    }
+
+#if HAVE_SOURCE_OUTPUT_VOLUMES
+    pa_cvolume volume;
+
+    if (o.contains(QLatin1String("volume"))) {
+        if (!parse_volume(o.value(QLatin1String("volume")), volume))
+            error(n, QObject::tr("invalid volume"));
+        else
+            started(pa_context_set_source_output_volume(c, index, &volume, success_cb, expect(n)), c, n);
+    }
+
+    if (o.contains(QLatin1String("mute")))
+        started(pa_context_set_source_output_mute(c, index, o.value(QLatin1String("mute")).toBool(), success_cb, expect(n)), c, n);
+#endif
+
+    if (o.contains(QLatin1String("source"))) {
+        if (!parse_target(o.value(QLatin1String("source")), source, source_name))
+            error(n, QObject::tr("invalid source"));
+        else if (source_name.isNull())
+            started(pa_context_move_source_output_by_index(c, index, source, success_cb, expect(n)), c, n);
+        else
+            started(pa_context_move_source_output_by_name(c, index, source_name.constData(), success_cb, expect(n)), c, n);
+    }
+
+    if (o.value(QLatin1String("kill")).toBool())
+        started(pa_context_kill_source_output(c, index, success_cb, expect(n)), c, n);
+}
+
+void ChangeBatch::applyCard(pa_context *c, const QJsonObject &o, int n) {
+    uint32_t index = PA_INVALID_INDEX;
+    QByteArray name;
+
+    if (!parse_record_target(o, index, name)) {
+        error(n, QObject::tr("a card needs an index or a name"));
+        return;
+    }
+
+    if (o.value(QLatin1String("active_profile")).isString()) {
+        const QByteArray profile = o.value(QLatin1String("active_profile")).toString().toUtf8();
+
+        if (name.isNull())
+            started(pa_context_set_card_profile_by_index(c, index, profile.constData(), success_cb, expect(n)), c, n);
+        else
+            started(pa_context_set_card_profile_by_name(c, name.constData(), profile.constData(), success_cb, expect(n)), c, n);
+    }
+}
+
+void ChangeBatch::start(pa_context *c) {
+    /* Everything is sent at once, the server answers in order */
+    for (size_t i = 0; i < mRecords.size(); i++) {
+        const QJsonObject &o = mRecords[i];
+        const QString type = o.value(QLatin1String("type")).toString();
+        const int n = static_cast<int>(i) + 1;
+
+        if (type == QLatin1String("sink"))
+            applySink(c, o, n);
+        else if (type == QLatin1String("source"))
+            applySource(c, o, n);
+        else if (type == QLatin1String("sink_input"))
+            applySinkInput(c, o, n);
+        else if (type == QLatin1String("source_output"))
+            applySourceOutput(c, o, n);
+        else if (type == QLatin1String("card"))
+            applyCard(c, o, n);
+        else if (type != QLatin1String("server") && type != QLatin1String("client"))
+            error(n, QObject::tr("unknown type \"%1\"").arg(type));
+    }
+
+    if (mOutstanding == 0) {
+        const Callback done = mDone;
+        done(this);
+    }
+}
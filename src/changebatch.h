@@ -0,0 +1,70 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef changebatch_h
+#define changebatch_h
+
+#include "pavucontrol.h"
+
+#include <QJsonObject>
+#include <QStringList>
+#include <functional>
+#include <list>
+#include <vector>
+
+/* Sends the changes listed in records of the --apply format (described in
+ * commands.h) as pipelined operations, and calls back once the server has
+ * answered all of them. */
+class ChangeBatch {
+public:
+    typedef std::function<void(ChangeBatch *batch)> Callback;
+
+    ChangeBatch(const std::vector<QJsonObject> &records, const Callback &done);
+
+    /* The callback runs from here when there is nothing to wait for, it
+     * may delete the batch. A batch whose context goes away before the
+     * answers arrive never calls back and can simply be deleted. */
+    void start(pa_context *c);
+
+    bool ok() const { return mErrors.isEmpty(); }
+    const QStringList &errors() const { return mErrors; }
+
+private:
+    struct Pending {
+        ChangeBatch *batch;
+        int record;
+    };
+
+    void applySink(pa_context *c, const QJsonObject &o, int n);
+    void applySource(pa_context *c, const QJsonObject &o, int n);
+    void applySinkInput(pa_context *c, const QJsonObject &o, int n);
+    void applySourceOutput(pa_context *c, const QJsonObject &o, int n);
+    void applyCard(pa_context *c, const QJsonObject &o, int n);
+
+    void *expect(int record);
+    void started(pa_operation *o, pa_context *c, int record);
+    void error(int record, const QString &why);
+    static void success_cb(pa_context *c, int success, void *userdata);
+
+    std::vector<QJsonObject> mRecords;
+    Callback mDone;
+    std::list<Pending> mPending;
+    int mOutstanding;
+    QStringList mErrors;
+};
+
+#endif
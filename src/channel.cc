@@ -28,19 +28,9 @@
 #include <QFontMetrics>
 #include "channel.h"
 #include "minimalstreamwidget.h"
+#include "levelmeter.h"
 
 constexpr int SLIDER_SNAP = 2;
-static inline int paVolume2Percent(pa_volume_t vol)
-{
-    if (vol > PA_VOLUME_UI_MAX)
-        vol = PA_VOLUME_UI_MAX;
-    return qRound(static_cast<double>(vol - PA_VOLUME_MUTED) / PA_VOLUME_NORM * 100);
-}
-
-static inline pa_volume_t percent2PaVolume(int percent)
-{
-    return PA_VOLUME_MUTED + qRound(static_cast<double>(percent) / 100 * PA_VOLUME_NORM);
-}
 
 /*** ChannelWidget ***/
 
@@ -48,16 +38,23 @@ Channel::Channel(QGridLayout* parent) :
     QObject(parent),
     can_decibel(false),
     volumeScaleEnabled(true),
-    last(false)
+    last(false),
+    mVisible(true),
+    mMeterShown(false)
 {
     channelLabel = new QLabel(nullptr);
     volumeScale = new QSlider(Qt::Horizontal, nullptr);
     volumeLabel = new QLabel(nullptr);
+    peakMeter = new LevelMeter(nullptr);
 
     const int row = parent->rowCount();
     parent->addWidget(channelLabel, row, 0);
     parent->addWidget(volumeScale, row, 1);
     parent->addWidget(volumeLabel, row, 2);
+    parent->addWidget(peakMeter, row + 1, 1);
+
+    peakMeter->setFixedHeight(qMax(3, peakMeter->fontMetrics().height() / 5));
+    peakMeter->hide();
 
     // make the info font smaller
     QFont label_font = volumeLabel->font();
@@ -99,9 +96,20 @@ void Channel::setVolume(pa_volume_t volume) {
 
 void Channel::setVisible(bool visible)
 {
+    mVisible = visible;
     channelLabel->setVisible(visible);
     volumeScale->setVisible(visible);
     volumeLabel->setVisible(visible);
+    peakMeter->setVisible(visible && mMeterShown);
+}
+
+void Channel::setMeterShown(bool shown)
+{
+    if (shown == mMeterShown)
+        return;
+
+    mMeterShown = shown;
+    peakMeter->setVisible(mVisible && shown);
 }
 
 void Channel::setEnabled(bool enabled)
@@ -24,10 +24,23 @@
 #include <QObject>
 #include "pavucontrol.h"
 
+static inline int paVolume2Percent(pa_volume_t vol)
+{
+    if (vol > PA_VOLUME_UI_MAX)
+        vol = PA_VOLUME_UI_MAX;
+    return qRound(static_cast<double>(vol - PA_VOLUME_MUTED) / PA_VOLUME_NORM * 100);
+}
+
+static inline pa_volume_t percent2PaVolume(int percent)
+{
+    return PA_VOLUME_MUTED + qRound(static_cast<double>(percent) / 100 * PA_VOLUME_NORM);
+}
+
 class QGridLayout;
 class QLabel;
 class QSlider;
 class MinimalStreamWidget;
+class LevelMeter;
 
 class Channel : public QObject {
     Q_OBJECT
@@ -37,6 +50,8 @@ public:
     void setVolume(pa_volume_t volume);
     void setVisible(bool visible);
     void setEnabled(bool enabled);
+    /* The thin meter of the channel, for as long as the row is visible */
+    void setMeterShown(bool shown);
 
     int channel;
     MinimalStreamWidget *minimalStreamWidget;
@@ -53,9 +68,14 @@ public:
     QLabel *channelLabel;
     QSlider *volumeScale;
     QLabel *volumeLabel;
+    LevelMeter *peakMeter;
 
     //virtual void set_sensitive(bool enabled);
     virtual void setBaseVolume(pa_volume_t);
+
+private:
+    bool mVisible;
+    bool mMeterShown;
 };
 
 
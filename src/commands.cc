@@ -0,0 +1,505 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "commands.h"
+#include "pavucontrol.h"
+#include "changebatch.h"
+#include "channel.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include <stdio.h>
+#include <vector>
+
+static pa_mainloop *mainloop = nullptr;
+static int n_outstanding = 0;
+static int exit_status = 0;
+static bool dumping = false;
+static bool text_format = false;
+static std::vector<QJsonObject> changes;
+static QByteArray default_sink_name, default_source_name;
+
+static void fail(const QString &what, pa_context *c) {
+    g_printerr("%s: %s\n", what.toUtf8().constData(), pa_strerror(pa_context_errno(c)));
+    exit_status = 1;
+}
+
+static void finish_one(void) {
+    if (--n_outstanding <= 0)
+        pa_mainloop_quit(mainloop, exit_status);
+}
+
+static void start_query(pa_operation *o, pa_context *c, const QString &error) {
+    if (!o) {
+        fail(error, c);
+        return;
+    }
+
+    n_outstanding++;
+    pa_operation_unref(o);
+}
+
+/*** --dump ***/
+
+static QString text_value(const QJsonValue &v) {
+    switch (v.type()) {
+        case QJsonValue::Bool:
+            return v.toBool() ? QStringLiteral("yes") : QStringLiteral("no");
+        case QJsonValue::Double:
+            return QString::number(static_cast<qint64>(v.toDouble()));
+        case QJsonValue::String:
+            if (v.toString().contains(QLatin1Char(' ')))
+                return QStringLiteral("\"%1\"").arg(v.toString());
+            return v.toString();
+        case QJsonValue::Array: {
+            QStringList items;
+
+            /* Only the names of ports and profiles, the rest is too much
+             * for a line */
+            for (const QJsonValue &item : v.toArray())
+                items << (item.isObject() ? item.toObject().value(QLatin1String("name")).toString() : text_value(item));
+            return items.join(QLatin1Char(','));
+        }
+        default:
+            return QStringLiteral("-");
+    }
+}
+
+static void print_record(const char *type, QJsonObject o) {
+    if (text_format) {
+        QString line = QString::fromLatin1(type);
+
+        if (o.contains(QLatin1String("index"))) {
+            line += QLatin1String(" #");
+            line += text_value(o.take(QLatin1String("index")));
+        }
+        for (auto it = o.constBegin(); it != o.constEnd(); ++it) {
+            line += QLatin1Char(' ');
+            line += it.key();
+            line += QLatin1Char('=');
+            line += text_value(it.value());
+        }
+
+        puts(line.toUtf8().constData());
+        return;
+    }
+
+    o.insert(QLatin1String("type"), QLatin1String(type));
+
+    QByteArray line = QJsonDocument(o).toJson(QJsonDocument::Compact);
+    line += '\n';
+    fwrite(line.constData(), 1, line.size(), stdout);
+}
+
+static QJsonValue string_value(const char *s) {
+    return s ? QJsonValue(QString::fromUtf8(s)) : QJsonValue();
+}
+
+static QJsonValue index_value(uint32_t index) {
+    return index == PA_INVALID_INDEX ? QJsonValue() : QJsonValue(static_cast<qint64>(index));
+}
+
+static QJsonValue available_value(int available) {
+    switch (available) {
+        case PA_PORT_AVAILABLE_YES:
+            return QStringLiteral("yes");
+        case PA_PORT_AVAILABLE_NO:
+            return QStringLiteral("no");
+        default:
+            return QStringLiteral("unknown");
+    }
+}
+
+static void put_volume(QJsonObject &o, const pa_channel_map &m, const pa_cvolume &v) {
+    char buf[PA_CHANNEL_MAP_SNPRINT_MAX];
+    QJsonArray values;
+
+    for (int i = 0; i < v.channels; i++)
+        values.append(static_cast<qint64>(v.values[i]));
+
+    o.insert(QLatin1String("channel_map"), QString::fromUtf8(pa_channel_map_snprint(buf, sizeof(buf), &m)));
+    o.insert(QLatin1String("volume"), values);
+    o.insert(QLatin1String("volume_percent"), paVolume2Percent(pa_cvolume_max(&v)));
+}
+
+template<typename Port>
+static void put_ports(QJsonObject &o, Port **ports, uint32_t n_ports, Port *active_port) {
+    QJsonArray a;
+
+    for (uint32_t i = 0; i < n_ports; i++) {
+        QJsonObject p;
+        p.insert(QLatin1String("name"), string_value(ports[i]->name));
+        p.insert(QLatin1String("description"), string_value(ports[i]->description));
+        p.insert(QLatin1String("priority"), static_cast<qint64>(ports[i]->priority));
+        p.insert(QLatin1String("available"), available_value(ports[i]->available));
+        a.append(p);
+    }
+
+    o.insert(QLatin1String("ports"), a);
+    o.insert(QLatin1String("active_port"), active_port ? string_value(active_port->name) : QJsonValue());
+}
+
+/* Returns whether the list is complete, eol < 0 means it failed */
+static bool list_done(pa_context *c, int eol, const QString &error) {
+    if (eol == 0)
+        return false;
+
+    if (eol < 0 && pa_context_errno(c) != PA_ERR_NOENTITY)
+        fail(error, c);
+
+    finish_one();
+    return true;
+}
+
+static void server_cb(pa_context *c, const pa_server_info *i, void *) {
+    if (!i) {
+        fail(QObject::tr("Server info callback failure"), c);
+        finish_one();
+        return;
+    }
+
+    default_sink_name = i->default_sink_name;
+    default_source_name = i->default_source_name;
+
+    QJsonObject o;
+    o.insert(QLatin1String("server_name"), string_value(i->server_name));
+    o.insert(QLatin1String("server_version"), string_value(i->server_version));
+    o.insert(QLatin1String("host_name"), string_value(i->host_name));
+    o.insert(QLatin1String("user_name"), string_value(i->user_name));
+    o.insert(QLatin1String("default_sink"), string_value(i->default_sink_name));
+    o.insert(QLatin1String("default_source"), string_value(i->default_source_name));
+    o.insert(QLatin1String("protocol_version"), static_cast<qint64>(pa_context_get_server_protocol_version(c)));
+    print_record("server", o);
+
+    finish_one();
+}
+
+static void card_cb(pa_context *c, const pa_card_info *i, int eol, void *) {
+    if (list_done(c, eol, QObject::tr("Card callback failure")))
+        return;
+
+    QJsonObject o;
+    o.insert(QLatin1String("index"), index_value(i->index));
+    o.insert(QLatin1String("name"), string_value(i->name));
+    o.insert(QLatin1String("description"), string_value(pa_proplist_gets(i->proplist, PA_PROP_DEVICE_DESCRIPTION)));
+    o.insert(QLatin1String("driver"), string_value(i->driver));
+
+    QJsonArray profiles;
+    for (pa_card_profile_info2 ** p_profile = i->profiles2; p_profile && *p_profile != nullptr; ++p_profile) {
+        QJsonObject p;
+        p.insert(QLatin1String("name"), string_value((*p_profile)->name));
+        p.insert(QLatin1String("description"), string_value((*p_profile)->description));
+        p.insert(QLatin1String("priority"), static_cast<qint64>((*p_profile)->priority));
+        p.insert(QLatin1String("available"), !!(*p_profile)->available);
+        p.insert(QLatin1String("sinks"), static_cast<qint64>((*p_profile)->n_sinks));
+        p.insert(QLatin1String("sources"), static_cast<qint64>((*p_profile)->n_sources));
+        profiles.append(p);
+    }
+    o.insert(QLatin1String("profiles"), profiles);
+    o.insert(QLatin1String("active_profile"), i->active_profile2 ? string_value(i->active_profile2->name) : QJsonValue());
+
+    QJsonArray ports;
+    for (uint32_t j = 0; j < i->n_ports; j++) {
+        QJsonObject p;
+        p.insert(QLatin1String("name"), string_value(i->ports[j]->name));
+        p.insert(QLatin1String("description"), string_value(i->ports[j]->description));
+        p.insert(QLatin1String("available"), available_value(i->ports[j]->available));
+        p.insert(QLatin1String("direction"), i->ports[j]->direction == PA_DIRECTION_INPUT ? QStringLiteral("input") : QStringLiteral("output"));
+        p.insert(QLatin1String("latency_offset"), static_cast<qint64>(i->ports[j]->latency_offset));
+        ports.append(p);
+    }
+    o.insert(QLatin1String("ports"), ports);
+
+    print_record("card", o);
+}
+
+static void sink_cb(pa_context *c, const pa_sink_info *i, int eol, void *) {
+    if (list_done(c, eol, QObject::tr("Sink callback failure")))
+        return;
+
+    QJsonObject o;
+    o.insert(QLatin1String("index"), index_value(i->index));
+    o.insert(QLatin1String("name"), string_value(i->name));
+    o.insert(QLatin1String("description"), string_value(i->description));
+    o.insert(QLatin1String("driver"), string_value(i->driver));
+    o.insert(QLatin1String("card"), index_value(i->card));
+    o.insert(QLatin1String("monitor_source"), index_value(i->monitor_source));
+    o.insert(QLatin1String("hardware"), !!(i->flags & PA_SINK_HARDWARE));
+    o.insert(QLatin1String("default"), default_sink_name == i->name);
+    put_volume(o, i->channel_map, i->volume);
+    o.insert(QLatin1String("mute"), !!i->mute);
+    put_ports(o, i->ports, i->n_ports, i->active_port);
+
+    print_record("sink", o);
+}
+
+static void source_cb(pa_context *c, const pa_source_info *i, int eol, void *) {
+    if (list_done(c, eol, QObject::tr("Source callback failure")))
+        return;
+
+    QJsonObject o;
+    o.insert(QLatin1String("index"), index_value(i->index));
+    o.insert(QLatin1String("name"), string_value(i->name));
+    o.insert(QLatin1String("description"), string_value(i->description));
+    o.insert(QLatin1String("driver"), string_value(i->driver));
+    o.insert(QLatin1String("card"), index_value(i->card));
+    o.insert(QLatin1String("monitor_of_sink"), index_value(i->monitor_of_sink));
+    o.insert(QLatin1String("hardware"), !!(i->flags & PA_SOURCE_HARDWARE));
+    o.insert(QLatin1String("default"), default_source_name == i->name);
+    put_volume(o, i->channel_map, i->volume);
+    o.insert(QLatin1String("mute"), !!i->mute);
+    put_ports(o, i->ports, i->n_ports, i->active_port);
+
+    print_record("source", o);
+}
+
+static void sink_input_cb(pa_context *c, const pa_sink_input_info *i, int eol, void *) {
+    if (list_done(c, eol, QObject::tr("Sink input callback failure")))
+        return;
+
+    QJsonObject o;
+    o.insert(QLatin1String("index"), index_value(i->index));
+    o.insert(QLatin1String("name"), string_value(i->name));
+    o.insert(QLatin1String("application"), string_value(pa_proplist_gets(i->proplist, PA_PROP_APPLICATION_NAME)));
+    o.insert(QLatin1String("driver"), string_value(i->driver));
+    o.insert(QLatin1String("client"), index_value(i->client));
+    o.insert(QLatin1String("sink"), index_value(i->sink));
+    o.insert(QLatin1String("corked"), !!i->corked);
+    put_volume(o, i->channel_map, i->volume);
+    o.insert(QLatin1String("mute"), !!i->mute);
+
+    print_record("sink_input", o);
+}
+
+static void source_output_cb(pa_context *c, const pa_source_output_info *i, int eol, void *) {
+    if (list_done(c, eol, QObject::tr("Source output callback failure")))
+        return;
+
+    QJsonObject o;
+    o.insert(QLatin1String("index"), index_value(i->index));
+    o.insert(QLatin1String("name"), string_value(i->name));
+    o.insert(QLatin1String("application"), string_value(pa_proplist_gets(i->proplist, PA_PROP_APPLICATION_NAME)));
+    o.insert(QLatin1String("driver"), string_value(i->driver));
+    o.insert(QLatin1String("client"), index_value(i->client));
+    o.insert(QLatin1String("source"), index_value(i->source));
+    o.insert(QLatin1String("corked"), !!i->corked);
+#if HAVE_SOURCE_OUTPUT_VOLUMES
+    put_volume(o, i->channel_map, i->volume);
+    o.insert(QLatin1String("mute"), !!i->mute);
+#endif
+
+    print_record("source_output", o);
+}
+
+static void client_cb(pa_context *c, const pa_client_info *i, int eol, void *) {
+    if (list_done(c, eol, QObject::tr("Client callback failure")))
+        return;
+
+    QJsonObject o;
+    o.insert(QLatin1String("index"), index_value(i->index));
+    o.insert(QLatin1String("name"), string_value(i->name));
+    o.insert(QLatin1String("driver"), string_value(i->driver));
+    o.insert(QLatin1String("process_id"), string_value(pa_proplist_gets(i->proplist, PA_PROP_APPLICATION_PROCESS_ID)));
+
+    print_record("client", o);
+}
+
+static void start_dump(pa_context *c) {
+    /* Replies come in the order of the requests, so the defaults are known
+     * before the devices arrive */
+    start_query(pa_context_get_server_info(c, server_cb, nullptr), c, QObject::tr("pa_context_get_server_info() failed"));
+    start_query(pa_context_get_card_info_list(c, card_cb, nullptr), c, QObject::tr("pa_context_get_card_info_list() failed"));
+    start_query(pa_context_get_sink_info_list(c, sink_cb, nullptr), c, QObject::tr("pa_context_get_sink_info_list() failed"));
+    start_query(pa_context_get_source_info_list(c, source_cb, nullptr), c, QObject::tr("pa_context_get_source_info_list() failed"));
+    start_query(pa_context_get_sink_input_info_list(c, sink_input_cb, nullptr), c, QObject::tr("pa_context_get_sink_input_info_list() failed"));
+    start_query(pa_context_get_source_output_info_list(c, source_output_cb, nullptr), c, QObject::tr("pa_context_get_source_output_info_list() failed"));
+    start_query(pa_context_get_client_info_list(c, client_cb, nullptr), c, QObject::tr("pa_context_get_client_info_list() failed"));
+}
+
+/*** --apply ***/
+
+static ChangeBatch *batch = nullptr;
+
+static void apply_done(ChangeBatch *b) {
+    for (const QString &e : b->errors())
+        g_printerr("%s\n", e.toUtf8().constData());
+
+    if (!b->ok())
+        exit_status = 1;
+
+    pa_mainloop_quit(mainloop, exit_status);
+}
+
+static bool read_changes(const QString &path) {
+    QFile file(path);
+    QJsonParseError error;
+
+    if (!(path == QLatin1String("-") ? file.open(stdin, QIODevice::ReadOnly) : file.open(QIODevice::ReadOnly))) {
+        g_printerr("%s\n", QObject::tr("Unable to read %1").arg(path).toUtf8().constData());
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &error);
+
+    if (error.error == QJsonParseError::NoError) {
+        if (doc.isObject()) {
+            changes.push_back(doc.object());
+            return true;
+        }
+
+        for (const QJsonValue &v : doc.array()) {
+            if (!v.isObject()) {
+                g_printerr("%s\n", QObject::tr("%1: expected an array of objects").arg(path).toUtf8().constData());
+                return false;
+            }
+            changes.push_back(v.toObject());
+        }
+        return true;
+    }
+
+    /* One object per line, as written by --dump */
+    int line = 0;
+    for (const QByteArray &text : data.split('\n')) {
+        line++;
+
+        if (text.trimmed().isEmpty())
+            continue;
+
+        const QJsonDocument record = QJsonDocument::fromJson(text, &error);
+        if (error.error != QJsonParseError::NoError || !record.isObject()) {
+            g_printerr("%s\n", QObject::tr("%1:%2: %3").arg(path).arg(line).arg(error.errorString()).toUtf8().constData());
+            return false;
+        }
+        changes.push_back(record.object());
+    }
+
+    return true;
+}
+
+/*** Connection ***/
+
+static void context_state_cb(pa_context *c, void *) {
+    switch (pa_context_get_state(c)) {
+        case PA_CONTEXT_READY:
+            if (dumping) {
+                start_dump(c);
+                if (n_outstanding <= 0)
+                    pa_mainloop_quit(mainloop, exit_status);
+            } else {
+                batch = new ChangeBatch(changes, apply_done);
+                batch->start(c);
+            }
+            break;
+
+        case PA_CONTEXT_FAILED:
+            fail(QObject::tr("Connection to PulseAudio failed"), c);
+            pa_mainloop_quit(mainloop, 1);
+            break;
+
+        case PA_CONTEXT_TERMINATED:
+            pa_mainloop_quit(mainloop, exit_status);
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool commands_requested(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dump") == 0 ||
+            strcmp(argv[i], "--apply") == 0 ||
+            strncmp(argv[i], "--apply=", 8) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+int commands_main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    pa_context *c;
+    int ret = 1;
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QObject::tr("PulseAudio Volume Control"));
+    parser.addHelpOption();
+
+    QCommandLineOption dumpOption(QStringLiteral("dump"), QObject::tr("Print the state of PulseAudio and exit."));
+    parser.addOption(dumpOption);
+
+    QCommandLineOption applyOption(QStringLiteral("apply"), QObject::tr("Apply the changes in a file, or - for standard input, and exit."), QStringLiteral("file"));
+    parser.addOption(applyOption);
+
+    QCommandLineOption formatOption(QStringLiteral("format"), QObject::tr("Output format of --dump, json or text."), QStringLiteral("format"), QStringLiteral("json"));
+    parser.addOption(formatOption);
+
+    parser.process(app);
+
+    dumping = parser.isSet(dumpOption);
+    if (dumping == parser.isSet(applyOption)) {
+        g_printerr("%s\n", QObject::tr("Use either --dump or --apply").toUtf8().constData());
+        return 1;
+    }
+
+    if (parser.value(formatOption) == QLatin1String("text"))
+        text_format = true;
+    else if (parser.value(formatOption) != QLatin1String("json")) {
+        g_printerr("%s\n", QObject::tr("Unknown format %1").arg(parser.value(formatOption)).toUtf8().constData());
+        return 1;
+    }
+
+    if (!dumping && !read_changes(parser.value(applyOption)))
+        return 1;
+
+    mainloop = pa_mainloop_new();
+    g_assert(mainloop);
+
+    pa_proplist *proplist = new_client_proplist();
+    c = pa_context_new_with_proplist(pa_mainloop_get_api(mainloop), nullptr, proplist);
+    g_assert(c);
+    pa_proplist_free(proplist);
+
+    pa_context_set_state_callback(c, context_state_cb, nullptr);
+
+    /* No waiting for a server to appear, scripts want an answer */
+    if (pa_context_connect(c, nullptr, PA_CONTEXT_NOFLAGS, nullptr) < 0)
+        fail(QObject::tr("Connection to PulseAudio failed"), c);
+    else if (pa_mainloop_run(mainloop, &ret) < 0)
+        ret = 1;
+
+    pa_context_disconnect(c);
+    pa_context_unref(c);
+    pa_mainloop_free(mainloop);
+    delete batch;
+    fflush(stdout);
+
+    return ret;
+}
@@ -0,0 +1,42 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef commands_h
+#define commands_h
+
+/* Headless modes for scripts: --dump prints the server state, one record
+ * per object as it arrives, and --apply sends the changes listed in a file
+ * and exits once the server confirmed all of them. Neither creates any
+ * widget.
+ *
+ * Records are JSON objects with a "type" of server, card, sink, source,
+ * sink_input, source_output or client. --apply reads the same records, as
+ * a JSON array or one object per line, so the output of --dump can be
+ * edited and fed back. Sinks, sources and cards are looked up by "index"
+ * or "name", streams by "index". Of each record only the writable fields
+ * are used: "volume" (raw per-channel volumes, or a single percentage),
+ * "mute", "active_port" and "default" for devices, "volume", "mute",
+ * "sink" or "source" and "kill" for streams and "active_profile" for
+ * cards. */
+
+/* Whether the command line asks for one of the headless modes */
+bool commands_requested(int argc, char *argv[]);
+
+/* Runs the requested mode, returns the exit status */
+int commands_main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,164 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "controlserver.h"
+#include "changebatch.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+
+/* A client that does not end its lines is dropped */
+#define MAX_LINE_LENGTH (1024 * 1024)
+
+ControlServer::ControlServer(QObject *parent) :
+    QObject(parent),
+    mServer(new QLocalServer(this)),
+    mNextId(0) {
+
+    connect(mServer, &QLocalServer::newConnection, this, &ControlServer::onNewConnection);
+}
+
+ControlServer::~ControlServer() {
+    for (auto & waiting : mBatches)
+        delete waiting.second.batch;
+}
+
+bool ControlServer::listen(const QString &name) {
+    QLocalServer::removeServer(name);
+    mServer->setSocketOptions(QLocalServer::UserAccessOption);
+    return mServer->listen(name);
+}
+
+void ControlServer::reset() {
+    /* The operations were cancelled with the context, no callback comes */
+    for (auto & waiting : mBatches) {
+        if (waiting.second.socket)
+            reply(waiting.second.socket, waiting.second.number, QStringList() << tr("Connection to PulseAudio lost"));
+        delete waiting.second.batch;
+    }
+
+    mBatches.clear();
+}
+
+void ControlServer::onNewConnection() {
+    while (QLocalSocket *socket = mServer->nextPendingConnection()) {
+        Client &client = mClients[socket];
+        client.batches = 0;
+
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket] { onReadyRead(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket] { onDisconnected(socket); });
+    }
+}
+
+void ControlServer::onReadyRead(QLocalSocket *socket) {
+    auto it = mClients.find(socket);
+    int end;
+
+    if (it == mClients.end())
+        return;
+
+    QByteArray &buffer = it->second.buffer;
+    buffer += socket->readAll();
+
+    while ((end = buffer.indexOf('\n')) >= 0) {
+        const QByteArray line = buffer.left(end);
+        buffer.remove(0, end + 1);
+
+        if (!line.trimmed().isEmpty())
+            runBatch(socket, line);
+    }
+
+    if (buffer.size() > MAX_LINE_LENGTH)
+        socket->abort();
+}
+
+void ControlServer::onDisconnected(QLocalSocket *socket) {
+    mClients.erase(socket);
+    socket->deleteLater();
+}
+
+void ControlServer::runBatch(QLocalSocket *socket, const QByteArray &line) {
+    const int number = ++mClients[socket].batches;
+    std::vector<QJsonObject> records;
+    QJsonParseError error;
+    pa_context *c = get_context();
+
+    const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+    if (error.error != QJsonParseError::NoError) {
+        reply(socket, number, QStringList() << error.errorString());
+        return;
+    }
+
+    if (doc.isObject())
+        records.push_back(doc.object());
+
+    for (const QJsonValue &v : doc.array()) {
+        if (!v.isObject()) {
+            reply(socket, number, QStringList() << tr("Expected an array of objects"));
+            return;
+        }
+        records.push_back(v.toObject());
+    }
+
+    if (!c || pa_context_get_state(c) != PA_CONTEXT_READY) {
+        reply(socket, number, QStringList() << tr("Not connected to PulseAudio"));
+        return;
+    }
+
+    const quint64 id = mNextId++;
+    Waiting &waiting = mBatches[id];
+    waiting.batch = new ChangeBatch(records, [this, id] (ChangeBatch *) { batchDone(id); });
+    waiting.socket = socket;
+    waiting.number = number;
+
+    waiting.batch->start(c);
+}
+
+void ControlServer::batchDone(quint64 id) {
+    auto it = mBatches.find(id);
+
+    if (it == mBatches.end())
+        return;
+
+    const Waiting waiting = it->second;
+    mBatches.erase(it);
+
+    if (waiting.socket)
+        reply(waiting.socket, waiting.number, waiting.batch->errors());
+
+    delete waiting.batch;
+}
+
+void ControlServer::reply(QLocalSocket *socket, int number, const QStringList &errors) {
+    QJsonObject o;
+
+    o.insert(QLatin1String("batch"), number);
+    o.insert(QLatin1String("ok"), errors.isEmpty());
+    if (!errors.isEmpty())
+        o.insert(QLatin1String("errors"), QJsonArray::fromStringList(errors));
+
+    QByteArray line = QJsonDocument(o).toJson(QJsonDocument::Compact);
+    line += '\n';
+    socket->write(line);
+}
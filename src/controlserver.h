@@ -0,0 +1,81 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef controlserver_h
+#define controlserver_h
+
+#include "pavucontrol.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <map>
+
+class ChangeBatch;
+class QLocalServer;
+class QLocalSocket;
+
+/* Local socket through which scripts send changes to the running instance,
+ * over its existing connection to the server.
+ *
+ * Every line a client writes is a batch: a JSON array of records in the
+ * --apply format, or a single record. All operations of a batch are sent
+ * at once, and batches are not waited for before the next one is read.
+ * Once the server has answered every operation of a batch, one line is
+ * written back: {"batch": n, "ok": true} or, with "ok": false, the
+ * "errors" of the records that failed. Batches are numbered from 1 per
+ * connection. */
+class ControlServer : public QObject {
+    Q_OBJECT
+public:
+    ControlServer(QObject *parent = nullptr);
+    virtual ~ControlServer();
+
+    /* Takes over a stale socket of the same name */
+    bool listen(const QString &name);
+
+    /* Fails the batches still waiting on a connection that went away */
+    void reset();
+
+private:
+    struct Client {
+        int batches;
+        QByteArray buffer;
+    };
+
+    struct Waiting {
+        ChangeBatch *batch;
+        QPointer<QLocalSocket> socket;
+        int number;
+    };
+
+    void onNewConnection();
+    void onReadyRead(QLocalSocket *socket);
+    void onDisconnected(QLocalSocket *socket);
+    void runBatch(QLocalSocket *socket, const QByteArray &line);
+    void batchDone(quint64 id);
+    void reply(QLocalSocket *socket, int number, const QStringList &errors);
+
+    QLocalServer *mServer;
+    std::map<QLocalSocket*, Client> mClients;
+    /* By order of arrival */
+    std::map<quint64, Waiting> mBatches;
+    quint64 mNextId;
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include "mainwindow.h"
 #include "devicewidget.h"
 #include "channel.h"
+#include "operationcoalescer.h"
 #include <sstream>
 #include <QAction>
 #include <QLabel>
@@ -39,15 +40,15 @@ DeviceWidget::DeviceWidget(MainWindow* parent, QByteArray deviceType) :
     offsetButtonEnabled(false),
     mpMainWindow(parent),
     rename{new QAction{tr("Rename device..."), this}},
+    spectrum{new QAction{tr("Spectrum..."), this}},
     mDeviceType(deviceType) {
 
     setupUi(this);
     advancedWidget->hide();
-    initPeakProgressBar(channelsGrid);
+    initPeakMeter(channelsGrid);
 
     timeout.setSingleShot(true);
     timeout.setInterval(100);
-    connect(&timeout, &QTimer::timeout, this, &DeviceWidget::timeoutEvent);
 
     connect(muteToggleButton, &QToolButton::toggled, this, &DeviceWidget::onMuteToggleButton);
     connect(lockToggleButton, &QToolButton::toggled, this, &DeviceWidget::onLockToggleButton);
@@ -55,6 +56,8 @@ DeviceWidget::DeviceWidget(MainWindow* parent, QByteArray deviceType) :
 
     connect(rename, &QAction::triggered, this, &DeviceWidget::renamePopup);
     addAction(rename);
+    connect(spectrum, &QAction::triggered, this, &DeviceWidget::onSpectrum);
+    addAction(spectrum);
     setContextMenuPolicy(Qt::ActionsContextMenu);
 
     connect(portList, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &DeviceWidget::onPortChange);
@@ -110,9 +113,8 @@ void DeviceWidget::updateChannelVolume(int channel, pa_volume_t v) {
 
     setVolume(n, true);
 
-    if (!timeout.isActive()) {
-        timeout.start();
-    }
+    executeVolumeUpdate();
+    timeout.start();
 }
 
 void DeviceWidget::hideLockedChannels(bool hide) {
@@ -122,6 +124,27 @@ void DeviceWidget::hideLockedChannels(bool hide) {
     channels[channelMap.channels - 1]->channelLabel->setVisible(!hide);
 }
 
+void DeviceWidget::updateChannelLevels(const LevelSample *levels, unsigned n) {
+    const bool shown = n > 0 && volumeMeterShown() && !lockToggleButton->isChecked();
+
+    for (int i = 0; i < channelMap.channels; i++) {
+        const bool has = shown && (unsigned) i < n;
+
+        channels[i]->setMeterShown(has);
+        if (has)
+            channels[i]->peakMeter->setReading(levels[i]);
+    }
+}
+
+void DeviceWidget::setVolumeMeterVisible(bool v) {
+    MinimalStreamWidget::setVolumeMeterVisible(v);
+
+    /* Shown again by the next reading */
+    if (!v)
+        for (int i = 0; i < channelMap.channels; i++)
+            channels[i]->setMeterShown(false);
+}
+
 void DeviceWidget::onMuteToggleButton() {
 
     lockToggleButton->setEnabled(!muteToggleButton->isChecked());
@@ -138,7 +161,6 @@ void DeviceWidget::onDefaultToggleButton() {
 }
 
 void DeviceWidget::onOffsetChange() {
-    pa_operation *o;
     int64_t offset;
     std::ostringstream card_stream;
     QByteArray card_name;
@@ -150,12 +172,11 @@ void DeviceWidget::onOffsetChange() {
     card_stream << card_index;
     card_name = QByteArray::fromStdString(card_stream.str());
 
-    if (!(o = pa_context_set_port_latency_offset(get_context(),
-            card_name.constData(), activePort.constData(), offset, nullptr, nullptr))) {
-        show_error(tr("pa_context_set_port_latency_offset() failed").toUtf8().constData());
-        return;
-    }
-    pa_operation_unref(o);
+    const QByteArray port = activePort;
+    mpMainWindow->operations->submit(OperationCoalescer::PortLatencyOffset, card_index, port, tr("pa_context_set_port_latency_offset() failed"),
+        [card_name, port, offset] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_port_latency_offset(get_context(), card_name.constData(), port.constData(), offset, cb, userdata);
+        });
 }
 
 void DeviceWidget::setDefault(bool isDefault) {
@@ -163,11 +184,6 @@ void DeviceWidget::setDefault(bool isDefault) {
     /*defaultToggleButton->setEnabled(!isDefault);*/
 }
 
-bool DeviceWidget::timeoutEvent() {
-    executeVolumeUpdate();
-    return false;
-}
-
 void DeviceWidget::executeVolumeUpdate() {
 }
 
@@ -204,7 +220,7 @@ void DeviceWidget::prepareMenu() {
     if (!ports.empty()) {
         portSelect->show();
 
-        if (pa_context_get_server_protocol_version(get_context()) >= 27) {
+        if (get_server_protocol_version() >= 27) {
             offsetSelect->show();
             advancedOptions->setEnabled(true);
         } else {
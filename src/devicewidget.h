@@ -43,6 +43,10 @@ public:
 
     void hideLockedChannels(bool hide = true);
 
+    /* Shown under the sliders while the channels are unlocked */
+    void updateChannelLevels(const LevelSample *levels, unsigned n) override;
+    void setVolumeMeterVisible(bool v) override;
+
     QByteArray name;
     QByteArray description;
     uint32_t index, card_index;
@@ -62,9 +66,10 @@ public Q_SLOTS:
     // virtual bool onContextTriggerEvent(GdkEventButton*);
     virtual void setLatencyOffset(int64_t offset);
     void onOffsetChange();
-    bool timeoutEvent();
 
 public:
+    /* Runs while a volume change made here may still be echoed back by the
+     * server, incoming volumes are not shown meanwhile */
     QTimer timeout;
 
     virtual void executeVolumeUpdate();
@@ -81,8 +86,11 @@ protected:
     MainWindow *mpMainWindow;
 
     virtual void onPortChange() = 0;
+    /* Opens the spectrum of the source, or of the monitor of the sink */
+    virtual void onSpectrum() = 0;
 
     QAction * rename;
+    QAction * spectrum;
 
 private:
     QByteArray mDeviceType;
@@ -0,0 +1,63 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "fftplan.h"
+
+#include <cmath>
+#include <utility>
+
+FftPlan::FftPlan(unsigned order) :
+    mTwiddles(1u << order >> 1),
+    mReverse(1u << order) {
+    const size_t n = mReverse.size();
+
+    for (size_t k = 0; k < mTwiddles.size(); k++)
+        mTwiddles[k] = std::polar(1.0f, (float) (-2 * M_PI * k / n));
+
+    for (size_t i = 0; i < n; i++) {
+        unsigned r = 0;
+        for (unsigned b = 0; b < order; b++)
+            if (i & (1u << b))
+                r |= 1u << (order - 1 - b);
+        mReverse[i] = r;
+    }
+}
+
+void FftPlan::transform(std::complex<float> *data) const {
+    const size_t n = mReverse.size();
+
+    for (size_t i = 0; i < n; i++)
+        if (i < mReverse[i])
+            std::swap(data[i], data[mReverse[i]]);
+
+    /* Butterflies of growing span, the twiddles of a span are every
+     * (n / span)th of the full table */
+    for (size_t span = 2; span <= n; span <<= 1) {
+        const size_t half = span >> 1, step = n / span;
+
+        for (size_t i = 0; i < n; i += span)
+            for (size_t k = 0; k < half; k++) {
+                const std::complex<float> t = mTwiddles[k * step] * data[i + k + half];
+                data[i + k + half] = data[i + k] - t;
+                data[i + k] += t;
+            }
+    }
+}
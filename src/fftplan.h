@@ -0,0 +1,41 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef fftplan_h
+#define fftplan_h
+
+#include <complex>
+#include <vector>
+
+/* Radix-2 FFT of a fixed size. The twiddle factors and the bit reversal
+ * order are computed once, transforms work in place and do not allocate. */
+class FftPlan {
+public:
+    /* Of 1 << order points */
+    explicit FftPlan(unsigned order);
+
+    size_t size() const { return mReverse.size(); }
+
+    /* data holds size() values */
+    void transform(std::complex<float> *data) const;
+
+private:
+    std::vector<std::complex<float> > mTwiddles;
+    std::vector<unsigned> mReverse;
+};
+
+#endif
@@ -0,0 +1,366 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "levelkernel.h"
+
+#include <math.h>
+
+#if defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && defined(__x86_64__)
+#  include <immintrin.h>
+#  define HAVE_AVX2_KERNEL 1
+#endif
+#if defined(__ARM_NEON)
+#  include <arm_neon.h>
+#endif
+
+typedef void (*level_kernel_t)(const float *data, size_t n, float *peak, float *sum);
+
+/* Per-lane peaks and sums of squares over interleaved data, accumulated
+ * into peak[] and sum[]. n is a multiple of period, which is a multiple of
+ * the vector width, so that every lane always sees the same channel. The
+ * data is read once, in order, one period at a time, with an accumulator
+ * per vector of the period.
+ *
+ * The vector kernels take the number of vectors in a period as V. Up to
+ * four, which covers 16 channels with AVX2 and 8 with SSE2 or NEON, the
+ * accumulators are kept in registers; V = 0 stands for any number, up to
+ * LEVEL_CHANNELS_MAX, kept in memory. */
+typedef void (*channels_kernel_t)(const float *data, size_t n, size_t period, float *peak, float *sum);
+
+struct level_kernels {
+    level_kernel_t level;
+    channels_kernel_t channels;
+    size_t width;
+};
+
+/* The kernels leave the sum of squares in *sum and start from the values
+ * already in *peak and *sum, so the tails can be left to the scalar one */
+static void level_scalar(const float *data, size_t n, float *peak, float *sum) {
+    float p = *peak, s = *sum;
+
+    for (size_t i = 0; i < n; i++) {
+        const float v = fabsf(data[i]);
+        if (v > p)
+            p = v;
+        s += data[i] * data[i];
+    }
+
+    *peak = p;
+    *sum = s;
+}
+
+#if !defined(__SSE2__) && !defined(__ARM_NEON)
+static void channels_scalar(const float *data, size_t n, size_t period, float *peak, float *sum) {
+    for (size_t i = 0; i < n; i += period) {
+        for (size_t k = 0; k < period; k++) {
+            const float v = fabsf(data[i + k]);
+            if (v > peak[k])
+                peak[k] = v;
+            sum[k] += data[i + k] * data[i + k];
+        }
+    }
+}
+#endif
+
+#if defined(__SSE2__)
+static void level_sse2(const float *data, size_t n, float *peak, float *sum) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 p = _mm_setzero_ps(), s = _mm_setzero_ps();
+    float lanes[4];
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        const __m128 v = _mm_loadu_ps(data + i);
+        p = _mm_max_ps(p, _mm_andnot_ps(sign, v));
+        s = _mm_add_ps(s, _mm_mul_ps(v, v));
+    }
+
+    _mm_storeu_ps(lanes, p);
+    for (float l : lanes)
+        if (l > *peak)
+            *peak = l;
+
+    _mm_storeu_ps(lanes, s);
+    *sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    level_scalar(data + i, n - i, peak, sum);
+}
+
+template<size_t V>
+static void channels_sse2_n(const float *data, size_t n, size_t period, float *peak, float *sum) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const size_t vectors = V ? V : period / 4;
+    __m128 p[V ? V : LEVEL_CHANNELS_MAX], s[V ? V : LEVEL_CHANNELS_MAX];
+
+    for (size_t k = 0; k < vectors; k++) {
+        p[k] = _mm_loadu_ps(peak + 4 * k);
+        s[k] = _mm_loadu_ps(sum + 4 * k);
+    }
+
+    for (size_t i = 0; i < n; i += period) {
+        for (size_t k = 0; k < vectors; k++) {
+            const __m128 v = _mm_loadu_ps(data + i + 4 * k);
+            p[k] = _mm_max_ps(p[k], _mm_andnot_ps(sign, v));
+            s[k] = _mm_add_ps(s[k], _mm_mul_ps(v, v));
+        }
+    }
+
+    for (size_t k = 0; k < vectors; k++) {
+        _mm_storeu_ps(peak + 4 * k, p[k]);
+        _mm_storeu_ps(sum + 4 * k, s[k]);
+    }
+}
+
+static void channels_sse2(const float *data, size_t n, size_t period, float *peak, float *sum) {
+    switch (period / 4) {
+        case 1:
+            channels_sse2_n<1>(data, n, period, peak, sum);
+            break;
+        case 2:
+            channels_sse2_n<2>(data, n, period, peak, sum);
+            break;
+        case 3:
+            channels_sse2_n<3>(data, n, period, peak, sum);
+            break;
+        case 4:
+            channels_sse2_n<4>(data, n, period, peak, sum);
+            break;
+        default:
+            channels_sse2_n<0>(data, n, period, peak, sum);
+            break;
+    }
+}
+#endif
+
+#if HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+static void level_avx2(const float *data, size_t n, float *peak, float *sum) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 p = _mm256_setzero_ps(), s = _mm256_setzero_ps();
+    float lanes[8];
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_loadu_ps(data + i);
+        p = _mm256_max_ps(p, _mm256_andnot_ps(sign, v));
+        s = _mm256_add_ps(s, _mm256_mul_ps(v, v));
+    }
+
+    _mm256_storeu_ps(lanes, p);
+    for (float l : lanes)
+        if (l > *peak)
+            *peak = l;
+
+    _mm256_storeu_ps(lanes, s);
+    for (float l : lanes)
+        *sum += l;
+
+    level_scalar(data + i, n - i, peak, sum);
+}
+
+template<size_t V>
+__attribute__((target("avx2")))
+static void channels_avx2_n(const float *data, size_t n, size_t period, float *peak, float *sum) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const size_t vectors = V ? V : period / 8;
+    __m256 p[V ? V : LEVEL_CHANNELS_MAX], s[V ? V : LEVEL_CHANNELS_MAX];
+
+    for (size_t k = 0; k < vectors; k++) {
+        p[k] = _mm256_loadu_ps(peak + 8 * k);
+        s[k] = _mm256_loadu_ps(sum + 8 * k);
+    }
+
+    for (size_t i = 0; i < n; i += period) {
+        for (size_t k = 0; k < vectors; k++) {
+            const __m256 v = _mm256_loadu_ps(data + i + 8 * k);
+            p[k] = _mm256_max_ps(p[k], _mm256_andnot_ps(sign, v));
+            s[k] = _mm256_add_ps(s[k], _mm256_mul_ps(v, v));
+        }
+    }
+
+    for (size_t k = 0; k < vectors; k++) {
+        _mm256_storeu_ps(peak + 8 * k, p[k]);
+        _mm256_storeu_ps(sum + 8 * k, s[k]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void channels_avx2(const float *data, size_t n, size_t period, float *peak, float *sum) {
+    switch (period / 8) {
+        case 1:
+            channels_avx2_n<1>(data, n, period, peak, sum);
+            break;
+        case 2:
+            channels_avx2_n<2>(data, n, period, peak, sum);
+            break;
+        case 3:
+            channels_avx2_n<3>(data, n, period, peak, sum);
+            break;
+        case 4:
+            channels_avx2_n<4>(data, n, period, peak, sum);
+            break;
+        default:
+            channels_avx2_n<0>(data, n, period, peak, sum);
+            break;
+    }
+}
+#endif
+
+#if defined(__ARM_NEON)
+static void level_neon(const float *data, size_t n, float *peak, float *sum) {
+    float32x4_t p = vdupq_n_f32(0), s = vdupq_n_f32(0);
+    float lanes[4];
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t v = vld1q_f32(data + i);
+        p = vmaxq_f32(p, vabsq_f32(v));
+        s = vmlaq_f32(s, v, v);
+    }
+
+    vst1q_f32(lanes, p);
+    for (float l : lanes)
+        if (l > *peak)
+            *peak = l;
+
+    vst1q_f32(lanes, s);
+    *sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    level_scalar(data + i, n - i, peak, sum);
+}
+
+template<size_t V>
+static void channels_neon_n(const float *data, size_t n, size_t period, float *peak, float *sum) {
+    const size_t vectors = V ? V : period / 4;
+    float32x4_t p[V ? V : LEVEL_CHANNELS_MAX], s[V ? V : LEVEL_CHANNELS_MAX];
+
+    for (size_t k = 0; k < vectors; k++) {
+        p[k] = vld1q_f32(peak + 4 * k);
+        s[k] = vld1q_f32(sum + 4 * k);
+    }
+
+    for (size_t i = 0; i < n; i += period) {
+        for (size_t k = 0; k < vectors; k++) {
+            const float32x4_t v = vld1q_f32(data + i + 4 * k);
+            p[k] = vmaxq_f32(p[k], vabsq_f32(v));
+            s[k] = vmlaq_f32(s[k], v, v);
+        }
+    }
+
+    for (size_t k = 0; k < vectors; k++) {
+        vst1q_f32(peak + 4 * k, p[k]);
+        vst1q_f32(sum + 4 * k, s[k]);
+    }
+}
+
+static void channels_neon(const float *data, size_t n, size_t period, float *peak, float *sum) {
+    switch (period / 4) {
+        case 1:
+            channels_neon_n<1>(data, n, period, peak, sum);
+            break;
+        case 2:
+            channels_neon_n<2>(data, n, period, peak, sum);
+            break;
+        case 3:
+            channels_neon_n<3>(data, n, period, peak, sum);
+            break;
+        case 4:
+            channels_neon_n<4>(data, n, period, peak, sum);
+            break;
+        default:
+            channels_neon_n<0>(data, n, period, peak, sum);
+            break;
+    }
+}
+#endif
+
+static level_kernels pick_kernels() {
+#if HAVE_AVX2_KERNEL
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return level_kernels{level_avx2, channels_avx2, 8};
+#endif
+#if defined(__SSE2__)
+    return level_kernels{level_sse2, channels_sse2, 4};
+#elif defined(__ARM_NEON)
+    return level_kernels{level_neon, channels_neon, 4};
+#else
+    return level_kernels{level_scalar, channels_scalar, 1};
+#endif
+}
+
+static const level_kernels &kernels() {
+    static const level_kernels k = pick_kernels();
+    return k;
+}
+
+void level_compute(const float *data, size_t n, float *peak, float *rms) {
+    float p = 0, s = 0;
+
+    if (n > 0)
+        kernels().level(data, n, &p, &s);
+
+    *peak = p;
+    *rms = n > 0 ? sqrtf(s / n) : 0;
+}
+
+void level_compute_channels(const float *data, size_t frames, unsigned channels, float *peaks, float *rms) {
+    const level_kernels &k = kernels();
+    float peak[LEVEL_CHANNELS_MAX * 8], sum[LEVEL_CHANNELS_MAX * 8];
+    const size_t n = frames * channels;
+    size_t period = channels;
+
+    /* The least common multiple of the channels and the vector width */
+    while (period % k.width)
+        period += channels;
+
+    const size_t whole = n - n % period;
+
+    for (size_t j = 0; j < period; j++)
+        peak[j] = sum[j] = 0;
+
+    k.channels(data, whole, period, peak, sum);
+
+    for (unsigned c = 0; c < channels; c++)
+        peaks[c] = rms[c] = 0;
+
+    for (size_t j = 0; j < period; j++) {
+        const unsigned c = j % channels;
+        if (peak[j] > peaks[c])
+            peaks[c] = peak[j];
+        rms[c] += sum[j];
+    }
+
+    /* The frames left over, whole is a multiple of the channels */
+    for (size_t i = whole; i < n; i++) {
+        const unsigned c = i % channels;
+        const float v = fabsf(data[i]);
+        if (v > peaks[c])
+            peaks[c] = v;
+        rms[c] += data[i] * data[i];
+    }
+
+    for (unsigned c = 0; c < channels; c++)
+        rms[c] = frames > 0 ? sqrtf(rms[c] / frames) : 0;
+}
@@ -0,0 +1,44 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef levelkernel_h
+#define levelkernel_h
+
+#include <glib.h>
+#include <stddef.h>
+
+/* One reading of a meter, over all samples received since the previous
+ * one. A negative peak stands for a suspended source. */
+struct LevelSample {
+    float peak;
+    float rms;
+    /* g_get_monotonic_time() when it was read */
+    gint64 timestamp;
+};
+
+/* Largest absolute value and root mean square of n samples, in one pass
+ * with the widest vector unit the CPU has, picked on first use */
+void level_compute(const float *data, size_t n, float *peak, float *rms);
+
+/* As many channels as a pulse channel map can have */
+#define LEVEL_CHANNELS_MAX 32
+
+/* The same per channel, over frames of interleaved samples, with the
+ * vector lanes laid over whole frames */
+void level_compute_channels(const float *data, size_t frames, unsigned channels, float *peaks, float *rms);
+
+#endif
@@ -0,0 +1,132 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+/* Checks the vector level kernels against a plain scalar reference, over
+ * every channel count and the lengths and offsets that leave tails, and
+ * prints how long both take per sample */
+
+#include "levelkernel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static void reference(const float *data, size_t frames, unsigned channels, float *peaks, float *rms) {
+    for (unsigned c = 0; c < channels; c++) {
+        double p = 0, s = 0;
+
+        for (size_t i = c; i < frames * channels; i += channels) {
+            p = std::max(p, static_cast<double>(std::fabs(data[i])));
+            s += static_cast<double>(data[i]) * data[i];
+        }
+
+        peaks[c] = static_cast<float>(p);
+        rms[c] = frames > 0 ? static_cast<float>(std::sqrt(s / frames)) : 0;
+    }
+}
+
+static int failures = 0;
+
+static void check(const char *what, size_t frames, unsigned channels, size_t offset,
+                  const float *peaks, const float *rms, const float *ref_peaks, const float *ref_rms) {
+    for (unsigned c = 0; c < channels; c++) {
+        /* The sums are added up in another order */
+        if (peaks[c] == ref_peaks[c] && std::fabs(rms[c] - ref_rms[c]) <= 1e-4f * ref_rms[c] + 1e-7f)
+            continue;
+
+        if (failures++ < 10)
+            std::fprintf(stderr, "%s: %zu frames, %u channels, offset %zu, channel %u: %g/%g, expected %g/%g\n",
+                         what, frames, channels, offset, c, peaks[c], rms[c], ref_peaks[c], ref_rms[c]);
+    }
+}
+
+static std::vector<float> noise(size_t n) {
+    std::vector<float> data(n);
+
+    srand(1);
+    for (auto & v : data)
+        v = static_cast<float>(rand()) / RAND_MAX * 2 - 1;
+
+    return data;
+}
+
+template<typename F>
+static double ns_per_sample(size_t samples, F f) {
+    const int rounds = 200;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; i++)
+        f();
+
+    const std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - start;
+    return took.count() / rounds / samples;
+}
+
+int main() {
+    const std::vector<float> data = noise(4096 * LEVEL_CHANNELS_MAX + 8);
+    float peaks[LEVEL_CHANNELS_MAX], rms[LEVEL_CHANNELS_MAX];
+    float ref_peaks[LEVEL_CHANNELS_MAX], ref_rms[LEVEL_CHANNELS_MAX];
+
+    for (size_t offset = 0; offset < 8; offset++) {
+        for (size_t n = 0; n < 300; n++) {
+            level_compute(data.data() + offset, n, peaks, rms);
+            reference(data.data() + offset, n, 1, ref_peaks, ref_rms);
+            check("level_compute", n, 1, offset, peaks, rms, ref_peaks, ref_rms);
+        }
+    }
+
+    for (unsigned channels = 1; channels <= LEVEL_CHANNELS_MAX; channels++) {
+        for (size_t offset = 0; offset < 8; offset += 3) {
+            for (size_t frames : {0, 1, 2, 3, 7, 8, 9, 31, 64, 333, 4096}) {
+                level_compute_channels(data.data() + offset, frames, channels, peaks, rms);
+                reference(data.data() + offset, frames, channels, ref_peaks, ref_rms);
+                check("level_compute_channels", frames, channels, offset, peaks, rms, ref_peaks, ref_rms);
+            }
+        }
+    }
+
+    /* A typical fragment, mono and stereo, and multichannel devices */
+    for (unsigned channels : {1, 2, 8, 16}) {
+        const size_t frames = 4096;
+        volatile float sink = 0;
+
+        const double scalar = ns_per_sample(frames * channels, [&] {
+            reference(data.data(), frames, channels, ref_peaks, ref_rms);
+            sink = ref_rms[0];
+        });
+        const double vector = ns_per_sample(frames * channels, [&] {
+            if (channels == 1)
+                level_compute(data.data(), frames, peaks, rms);
+            else
+                level_compute_channels(data.data(), frames, channels, peaks, rms);
+            sink = rms[0];
+        });
+
+        std::printf("%u channel(s), %zu frames: reference %.3f ns/sample, kernel %.3f ns/sample\n",
+                    channels, frames, scalar, vector);
+    }
+
+    if (failures) {
+        std::fprintf(stderr, "%d mismatches\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
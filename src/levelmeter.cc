@@ -0,0 +1,153 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#include "levelmeter.h"
+#include "meterballistics.h"
+#include <QEvent>
+#include <QLinearGradient>
+#include <QPaintEvent>
+#include <QPainter>
+
+#include <algorithm>
+#include <cstdlib>
+
+#define HOLD_WIDTH 2
+
+LevelMeter::LevelMeter(QWidget *parent) :
+    QWidget(parent),
+    mSlot(MeterBallistics::instance()->add(this)),
+    mLevel(0),
+    mHold(-1),
+    mCacheDpr(0) {
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+LevelMeter::~LevelMeter() {
+    MeterBallistics::instance()->remove(mSlot);
+}
+
+void LevelMeter::setReading(const LevelSample &level) {
+    MeterBallistics::instance()->input(mSlot, level);
+}
+
+void LevelMeter::setLevel(double level, double hold) {
+    level = std::min(level, 1.);
+    hold = std::min(hold, 1.);
+
+    if (level == mLevel && hold == mHold)
+        return;
+
+    if (isVisible()) {
+        /* Switching between active and inactive changes the whole trough */
+        if ((level < 0) != (mLevel < 0))
+            update();
+        else {
+            const int x0 = levelToX(mLevel);
+            const int x1 = levelToX(level);
+            if (x0 != x1)
+                update(std::min(x0, x1), 0, std::abs(x1 - x0), height());
+            if (hold != mHold) {
+                update(holdRect(mHold));
+                update(holdRect(hold));
+            }
+        }
+    }
+
+    mLevel = level;
+    mHold = hold;
+}
+
+QSize LevelMeter::sizeHint() const {
+    return QSize(fontMetrics().averageCharWidth() * 20, fontMetrics().height() / 2 + 4);
+}
+
+QSize LevelMeter::minimumSizeHint() const {
+    return QSize(fontMetrics().averageCharWidth() * 4, fontMetrics().height() / 2 + 4);
+}
+
+int LevelMeter::levelToX(double level) const {
+    if (level <= 0)
+        return 0;
+    return qRound(level * width());
+}
+
+QRect LevelMeter::holdRect(double hold) const {
+    if (hold < 0)
+        return QRect();
+    return QRect(std::min(levelToX(hold), width() - HOLD_WIDTH), 0, HOLD_WIDTH, height());
+}
+
+void LevelMeter::changeEvent(QEvent *event) {
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::StyleChange)
+        mCacheSize = QSize();
+    QWidget::changeEvent(event);
+}
+
+void LevelMeter::updateCache() {
+    const qreal dpr = devicePixelRatioF();
+
+    if (mCacheSize == size() && mCacheDpr == dpr)
+        return;
+
+    mCacheSize = size();
+    mCacheDpr = dpr;
+
+    const QSize pixelSize = size() * dpr;
+    const QRectF r(0, 0, width(), height());
+
+    mTrough = QPixmap(pixelSize);
+    mTrough.setDevicePixelRatio(dpr);
+    {
+        QPainter p(&mTrough);
+        p.fillRect(r, palette().color(QPalette::Base));
+        p.setPen(palette().color(QPalette::Mid));
+        p.drawRect(r.adjusted(0, 0, -1, -1));
+    }
+
+    mBar = QPixmap(pixelSize);
+    mBar.setDevicePixelRatio(dpr);
+    {
+        QPainter p(&mBar);
+        const QColor c = palette().color(QPalette::Highlight);
+        QLinearGradient g(r.topLeft(), r.bottomLeft());
+        g.setColorAt(0, c.lighter(120));
+        g.setColorAt(1, c.darker(110));
+        p.fillRect(r, g);
+    }
+}
+
+void LevelMeter::paintEvent(QPaintEvent *event) {
+    QPainter p(this);
+    const QRect dirty = event->rect();
+    const qreal dpr = devicePixelRatioF();
+
+    updateCache();
+
+    p.drawPixmap(dirty, mTrough, QRect(dirty.topLeft() * dpr, dirty.size() * dpr));
+
+    if (mLevel < 0)
+        return;
+
+    const QRect bar = QRect(0, 0, levelToX(mLevel), height()).intersected(dirty);
+    if (!bar.isEmpty())
+        p.drawPixmap(bar, mBar, QRect(bar.topLeft() * dpr, bar.size() * dpr));
+
+    const QRect hold = holdRect(mHold).intersected(dirty);
+    if (!hold.isEmpty())
+        p.fillRect(hold, palette().color(QPalette::Highlight).darker(150));
+}
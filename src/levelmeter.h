@@ -0,0 +1,70 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef levelmeter_h
+#define levelmeter_h
+
+#include <QWidget>
+#include <QPixmap>
+
+class MeterBallistics;
+struct LevelSample;
+
+/* A lightweight replacement for QProgressBar used by the volume meters.
+ * Readings go through MeterBallistics, which sets the levels of all meters
+ * that moved once per display frame; only the span between the old and the
+ * new level is invalidated. The trough and the bar are rendered once per
+ * size and device pixel ratio and blitted from cached pixmaps. */
+class LevelMeter : public QWidget {
+    Q_OBJECT
+public:
+    explicit LevelMeter(QWidget *parent = nullptr);
+    ~LevelMeter();
+
+    /* A negative peak draws an empty, inactive meter */
+    void setReading(const LevelSample &level);
+
+    /* Level and peak marker between 0 and 1, a negative level draws an
+     * empty, inactive meter and a negative marker none */
+    void setLevel(double level, double hold = -1);
+    double level() const { return mLevel; }
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void changeEvent(QEvent *event) override;
+
+private:
+    friend class MeterBallistics;
+
+    int levelToX(double level) const;
+    QRect holdRect(double hold) const;
+    void updateCache();
+
+    int mSlot;
+    double mLevel;
+    double mHold;
+
+    QPixmap mTrough;
+    QPixmap mBar;
+    QSize mCacheSize;
+    qreal mCacheDpr;
+};
+
+#endif
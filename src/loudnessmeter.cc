@@ -0,0 +1,258 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "loudnessmeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define SUBBLOCKS_MOMENTARY 4
+#define SUBBLOCKS_SHORT_TERM 30
+
+/* Histograms cover -70 to +10 LUFS */
+#define HISTOGRAM_TOP 10.
+#define HISTOGRAM_STEP .1
+#define HISTOGRAM_BINS 800
+
+static double energy_to_loudness(double e) {
+    return e > 0 ? -0.691 + 10 * std::log10(e) : -HUGE_VAL;
+}
+
+static double loudness_to_energy(double l) {
+    return std::pow(10., (l + 0.691) / 10);
+}
+
+static size_t loudness_bin(double l) {
+    const double bin = (l - LOUDNESS_FLOOR) / HISTOGRAM_STEP;
+    return (size_t) std::min(std::max(bin, 0.), HISTOGRAM_BINS - 1.);
+}
+
+void LoudnessMeter::Histogram::add(double e) {
+    const size_t bin = loudness_bin(energy_to_loudness(e));
+
+    counts[bin]++;
+    energies[bin] += e;
+    total++;
+    energy += e;
+}
+
+void LoudnessMeter::Histogram::clear() {
+    counts.assign(HISTOGRAM_BINS, 0);
+    energies.assign(HISTOGRAM_BINS, 0);
+    total = 0;
+    energy = 0;
+}
+
+double LoudnessMeter::Histogram::gated(double gate, unsigned *count, size_t *first) const {
+    double e = 0;
+
+    *count = 0;
+    *first = total ? loudness_bin(energy_to_loudness(energy / total) + gate) : HISTOGRAM_BINS;
+
+    for (size_t b = *first; b < HISTOGRAM_BINS; b++) {
+        *count += counts[b];
+        e += energies[b];
+    }
+
+    return e;
+}
+
+LoudnessMeter::LoudnessMeter() :
+    mChannels(0),
+    mSubblockFrames(1),
+    mSubblockFill(0),
+    mSubblockSum(0),
+    mSubblockCount(0),
+    mSubblockNext(0) {
+}
+
+void LoudnessMeter::configure(uint32_t rate, const pa_channel_map &map) {
+    /* The K-weighting filters of BS.1770, derived for any rate */
+    {
+        const double f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+        const double k = std::tan(M_PI * f0 / rate);
+        const double vh = std::pow(10., gain / 20), vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1 + k / q + k * k;
+
+        mShelf.b0 = (vh + vb * k / q + k * k) / a0;
+        mShelf.b1 = 2 * (k * k - vh) / a0;
+        mShelf.b2 = (vh - vb * k / q + k * k) / a0;
+        mShelf.a1 = 2 * (k * k - 1) / a0;
+        mShelf.a2 = (1 - k / q + k * k) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        const double k = std::tan(M_PI * f0 / rate);
+        const double a0 = 1 + k / q + k * k;
+
+        mHighPass.b0 = 1;
+        mHighPass.b1 = -2;
+        mHighPass.b2 = 1;
+        mHighPass.a1 = 2 * (k * k - 1) / a0;
+        mHighPass.a2 = (1 - k / q + k * k) / a0;
+    }
+
+    mChannels = map.channels;
+    mWeights.resize(mChannels);
+
+    /* Surround channels count more, the LFE not at all */
+    for (unsigned c = 0; c < mChannels; c++)
+        switch (map.map[c]) {
+            case PA_CHANNEL_POSITION_LFE:
+                mWeights[c] = 0;
+                break;
+            case PA_CHANNEL_POSITION_SIDE_LEFT:
+            case PA_CHANNEL_POSITION_SIDE_RIGHT:
+            case PA_CHANNEL_POSITION_REAR_LEFT:
+            case PA_CHANNEL_POSITION_REAR_RIGHT:
+                mWeights[c] = 1.41;
+                break;
+            default:
+                mWeights[c] = 1;
+                break;
+        }
+
+    mState.resize(mChannels * 4);
+    mSubblockFrames = std::max(rate / 10, 1u);
+    mSubblocks.resize(SUBBLOCKS_SHORT_TERM);
+
+    reset();
+}
+
+void LoudnessMeter::reset() {
+    std::fill(mState.begin(), mState.end(), 0.);
+    std::fill(mSubblocks.begin(), mSubblocks.end(), 0.);
+    mSubblockFill = 0;
+    mSubblockSum = 0;
+    mSubblockCount = 0;
+    mSubblockNext = 0;
+    mBlocks.clear();
+    mShortTerm.clear();
+}
+
+void LoudnessMeter::process(const float *data, size_t frames) {
+    while (frames > 0) {
+        /* Up to the end of the current 100 ms */
+        const size_t n = std::min(frames, mSubblockFrames - mSubblockFill);
+
+        for (unsigned c = 0; c < mChannels; c++) {
+            double *s = &mState[c * 4];
+            double sum = 0;
+
+            if (mWeights[c] == 0)
+                continue;
+
+            /* Transposed direct form II, both filters in a row */
+            for (size_t i = 0; i < n; i++) {
+                const double x = data[i * mChannels + c];
+                const double y = mShelf.b0 * x + s[0];
+                s[0] = mShelf.b1 * x - mShelf.a1 * y + s[1];
+                s[1] = mShelf.b2 * x - mShelf.a2 * y;
+
+                const double z = mHighPass.b0 * y + s[2];
+                s[2] = mHighPass.b1 * y - mHighPass.a1 * z + s[3];
+                s[3] = mHighPass.b2 * y - mHighPass.a2 * z;
+
+                sum += z * z;
+            }
+
+            mSubblockSum += mWeights[c] * sum;
+        }
+
+        data += n * mChannels;
+        frames -= n;
+        mSubblockFill += n;
+
+        if (mSubblockFill == mSubblockFrames)
+            endSubblock();
+    }
+}
+
+void LoudnessMeter::endSubblock() {
+    mSubblocks[mSubblockNext] = mSubblockSum / mSubblockFrames;
+    mSubblockNext = (mSubblockNext + 1) % SUBBLOCKS_SHORT_TERM;
+    mSubblockCount++;
+    mSubblockFill = 0;
+    mSubblockSum = 0;
+
+    /* Gating blocks of 400 ms overlap by 75%, short-term windows are taken
+     * every 100 ms as well */
+    const double floor = loudness_to_energy(LOUDNESS_FLOOR);
+
+    if (mSubblockCount >= SUBBLOCKS_MOMENTARY) {
+        const double e = windowEnergy(SUBBLOCKS_MOMENTARY);
+        if (e > floor)
+            mBlocks.add(e);
+    }
+
+    if (mSubblockCount >= SUBBLOCKS_SHORT_TERM) {
+        const double e = windowEnergy(SUBBLOCKS_SHORT_TERM);
+        if (e > floor)
+            mShortTerm.add(e);
+    }
+}
+
+double LoudnessMeter::windowEnergy(unsigned subblocks) const {
+    const unsigned n = std::min(subblocks, mSubblockCount);
+    double e = 0;
+
+    for (unsigned i = 1; i <= n; i++)
+        e += mSubblocks[(mSubblockNext + SUBBLOCKS_SHORT_TERM - i) % SUBBLOCKS_SHORT_TERM];
+
+    return n ? e / n : 0;
+}
+
+LoudnessReading LoudnessMeter::reading() const {
+    LoudnessReading r;
+    unsigned count;
+    size_t first;
+
+    r.momentary = std::max(energy_to_loudness(windowEnergy(SUBBLOCKS_MOMENTARY)), LOUDNESS_FLOOR);
+    r.shortTerm = std::max(energy_to_loudness(windowEnergy(SUBBLOCKS_SHORT_TERM)), LOUDNESS_FLOOR);
+
+    /* Relative gate of -10 LU over the blocks above the absolute one */
+    const double e = mBlocks.gated(-10, &count, &first);
+    r.integrated = count ? std::max(energy_to_loudness(e / count), LOUDNESS_FLOOR) : LOUDNESS_FLOOR;
+
+    /* Between the 10th and the 95th percentile of the short-term
+     * loudness, with a relative gate of -20 LU */
+    r.range = 0;
+    mShortTerm.gated(-20, &count, &first);
+    if (count) {
+        const unsigned low = (unsigned) (count * 0.10), high = std::min((unsigned) (count * 0.95), count - 1);
+        size_t lowBin = first, highBin = first;
+        unsigned seen = 0;
+
+        for (size_t b = first; b < HISTOGRAM_BINS; b++) {
+            if (seen <= low)
+                lowBin = b;
+            seen += mShortTerm.counts[b];
+            if (seen > high) {
+                highBin = b;
+                break;
+            }
+        }
+
+        r.range = (highBin - lowBin) * HISTOGRAM_STEP;
+    }
+
+    return r;
+}
@@ -0,0 +1,93 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef loudnessmeter_h
+#define loudnessmeter_h
+
+#include "pavucontrol.h"
+
+#include <vector>
+
+/* LUFS, and LU for the range. Below LOUDNESS_FLOOR before anything was
+ * loud enough to be measured. */
+struct LoudnessReading {
+    double momentary;
+    double shortTerm;
+    double integrated;
+    double range;
+};
+
+#define LOUDNESS_FLOOR -70.
+
+/* Loudness as of ITU-R BS.1770-4 and EBU R128: K-weighted mean square of
+ * each channel, weighted by position, over 400 ms (momentary) and 3 s
+ * (short-term) windows, in steps of 100 ms. The integrated loudness and the
+ * loudness range (EBU Tech 3342) are gated over histograms of 0.1 LU, so
+ * that their memory does not grow with the duration.
+ *
+ * Everything is allocated by configure(), process() does not allocate. */
+class LoudnessMeter {
+public:
+    LoudnessMeter();
+
+    void configure(uint32_t rate, const pa_channel_map &map);
+    /* Forgets what was measured */
+    void reset();
+
+    /* Frames of interleaved samples, in the channel map configured */
+    void process(const float *data, size_t frames);
+
+    LoudnessReading reading() const;
+
+private:
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    struct Histogram {
+        std::vector<unsigned> counts;
+        std::vector<double> energies;
+        unsigned total;
+        double energy;
+
+        void add(double e);
+        void clear();
+        /* The energy of the blocks within gate LU of their mean */
+        double gated(double gate, unsigned *count, size_t *first) const;
+    };
+
+    void endSubblock();
+    double windowEnergy(unsigned subblocks) const;
+
+    Biquad mShelf, mHighPass;
+    unsigned mChannels;
+    std::vector<double> mWeights;
+    /* Two states for each filter and channel */
+    std::vector<double> mState;
+
+    size_t mSubblockFrames, mSubblockFill;
+    double mSubblockSum;
+
+    /* The last 3 s, by 100 ms */
+    std::vector<double> mSubblocks;
+    unsigned mSubblockCount, mSubblockNext;
+
+    Histogram mBlocks;
+    Histogram mShortTerm;
+};
+
+#endif
@@ -0,0 +1,181 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "loudnessmonitor.h"
+
+#include <QLabel>
+
+#include <algorithm>
+
+/* Seconds of samples kept for the worker, well above the update interval */
+#define RING_SECONDS 2
+#define BLOCK_FRAMES 4096
+#define UPDATE_INTERVAL_MS 200
+
+/*** LoudnessWorker ***/
+
+LoudnessWorker::LoudnessWorker(QObject *parent) :
+    QThread(parent),
+    mRing(nullptr),
+    mChannels(1),
+    mRead(0),
+    mRequested(false),
+    mStopping(false),
+    mFresh(false) {
+}
+
+LoudnessWorker::~LoudnessWorker() {
+    stopAnalysis();
+}
+
+void LoudnessWorker::startAnalysis(const SampleRing *ring, uint32_t rate, const pa_channel_map &map) {
+    stopAnalysis();
+
+    mRing = ring;
+    mChannels = map.channels;
+    mRead = ring->written();
+    mBlock.resize(BLOCK_FRAMES * mChannels);
+    mMeter.configure(rate, map);
+    mStopping = mRequested = mFresh = false;
+
+    start();
+}
+
+void LoudnessWorker::stopAnalysis() {
+    {
+        QMutexLocker lock(&mMutex);
+        mStopping = true;
+        mWake.wakeOne();
+    }
+    wait();
+}
+
+void LoudnessWorker::requestReading() {
+    QMutexLocker lock(&mMutex);
+    mRequested = true;
+    mWake.wakeOne();
+}
+
+bool LoudnessWorker::takeReading(LoudnessReading *reading) {
+    QMutexLocker lock(&mMutex);
+
+    if (!mFresh)
+        return false;
+
+    mFresh = false;
+    *reading = mReading;
+    return true;
+}
+
+void LoudnessWorker::run() {
+    QMutexLocker lock(&mMutex);
+
+    for (;;) {
+        while (!mRequested && !mStopping)
+            mWake.wait(&mMutex);
+
+        if (mStopping)
+            return;
+
+        mRequested = false;
+
+        lock.unlock();
+        process();
+        const LoudnessReading reading = mMeter.reading();
+        lock.relock();
+
+        mReading = reading;
+        mFresh = true;
+    }
+}
+
+void LoudnessWorker::process() {
+    const quint64 written = mRing->written();
+
+    /* Whole frames only, in blocks of the buffer */
+    while (written - mRead >= mChannels) {
+        const size_t frames = std::min<quint64>((written - mRead) / mChannels, BLOCK_FRAMES);
+
+        if (!mRing->read(mRead, mBlock.data(), frames * mChannels)) {
+            /* Fell behind by more than the ring, the lost samples are
+             * skipped, keeping to whole frames */
+            const quint64 keep = mRing->capacity() / 2 / mChannels * mChannels;
+            mRead = written - std::min(written, keep);
+            mRead -= mRead % mChannels;
+            continue;
+        }
+
+        mMeter.process(mBlock.data(), frames);
+        mRead += frames * mChannels;
+    }
+}
+
+/*** LoudnessMonitor ***/
+
+LoudnessMonitor::LoudnessMonitor(QLabel *label, QObject *parent) :
+    QObject(parent),
+    mLabel(label),
+    mTap(false, RING_SECONDS, [this] { ready(); }, nullptr, [this] { failed(); }) {
+
+    mTimer.setInterval(UPDATE_INTERVAL_MS);
+    connect(&mTimer, &QTimer::timeout, this, &LoudnessMonitor::update);
+
+    mLabel->setText(tr("Loudness: waiting for the stream"));
+}
+
+LoudnessMonitor::~LoudnessMonitor() {
+    mWorker.stopAnalysis();
+}
+
+bool LoudnessMonitor::monitor(uint32_t source_idx, uint32_t stream_idx) {
+    if (!mTap.connect(source_idx, stream_idx))
+        return false;
+
+    mTap.setCorked(false);
+    return true;
+}
+
+void LoudnessMonitor::ready() {
+    mWorker.startAnalysis(mTap.ring(), mTap.rate(), mTap.channelMap());
+    mTimer.start();
+}
+
+void LoudnessMonitor::failed() {
+    mTimer.stop();
+    mWorker.stopAnalysis();
+    mLabel->setText(tr("Loudness: stream lost"));
+}
+
+static QString format_loudness(double l) {
+    return l > LOUDNESS_FLOOR ? QString::number(l, 'f', 1) : QStringLiteral("-") + QChar(0x221E);
+}
+
+void LoudnessMonitor::update() {
+    LoudnessReading r;
+
+    /* The label is only written when the worker has something new */
+    if (mWorker.takeReading(&r))
+        mLabel->setText(tr("M %1  S %2  I %3 LUFS  LRA %4 LU")
+                        .arg(format_loudness(r.momentary), format_loudness(r.shortTerm), format_loudness(r.integrated))
+                        .arg(r.range, 0, 'f', 1));
+
+    mWorker.requestReading();
+}
@@ -0,0 +1,89 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef loudnessmonitor_h
+#define loudnessmonitor_h
+
+#include "pavucontrol.h"
+#include "loudnessmeter.h"
+#include "sampletap.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+#include <vector>
+
+class QLabel;
+
+/* Feeds all samples of a ring, in order, to a LoudnessMeter and keeps the
+ * latest reading. Runs when asked to, the block buffer is allocated when
+ * started. */
+class LoudnessWorker : public QThread {
+public:
+    LoudnessWorker(QObject *parent = nullptr);
+    ~LoudnessWorker();
+
+    void startAnalysis(const SampleRing *ring, uint32_t rate, const pa_channel_map &map);
+    void stopAnalysis();
+
+    /* Measures what arrived since the previous time */
+    void requestReading();
+    bool takeReading(LoudnessReading *reading);
+
+protected:
+    void run() override;
+
+private:
+    void process();
+
+    LoudnessMeter mMeter;
+    const SampleRing *mRing;
+    unsigned mChannels;
+    quint64 mRead;
+    std::vector<float> mBlock;
+
+    QMutex mMutex;
+    QWaitCondition mWake;
+    bool mRequested, mStopping, mFresh;
+    LoudnessReading mReading;
+};
+
+/* EBU R128 loudness of a sink, or of a sink input, written to a label a
+ * few times per second. The stream runs for as long as the monitor exists,
+ * so that the integrated loudness covers the whole program. */
+class LoudnessMonitor : public QObject {
+    Q_OBJECT
+public:
+    LoudnessMonitor(QLabel *label, QObject *parent = nullptr);
+    ~LoudnessMonitor();
+
+    bool monitor(uint32_t source_idx, uint32_t stream_idx = PA_INVALID_INDEX);
+
+private:
+    void ready();
+    void failed();
+    void update();
+
+    QLabel *mLabel;
+    SampleTap mTap;
+    LoudnessWorker mWorker;
+    QTimer mTimer;
+};
+
+#endif
@@ -22,6 +22,7 @@
 #include <config.h>
 #endif
 
+#include <algorithm>
 #include <set>
 
 #include "mainwindow.h"
@@ -31,9 +32,22 @@
 #include "sinkinputwidget.h"
 #include "sourceoutputwidget.h"
 #include "rolewidget.h"
+#include "monitorstreammanager.h"
+#include "meterballistics.h"
+#include "spectrumdialog.h"
+#include "operationcoalescer.h"
+#include "controlserver.h"
+#include "changebatch.h"
+#include "channel.h"
+#include "streamlistmodel.h"
+#include "streamlistview.h"
 #include <QIcon>
+#include <QScrollBar>
+#include <QInputDialog>
+#include <QMenu>
 #include <QStyle>
 #include <QSettings>
+#include <QSortFilterProxyModel>
 
 /* Used for profile sorting */
 struct profile_prio_compare {
@@ -72,13 +86,30 @@ MainWindow::MainWindow():
     showSinkType(SINK_ALL),
     showSourceOutputType(SOURCE_OUTPUT_CLIENT),
     showSourceType(SOURCE_NO_MONITOR),
+    controlServer(nullptr),
     eventRoleWidget(nullptr),
     canRenameDevices(false),
+    sinkInputModel(nullptr),
+    sourceOutputModel(nullptr),
+    sinkInputFilter(nullptr),
+    sourceOutputFilter(nullptr),
+    sinkInputView(nullptr),
+    sourceOutputView(nullptr),
+    m_builtTabs(0),
+    m_dirtyTabs(0),
+    m_multipleSinks(false),
+    m_multipleSources(false),
     m_connected(false),
     m_config_filename(nullptr) {
 
     setupUi(this);
 
+    for (auto & shown : m_shownWidgets)
+        shown = 0;
+
+    monitorStreams = new MonitorStreamManager(this);
+    operations = new OperationCoalescer();
+
     sinkInputTypeComboBox->setCurrentIndex((int) showSinkInputType);
     sourceOutputTypeComboBox->setCurrentIndex((int) showSourceOutputType);
     sinkTypeComboBox->setCurrentIndex((int) showSinkType);
@@ -89,6 +120,13 @@ MainWindow::MainWindow():
     connect(sinkTypeComboBox, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::onSinkTypeComboBoxChanged);
     connect(sourceTypeComboBox, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &MainWindow::onSourceTypeComboBoxChanged);
     connect(showVolumeMetersCheckButton, &QCheckBox::toggled, this, &MainWindow::onShowVolumeMetersCheckButtonToggled);
+    connect(notebook, &QTabWidget::currentChanged, this, &MainWindow::onNotebookCurrentChanged);
+
+    /* Meters that scroll in or out of view */
+    for (QScrollArea *area : {scrollArea, scrollArea_2, scrollArea_3, scrollArea_4}) {
+        connect(area->verticalScrollBar(), &QScrollBar::valueChanged, this, [this] { monitorStreams->scheduleUpdate(); });
+        connect(area->verticalScrollBar(), &QScrollBar::rangeChanged, this, [this] { monitorStreams->scheduleUpdate(); });
+    }
 
     QAction * quit = new QAction{this};
     connect(quit, &QAction::triggered, this, &QWidget::close);
@@ -98,6 +136,24 @@ MainWindow::MainWindow():
     const QSettings config;
 
     showVolumeMetersCheckButton->setChecked(config.value(QStringLiteral("window/showVolumeMeters"), true).toBool());
+    showVolumeMetersCheckButton->installEventFilter(this);
+
+    monitorStreams->setRates(config.value(QStringLiteral("meters/peakRate"), 200).toUInt(),
+                             config.value(QStringLiteral("meters/deviceRate"), 25).toUInt(),
+                             config.value(QStringLiteral("meters/streamRate"), 10).toUInt());
+
+    /* Ballistics are picked from the context menu of the meters switch, the
+     * time constants can be tuned further in the settings */
+    MeterBallistics *ballistics = MeterBallistics::instance();
+    ballistics->setPreset((MeterBallistics::Preset) qBound(0, config.value(QStringLiteral("meters/ballistics"), 0).toInt(), (int) MeterBallistics::PresetVu));
+    ballistics->setPeakHold(config.value(QStringLiteral("meters/peakHold"), 1.5).toDouble());
+    monitorStreams->setPerChannel(config.value(QStringLiteral("meters/perChannel"), false).toBool());
+    if (config.contains(QStringLiteral("meters/attack")) || config.contains(QStringLiteral("meters/release")))
+        ballistics->setTimes(config.value(QStringLiteral("meters/attack")).toDouble(),
+                             config.value(QStringLiteral("meters/release")).toDouble());
+
+    showVolumeMetersCheckButton->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(showVolumeMetersCheckButton, &QWidget::customContextMenuRequested, this, &MainWindow::showMeterMenu);
 
     const QSize last_size  = config.value(QStringLiteral("window/size")).toSize();
     if (last_size.isValid())
@@ -132,28 +188,33 @@ MainWindow::~MainWindow() {
     config.setValue(QStringLiteral("window/sinkType"), sinkTypeComboBox->currentIndex());
     config.setValue(QStringLiteral("window/sourceType"), sourceTypeComboBox->currentIndex());
     config.setValue(QStringLiteral("window/showVolumeMeters"), showVolumeMetersCheckButton->isChecked());
+    config.setValue(QStringLiteral("meters/ballistics"), (int) MeterBallistics::instance()->preset());
+    config.setValue(QStringLiteral("meters/perChannel"), monitorStreams->perChannel());
 
-    while (!clientNames.empty()) {
-        auto i = clientNames.begin();
-        g_free(i->second);
-        clientNames.erase(i);
-    }
+    /* The dialogs are deleted with the other children, after the map */
+    for (auto & d : m_spectrumDialogs)
+        disconnect(d.second, &QObject::destroyed, this, nullptr);
+
+    cancelBulkChanges();
+    delete monitorStreams;
+    delete operations;
 }
 
 class DeviceWidget;
-static void updatePorts(DeviceWidget *w, std::map<QByteArray, PortInfo> &ports) {
-    std::map<QByteArray, PortInfo>::iterator it;
-    PortInfo p;
+/* Annotates the ports of a device with their availability on the card,
+ * returns whether any of the labels changed */
+static bool updatePorts(DeviceWidget *w, const std::map<QByteArray, PortInfo> &ports) {
+    std::map<QByteArray, PortInfo>::const_iterator it;
+    bool changed = false;
 
     for (auto & port : w->ports) {
-        QByteArray desc;
         it = ports.find(port.first);
 
         if (it == ports.end())
             continue;
 
-        p = it->second;
-        desc = p.description;
+        const PortInfo &p = it->second;
+        QByteArray desc = p.description;
 
         if (p.available == PA_PORT_AVAILABLE_YES)
             desc +=  MainWindow::tr(" (plugged in)").toUtf8().constData();
@@ -165,37 +226,184 @@ static void updatePorts(DeviceWidget *w, std::map<QByteArray, PortInfo> &ports)
                 desc += MainWindow::tr(" (unplugged)").toUtf8().constData();
         }
 
-        port.second = desc;
+        if (port.second != desc) {
+            port.second = desc;
+            changed = true;
+        }
     }
 
     it = ports.find(w->activePort);
 
-    if (it != ports.end()) {
-        p = it->second;
-        w->setLatencyOffset(p.latency_offset);
-    }
+    if (it != ports.end())
+        w->setLatencyOffset(it->second.latency_offset);
+
+    return changed;
 }
 
-static void setIconByName(QLabel* label, const char* name, const char* fallback_name = nullptr) {
+static QIcon iconByName(const char* name, const char* fallback_name = nullptr) {
     QIcon icon = QIcon::fromTheme(QString::fromLatin1(name));
     if (icon.isNull() || icon.availableSizes().isEmpty())
         icon = QIcon::fromTheme(QString::fromLatin1(fallback_name));
+    return icon;
+}
+
+static void setIconByName(QLabel* label, const char* name, const char* fallback_name = nullptr) {
+    QIcon icon = iconByName(name, fallback_name);
     int size = label->style()->pixelMetric(QStyle::PM_ToolBarIconSize);
     QPixmap pix = icon.pixmap(size, size);
     label->setPixmap(pix);
 }
 
+/* Records a value about to be shown, returns whether it differs from the one
+ * shown before */
+static bool shownChanged(QByteArray &shown, const char *value, bool force) {
+    if (!value)
+        value = "";
+
+    if (!force && shown == value)
+        return false;
+
+    shown = value;
+    return true;
+}
+
+/* Takes the widget left by the previous connection for the object of the
+ * given name, provided its channels still match */
+template <typename Widget>
+static Widget *takeStale(std::multimap<QByteArray, Widget*> &stale, const QByteArray &key, const pa_channel_map &map) {
+    auto range = stale.equal_range(key);
+
+    for (auto it = range.first; it != range.second; ++it) {
+        Widget *w = it->second;
+        if (pa_channel_map_equal(&w->channelMap, &map)) {
+            stale.erase(it);
+            return w;
+        }
+    }
+
+    return nullptr;
+}
+
+/* Shows "client: title" with the client in bold, or only the title while
+ * the client is unknown */
+static void setStreamTitle(StreamWidget *w, const ClientRecord *client) {
+    if (client) {
+        gchar *txt = g_markup_printf_escaped(": %s", w->shownText.constData());
+        w->boldNameLabel->setText(client->markup);
+        w->nameLabel->setText(QString::fromUtf8(txt));
+        g_free(txt);
+    } else {
+        w->boldNameLabel->setText(QLatin1String(""));
+        w->nameLabel->setText(QString::fromUtf8(w->shownText));
+    }
+
+    w->nameLabel->setToolTip(QString::fromUtf8(w->shownText));
+}
+
+/* Streams have no name of their own, they are told apart by their process
+ * and title. Several streams with the same key are matched in order. */
+static QByteArray streamReconnectKey(pa_proplist *l, const char *name) {
+    const char *t;
+    QByteArray key;
+
+    if ((t = pa_proplist_gets(l, PA_PROP_APPLICATION_PROCESS_ID)))
+        key += t;
+    key += '\n';
+    if ((t = pa_proplist_gets(l, PA_PROP_APPLICATION_NAME)))
+        key += t;
+    key += '\n';
+    key += name;
+
+    return key;
+}
+
 void MainWindow::updateCard(const pa_card_info &info) {
     CardWidget *w;
     bool is_new = false;
     const char *description, *icon;
-    std::set<pa_card_profile_info2 *, profile_prio_compare> profile_priorities;
+    std::vector<uint32_t> profile_priorities;
+    std::map<QByteArray, PortInfo> &ports = cardPorts[info.index];
+    std::set<QByteArray> changedPorts;
+
+    for (uint32_t i = 0; i < info.n_ports; ++i) {
+        const pa_card_port_info *port = info.ports[i];
+        auto old = ports.find(port->name);
+
+        if (old != ports.end()
+            && old->second.description == port->description
+            && old->second.priority == port->priority
+            && old->second.available == port->available
+            && old->second.direction == port->direction
+            && old->second.latency_offset == port->latency_offset)
+            continue;
+
+        PortInfo &p = ports[port->name];
+        p.name = port->name;
+        p.description = port->description;
+        p.priority = port->priority;
+        p.available = port->available;
+        p.direction = port->direction;
+        p.latency_offset = port->latency_offset;
+        changedPorts.insert(p.name);
+    }
+
+    if (ports.size() > info.n_ports) {
+        std::set<QByteArray> current;
+        for (uint32_t i = 0; i < info.n_ports; ++i)
+            current.insert(info.ports[i]->name);
+
+        for (auto it = ports.begin(); it != ports.end(); ) {
+            if (current.count(it->first))
+                ++it;
+            else {
+                changedPorts.insert(it->first);
+                it = ports.erase(it);
+            }
+        }
+    }
+
+    /* Because the port info for sinks and sources is discontinued we need
+     * to update the port info for them here, for the devices of this card
+     * that have one of the changed ports. */
+    auto devices = cardDevices.find(info.index);
+
+    if (!changedPorts.empty() && devices != cardDevices.end()) {
+        for (DeviceWidget *dw : devices->second) {
+            bool affected = false;
+
+            for (auto & port : dw->ports)
+                if ((affected = changedPorts.count(port.first)))
+                    break;
+
+            if (!affected)
+                continue;
+
+            dw->updating = true;
+            if (updatePorts(dw, ports))
+                dw->prepareMenu();
+            dw->updating = false;
+        }
+    }
+
+    if (!isTabBuilt(TAB_CONFIGURATION))
+        return;
 
     if (cardWidgets.count(info.index))
         w = cardWidgets[info.index];
     else {
-        cardWidgets[info.index] = w = new CardWidget(this);
-        cardsVBox->layout()->addWidget(w);
+        auto stale = m_staleCards.find(info.name);
+
+        if (stale != m_staleCards.end()) {
+            w = stale->second;
+            m_staleCards.erase(stale);
+        } else {
+            w = new CardWidget(this);
+            cardsVBox->layout()->addWidget(w);
+            w->cardName = info.name;
+            w->show();
+        }
+
+        cardWidgets[info.index] = w;
         w->index = info.index;
         is_new = true;
     }
@@ -210,49 +418,24 @@ void MainWindow::updateCard(const pa_card_info &info) {
     setIconByName(w->iconImage, icon, "audio-card");
 
     w->hasSinks = w->hasSources = false;
-    profile_priorities.clear();
-    for (pa_card_profile_info2 ** p_profile = info.profiles2; p_profile && *p_profile != nullptr; ++p_profile) {
-        w->hasSinks = w->hasSinks || ((*p_profile)->n_sinks > 0);
-        w->hasSources = w->hasSources || ((*p_profile)->n_sources > 0);
-        profile_priorities.insert(*p_profile);
+    for (uint32_t i = 0; i < info.n_profiles; ++i) {
+        w->hasSinks = w->hasSinks || (info.profiles2[i]->n_sinks > 0);
+        w->hasSources = w->hasSources || (info.profiles2[i]->n_sources > 0);
+        profile_priorities.push_back(i);
     }
 
-    w->ports.clear();
-    for (uint32_t i = 0; i < info.n_ports; ++i) {
-        PortInfo p;
-
-        p.name = info.ports[i]->name;
-        p.description = info.ports[i]->description;
-        p.priority = info.ports[i]->priority;
-        p.available = info.ports[i]->available;
-        p.direction = info.ports[i]->direction;
-        p.latency_offset = info.ports[i]->latency_offset;
-        for (pa_card_profile_info2 ** p_profile = info.ports[i]->profiles2; p_profile && *p_profile != nullptr; ++p_profile)
-            p.profiles.push_back((*p_profile)->name);
-
-        w->ports[p.name] = p;
-    }
+    std::sort(profile_priorities.begin(), profile_priorities.end(), [&info] (uint32_t a, uint32_t b) {
+        return profile_prio_compare()(info.profiles2[a], info.profiles2[b]);
+    });
+
+    w->availability.update(info);
 
     w->profiles.clear();
-    for (auto p_profile : profile_priorities) {
-        bool hasNo = false, hasOther = false;
-        std::map<QByteArray, PortInfo>::iterator portIt;
+    for (uint32_t profile : profile_priorities) {
+        const pa_card_profile_info2 *p_profile = info.profiles2[profile];
         QByteArray desc = p_profile->description;
 
-        for (portIt = w->ports.begin(); portIt != w->ports.end(); portIt++) {
-            PortInfo port = portIt->second;
-
-            if (std::find(port.profiles.begin(), port.profiles.end(), p_profile->name) == port.profiles.end())
-                continue;
-
-            if (port.available == PA_PORT_AVAILABLE_NO)
-                hasNo = true;
-            else {
-                hasOther = true;
-                break;
-            }
-        }
-        if (hasNo && !hasOther)
+        if (w->availability.unplugged(profile))
             desc += tr(" (unplugged)").toUtf8().constData();
 
         if (!p_profile->available)
@@ -265,39 +448,10 @@ void MainWindow::updateCard(const pa_card_info &info) {
 
     w->activeProfile = info.active_profile ? info.active_profile->name : "";
 
-    /* Because the port info for sinks and sources is discontinued we need
-     * to update the port info for them here. */
-    if (w->hasSinks) {
-        std::map<uint32_t, SinkWidget*>::iterator it;
-
-        for (it = sinkWidgets.begin() ; it != sinkWidgets.end(); it++) {
-            SinkWidget *sw = it->second;
-
-            if (sw->card_index == w->index) {
-                sw->updating = true;
-                updatePorts(sw, w->ports);
-                sw->updating = false;
-            }
-        }
-    }
-
-    if (w->hasSources) {
-        std::map<uint32_t, SourceWidget*>::iterator it;
-
-        for (it = sourceWidgets.begin() ; it != sourceWidgets.end(); it++) {
-            SourceWidget *sw = it->second;
-
-            if (sw->card_index == w->index) {
-                sw->updating = true;
-                updatePorts(sw, w->ports);
-                sw->updating = false;
-            }
-        }
-    }
     w->prepareMenu();
 
     if (is_new)
-        updateDeviceVisibility();
+        updateTabVisibility(TAB_CONFIGURATION);
 
     w->updating = false;
 }
@@ -307,40 +461,71 @@ bool MainWindow::updateSink(const pa_sink_info &info) {
     bool is_new = false;
 
     const char *icon;
-    std::map<uint32_t, CardWidget*>::iterator cw;
+    std::map<uint32_t, std::map<QByteArray, PortInfo> >::iterator cp;
     std::set<pa_sink_port_info,sink_port_prio_compare> port_priorities;
 
+    const bool known = sinks.count(info.index);
+    DeviceRecord &r = sinks[info.index];
+    r.name = info.name;
+    r.description = info.description;
+    r.card = info.card;
+    r.monitor_index = info.monitor_source;
+
+    if (sinkInputModel)
+        sinkInputModel->setDeviceName(info.index, QString::fromUtf8(info.description));
+
+    if (!known)
+        updateStreamDeviceButtons();
+
+    if (!isTabBuilt(TAB_OUTPUT_DEVICES))
+        return false;
+
     if (sinkWidgets.count(info.index))
         w = sinkWidgets[info.index];
     else {
-        sinkWidgets[info.index] = w = new SinkWidget(this);
-        w->setChannelMap(info.channel_map, !!(info.flags & PA_SINK_DECIBEL_VOLUME));
-        sinksVBox->layout()->addWidget(w);
+        if (!(w = takeStale(m_staleSinks, info.name, info.channel_map))) {
+            w = new SinkWidget(this);
+            w->setChannelMap(info.channel_map, !!(info.flags & PA_SINK_DECIBEL_VOLUME));
+            sinksVBox->layout()->addWidget(w);
+        }
+
+        sinkWidgets[info.index] = w;
         w->index = info.index;
         w->monitor_index = info.monitor_source;
         is_new = true;
 
         w->setBaseVolume(info.base_volume);
         w->setVolumeMeterVisible(showVolumeMetersCheckButton->isChecked());
+
+        if (get_server_protocol_version() >= 13)
+            monitorStreams->subscribe(w, info.monitor_source, PA_INVALID_INDEX, !!(info.flags & PA_SINK_NETWORK), &w->channelMap);
+
+        /* Measured again from the start after a reconnect */
+        if (w->loudnessShown())
+            w->startLoudness(info.monitor_source);
     }
 
     w->updating = true;
 
-    w->card_index = info.card;
+    setDeviceCard(w, info.card, is_new);
     w->name = info.name;
     w->description = info.description;
     w->type = info.flags & PA_SINK_HARDWARE ? SINK_HARDWARE : SINK_VIRTUAL;
 
-    w->boldNameLabel->setText(QLatin1String(""));
-    gchar *txt = g_markup_printf_escaped("%s", info.description);
-    w->nameLabel->setText(QString::fromUtf8(static_cast<char*>(txt)));
-    w->nameLabel->setToolTip(QString::fromUtf8(info.description));
-    g_free(txt);
+    if (shownChanged(w->shownText, info.description, is_new)) {
+        w->boldNameLabel->setText(QLatin1String(""));
+        gchar *txt = g_markup_printf_escaped("%s", info.description);
+        w->nameLabel->setText(QString::fromUtf8(static_cast<char*>(txt)));
+        w->nameLabel->setToolTip(QString::fromUtf8(info.description));
+        g_free(txt);
+    }
 
     icon = pa_proplist_gets(info.proplist, PA_PROP_DEVICE_ICON_NAME);
-    setIconByName(w->iconImage, icon, "audio-card");
+    if (shownChanged(w->shownIcon, icon, is_new))
+        setIconByName(w->iconImage, icon, "audio-card");
 
-    w->setVolume(info.volume);
+    if (is_new || w->timeout.isActive() || !pa_cvolume_equal(&w->volume, &info.volume))
+        w->setVolume(info.volume);
     w->muteToggleButton->setChecked(info.mute);
 
     w->setDefault(w->name == defaultSinkName);
@@ -350,88 +535,60 @@ bool MainWindow::updateSink(const pa_sink_info &info) {
         port_priorities.insert(*info.ports[i]);
     }
 
+    const std::vector< std::pair<QByteArray,QByteArray> > oldPorts = w->ports;
+    const QByteArray oldActivePort = w->activePort;
+
     w->ports.clear();
     for (const auto & port_prioritie : port_priorities)
         w->ports.push_back(std::pair<QByteArray,QByteArray>(port_prioritie.name, port_prioritie.description));
 
     w->activePort = info.active_port ? info.active_port->name : "";
 
-    cw = cardWidgets.find(info.card);
+    cp = cardPorts.find(info.card);
 
-    if (cw != cardWidgets.end())
-        updatePorts(w, cw->second->ports);
+    if (cp != cardPorts.end())
+        updatePorts(w, cp->second);
 
 #ifdef PA_SINK_SET_FORMATS
     w->setDigital(info.flags & PA_SINK_SET_FORMATS);
 #endif
 
-    w->prepareMenu();
+    /* Rebuilding the port list is the most expensive part, most updates are
+     * volume changes */
+    if (is_new || w->ports != oldPorts || w->activePort != oldActivePort)
+        w->prepareMenu();
 
     w->updating = false;
-    if (is_new)
-        updateDeviceVisibility();
-
-    return is_new;
-}
-
-static void suspended_callback(pa_stream *s, void *userdata) {
-    MainWindow *w = static_cast<MainWindow*>(userdata);
-
-    if (pa_stream_is_suspended(s))
-        w->updateVolumeMeter(pa_stream_get_device_index(s), PA_INVALID_INDEX, -1);
-}
-
-static void read_callback(pa_stream *s, size_t length, void *userdata) {
-    MainWindow *w = static_cast<MainWindow*>(userdata);
-    const void *data;
-    double v;
-
-    if (pa_stream_peek(s, &data, &length) < 0) {
-        show_error(MainWindow::tr("Failed to read data from stream").toUtf8().constData());
-        return;
-    }
-
-    if (!data) {
-        /* nullptr data means either a hole or empty buffer.
-         * Only drop the stream when there is a hole (length > 0) */
-        if (length)
-            pa_stream_drop(s);
-        return;
-    }
-
-    assert(length > 0);
-    assert(length % sizeof(float) == 0);
-
-    v = ((const float*) data)[length / sizeof(float) -1];
 
-    pa_stream_drop(s);
+    applyFilter(w, filterAccepts(w), TAB_OUTPUT_DEVICES, is_new);
 
-    if (v < 0)
-        v = 0;
-    if (v > 1)
-        v = 1;
-
-    w->updateVolumeMeter(pa_stream_get_device_index(s), pa_stream_get_monitor_stream(s), v);
+    return is_new;
 }
 
-pa_stream* MainWindow::createMonitorStreamForSource(uint32_t source_idx, uint32_t stream_idx = -1, bool suspend = false) {
+pa_stream* MainWindow::createMonitorStreamForSource(uint32_t source_idx, uint32_t stream_idx, bool suspend, uint32_t rate, uint32_t samples,
+                                                    const pa_channel_map *map, pa_stream_request_cb_t read_cb,
+                                                    pa_stream_notify_cb_t suspended_cb, void *userdata) {
     pa_stream *s;
     char t[16];
     pa_buffer_attr attr;
     pa_sample_spec ss;
     pa_stream_flags_t flags;
 
-    ss.channels = 1;
+    ss.channels = map ? map->channels : 1;
     ss.format = PA_SAMPLE_FLOAT32;
-    ss.rate = 25;
+    ss.rate = rate;
 
     memset(&attr, 0, sizeof(attr));
-    attr.fragsize = sizeof(float);
+    attr.fragsize = samples * ss.channels * sizeof(float);
     attr.maxlength = (uint32_t) -1;
 
+    /* Replaying a trace, there is no server to read peaks from */
+    if (!get_context())
+        return nullptr;
+
     snprintf(t, sizeof(t), "%u", source_idx);
 
-    if (!(s = pa_stream_new(get_context(), tr("Peak detect").toUtf8().constData(), &ss, nullptr))) {
+    if (!(s = pa_stream_new(get_context(), tr("Peak detect").toUtf8().constData(), &ss, map))) {
         show_error(tr("Failed to create monitoring stream").toUtf8().constData());
         return nullptr;
     }
@@ -439,12 +596,13 @@ pa_stream* MainWindow::createMonitorStreamForSource(uint32_t source_idx, uint32_
     if (stream_idx != (uint32_t) -1)
         pa_stream_set_monitor_stream(s, stream_idx);
 
-    pa_stream_set_read_callback(s, read_callback, this);
-    pa_stream_set_suspended_callback(s, suspended_callback, this);
+    pa_stream_set_read_callback(s, read_cb, userdata);
+    pa_stream_set_suspended_callback(s, suspended_cb, userdata);
 
+    /* The meter scheduler uncorks it once its meter is on screen */
     flags = (pa_stream_flags_t) (PA_STREAM_DONT_MOVE | PA_STREAM_PEAK_DETECT | PA_STREAM_ADJUST_LATENCY |
                                  (suspend ? PA_STREAM_DONT_INHIBIT_AUTO_SUSPEND : PA_STREAM_NOFLAGS) |
-                                 (!showVolumeMetersCheckButton->isChecked() ? PA_STREAM_START_CORKED : PA_STREAM_NOFLAGS));
+                                 PA_STREAM_START_CORKED);
 
     if (pa_stream_connect_record(s, t, &attr, flags) < 0) {
         show_error(tr("Failed to connect monitoring stream").toUtf8().constData());
@@ -455,58 +613,82 @@ pa_stream* MainWindow::createMonitorStreamForSource(uint32_t source_idx, uint32_
 }
 
 void MainWindow::createMonitorStreamForSinkInput(SinkInputWidget* w, uint32_t sink_idx) {
-    if (!sinkWidgets.count(sink_idx))
+    if (!sinks.count(sink_idx)) {
+        monitorStreams->unsubscribe(w);
         return;
-
-    if (w->peak) {
-        pa_stream_disconnect(w->peak);
-        w->peak = nullptr;
     }
 
-    w->peak = createMonitorStreamForSource(sinkWidgets[sink_idx]->monitor_index, w->index);
+    monitorStreams->subscribe(w, sinks[sink_idx].monitor_index, w->index);
+
+    /* The loudness stream does not follow the sink input either */
+    if (w->loudnessShown())
+        w->startLoudness(sinks[sink_idx].monitor_index, w->index);
 }
 
 void MainWindow::updateSource(const pa_source_info &info) {
     SourceWidget *w;
     bool is_new = false;
     const char *icon;
-    std::map<uint32_t, CardWidget*>::iterator cw;
+    std::map<uint32_t, std::map<QByteArray, PortInfo> >::iterator cp;
     std::set<pa_source_port_info,source_port_prio_compare> port_priorities;
 
+    const bool known = sources.count(info.index);
+    DeviceRecord &r = sources[info.index];
+    r.name = info.name;
+    r.description = info.description;
+    r.card = info.card;
+    r.monitor_index = PA_INVALID_INDEX;
+
+    if (sourceOutputModel)
+        sourceOutputModel->setDeviceName(info.index, QString::fromUtf8(info.description));
+
+    if (!known)
+        updateStreamDeviceButtons();
+
+    if (!isTabBuilt(TAB_INPUT_DEVICES))
+        return;
+
     if (sourceWidgets.count(info.index))
         w = sourceWidgets[info.index];
     else {
-        sourceWidgets[info.index] = w = new SourceWidget(this);
-        w->setChannelMap(info.channel_map, !!(info.flags & PA_SOURCE_DECIBEL_VOLUME));
-        sourcesVBox->layout()->addWidget(w);
+        if (!(w = takeStale(m_staleSources, info.name, info.channel_map))) {
+            w = new SourceWidget(this);
+            w->setChannelMap(info.channel_map, !!(info.flags & PA_SOURCE_DECIBEL_VOLUME));
+            sourcesVBox->layout()->addWidget(w);
+        }
 
+        sourceWidgets[info.index] = w;
         w->index = info.index;
         is_new = true;
 
         w->setBaseVolume(info.base_volume);
         w->setVolumeMeterVisible(showVolumeMetersCheckButton->isChecked());
 
-        if (pa_context_get_server_protocol_version(get_context()) >= 13)
-            w->peak = createMonitorStreamForSource(info.index, -1, !!(info.flags & PA_SOURCE_NETWORK));
+        if (get_server_protocol_version() >= 13)
+            monitorStreams->subscribe(w, info.index, PA_INVALID_INDEX, !!(info.flags & PA_SOURCE_NETWORK), &w->channelMap);
     }
 
     w->updating = true;
 
-    w->card_index = info.card;
+    setDeviceCard(w, info.card, is_new);
     w->name = info.name;
     w->description = info.description;
     w->type = info.monitor_of_sink != PA_INVALID_INDEX ? SOURCE_MONITOR : (info.flags & PA_SOURCE_HARDWARE ? SOURCE_HARDWARE : SOURCE_VIRTUAL);
 
-    w->boldNameLabel->setText(QLatin1String(""));
-    gchar *txt = g_markup_printf_escaped("%s", info.description);
-    w->nameLabel->setText(QString::fromUtf8(static_cast<char*>(txt)));
-    w->nameLabel->setToolTip(QString::fromUtf8(info.description));
-    g_free(txt);
+    if (shownChanged(w->shownText, info.description, is_new)) {
+        w->boldNameLabel->setText(QLatin1String(""));
+        gchar *txt = g_markup_printf_escaped("%s", info.description);
+        w->nameLabel->setText(QString::fromUtf8(static_cast<char*>(txt)));
+        w->nameLabel->setToolTip(QString::fromUtf8(info.description));
+        g_free(txt);
+    }
 
     icon = pa_proplist_gets(info.proplist, PA_PROP_DEVICE_ICON_NAME);
-    setIconByName(w->iconImage, icon, "audio-input-microphone");
+    if (shownChanged(w->shownIcon, icon, is_new))
+        setIconByName(w->iconImage, icon, "audio-input-microphone");
 
-    w->setVolume(info.volume);
+    if (is_new || w->timeout.isActive() || !pa_cvolume_equal(&w->volume, &info.volume))
+        w->setVolume(info.volume);
     w->muteToggleButton->setChecked(info.mute);
 
     w->setDefault(w->name == defaultSourceName);
@@ -516,6 +698,8 @@ void MainWindow::updateSource(const pa_source_info &info) {
         port_priorities.insert(*info.ports[i]);
     }
 
+    const std::vector< std::pair<QByteArray,QByteArray> > oldPorts = w->ports;
+    const QByteArray oldActivePort = w->activePort;
 
     w->ports.clear();
     for (const auto & port_prioritie : port_priorities)
@@ -523,21 +707,21 @@ void MainWindow::updateSource(const pa_source_info &info) {
 
     w->activePort = info.active_port ? info.active_port->name : "";
 
-    cw = cardWidgets.find(info.card);
+    cp = cardPorts.find(info.card);
 
-    if (cw != cardWidgets.end())
-        updatePorts(w, cw->second->ports);
+    if (cp != cardPorts.end())
+        updatePorts(w, cp->second);
 
-    w->prepareMenu();
+    if (is_new || w->ports != oldPorts || w->activePort != oldActivePort)
+        w->prepareMenu();
 
     w->updating = false;
 
-    if (is_new)
-        updateDeviceVisibility();
+    applyFilter(w, filterAccepts(w), TAB_INPUT_DEVICES, is_new);
 }
 
 
-void MainWindow::setIconFromProplist(QLabel *icon, pa_proplist *l, const char *def) {
+const char *MainWindow::iconNameFromProplist(pa_proplist *l, const char *def) {
     const char *t;
 
     if ((t = pa_proplist_gets(l, PA_PROP_MEDIA_ICON_NAME)))
@@ -575,12 +759,16 @@ void MainWindow::setIconFromProplist(QLabel *icon, pa_proplist *l, const char *d
 
 finish:
 
-    setIconByName(icon, t, def);
+    return t;
+}
+
+void MainWindow::setIconFromProplist(QLabel *icon, pa_proplist *l, const char *def) {
+    setIconByName(icon, iconNameFromProplist(l, def), def);
 }
 
 
 void MainWindow::updateSinkInput(const pa_sink_input_info &info) {
-    const char *t;
+    const char *t, *icon;
     SinkInputWidget *w;
     bool is_new = false;
 
@@ -591,22 +779,58 @@ void MainWindow::updateSinkInput(const pa_sink_input_info &info) {
         }
     }
 
+    if (sinkInputModel) {
+        StreamListModel::Entry e;
+
+        e.index = info.index;
+        e.client = info.client;
+        e.device = info.sink;
+        e.type = info.client != PA_INVALID_INDEX ? SINK_INPUT_CLIENT : SINK_INPUT_VIRTUAL;
+        e.name = QString::fromUtf8(info.name);
+        e.clientName = knownClient(info.client) ? QString::fromUtf8(knownClient(info.client)->name) : QString();
+        e.deviceName = sinks.count(info.sink) ? QString::fromUtf8(sinks[info.sink].description) : tr("Unknown output");
+        e.icon = iconByName(iconNameFromProplist(info.proplist, "audio-card"), "audio-card");
+        e.volume = info.volume;
+        e.mute = info.mute;
+        e.hasVolume = true;
+
+        const int rows = sinkInputFilter->rowCount();
+        sinkInputModel->update(e);
+        if (sinkInputFilter->rowCount() != rows)
+            updateTabVisibility(TAB_PLAYBACK);
+        return;
+    }
+
+    sinkInputIndexes.insert(info.index);
+
+    if (!isTabBuilt(TAB_PLAYBACK))
+        return;
+
     if (sinkInputWidgets.count(info.index)) {
         w = sinkInputWidgets[info.index];
-        if (pa_context_get_server_protocol_version(get_context()) >= 13)
+        if (get_server_protocol_version() >= 13)
             if (w->sinkIndex() != info.sink)
                 createMonitorStreamForSinkInput(w, info.sink);
     } else {
-        sinkInputWidgets[info.index] = w = new SinkInputWidget(this);
-        w->setChannelMap(info.channel_map, true);
-        streamsVBox->layout()->addWidget(w);
+        const QByteArray key = streamReconnectKey(info.proplist, info.name);
 
+        if (!(w = takeStale(m_staleSinkInputs, key, info.channel_map))) {
+            w = new SinkInputWidget(this);
+            w->setChannelMap(info.channel_map, true);
+            streamsVBox->layout()->addWidget(w);
+        }
+
+        sinkInputWidgets[info.index] = w;
         w->index = info.index;
         w->clientIndex = info.client;
+        if (info.client != PA_INVALID_INDEX)
+            clients[info.client].sinkInputs.insert(w);
         is_new = true;
         w->setVolumeMeterVisible(showVolumeMetersCheckButton->isChecked());
+        w->directionLabel->setVisible(m_multipleSinks);
+        w->deviceButton->setVisible(m_multipleSinks);
 
-        if (pa_context_get_server_protocol_version(get_context()) >= 13)
+        if (get_server_protocol_version() >= 13)
             createMonitorStreamForSinkInput(w, info.sink);
     }
 
@@ -616,33 +840,29 @@ void MainWindow::updateSinkInput(const pa_sink_input_info &info) {
 
     w->setSinkIndex(info.sink);
 
-    char *txt;
-    if (clientNames.count(info.client)) {
-        w->boldNameLabel->setText(QString::fromUtf8(txt = g_markup_printf_escaped("<b>%s</b>", clientNames[info.client])));
-        g_free(txt);
-        w->nameLabel->setText(QString::fromUtf8(txt = g_markup_printf_escaped(": %s", info.name)));
-        g_free(txt);
-    } else {
-        w->boldNameLabel->setText(QLatin1String(""));
-        w->nameLabel->setText(QString::fromUtf8(info.name));
+    const ClientRecord *client = knownClient(info.client);
+    const bool titleChanged = shownChanged(w->shownTitle, client ? client->name.constData() : nullptr, is_new);
+    if (shownChanged(w->shownText, info.name, titleChanged)) {
+        w->reconnectKey = streamReconnectKey(info.proplist, info.name);
+        setStreamTitle(w, client);
     }
 
-    w->nameLabel->setToolTip(QString::fromUtf8(info.name));
-
-    setIconFromProplist(w->iconImage, info.proplist, "audio-card");
+    icon = iconNameFromProplist(info.proplist, "audio-card");
+    if (shownChanged(w->shownIcon, icon, is_new))
+        setIconByName(w->iconImage, icon, "audio-card");
 
-    w->setVolume(info.volume);
+    if (is_new || w->timeout.isActive() || !pa_cvolume_equal(&w->volume, &info.volume))
+        w->setVolume(info.volume);
     w->muteToggleButton->setChecked(info.mute);
 
     w->updating = false;
 
-    if (is_new)
-        updateDeviceVisibility();
+    applyFilter(w, filterAccepts(w), TAB_PLAYBACK, is_new);
 }
 
 void MainWindow::updateSourceOutput(const pa_source_output_info &info) {
     SourceOutputWidget *w;
-    const char *app;
+    const char *app, *icon;
     bool is_new = false;
 
     if ((app = pa_proplist_gets(info.proplist, PA_PROP_APPLICATION_ID)))
@@ -651,68 +871,164 @@ void MainWindow::updateSourceOutput(const pa_source_output_info &info) {
             || strcmp(app, "org.kde.kmixd") == 0)
             return;
 
+    if (sourceOutputModel) {
+        StreamListModel::Entry e;
+
+        e.index = info.index;
+        e.client = info.client;
+        e.device = info.source;
+        e.type = info.client != PA_INVALID_INDEX ? SOURCE_OUTPUT_CLIENT : SOURCE_OUTPUT_VIRTUAL;
+        e.name = QString::fromUtf8(info.name);
+        e.clientName = knownClient(info.client) ? QString::fromUtf8(knownClient(info.client)->name) : QString();
+        e.deviceName = sources.count(info.source) ? QString::fromUtf8(sources[info.source].description) : tr("Unknown input");
+        e.icon = iconByName(iconNameFromProplist(info.proplist, "audio-input-microphone"), "audio-input-microphone");
+#if HAVE_SOURCE_OUTPUT_VOLUMES
+        e.volume = info.volume;
+        e.mute = info.mute;
+        e.hasVolume = true;
+#else
+        pa_cvolume_init(&e.volume);
+        e.mute = false;
+        e.hasVolume = false;
+#endif
+
+        const int rows = sourceOutputFilter->rowCount();
+        sourceOutputModel->update(e);
+        if (sourceOutputFilter->rowCount() != rows)
+            updateTabVisibility(TAB_RECORDING);
+        return;
+    }
+
+    sourceOutputIndexes.insert(info.index);
+
+    if (!isTabBuilt(TAB_RECORDING))
+        return;
+
     if (sourceOutputWidgets.count(info.index))
         w = sourceOutputWidgets[info.index];
     else {
-        sourceOutputWidgets[info.index] = w = new SourceOutputWidget(this);
+        const QByteArray key = streamReconnectKey(info.proplist, info.name);
+
+#if HAVE_SOURCE_OUTPUT_VOLUMES
+        if (!(w = takeStale(m_staleSourceOutputs, key, info.channel_map))) {
+#else
+        auto stale = m_staleSourceOutputs.find(key);
+        if (stale != m_staleSourceOutputs.end()) {
+            w = stale->second;
+            m_staleSourceOutputs.erase(stale);
+        } else {
+#endif
+            w = new SourceOutputWidget(this);
 #if HAVE_SOURCE_OUTPUT_VOLUMES
-        w->setChannelMap(info.channel_map, true);
+            w->setChannelMap(info.channel_map, true);
 #endif
-        recsVBox->layout()->addWidget(w);
+            recsVBox->layout()->addWidget(w);
+        }
 
+        sourceOutputWidgets[info.index] = w;
         w->index = info.index;
         w->clientIndex = info.client;
+        if (info.client != PA_INVALID_INDEX)
+            clients[info.client].sourceOutputs.insert(w);
         is_new = true;
         w->setVolumeMeterVisible(showVolumeMetersCheckButton->isChecked());
+        w->directionLabel->setVisible(m_multipleSources);
+        w->deviceButton->setVisible(m_multipleSources);
     }
 
     w->updating = true;
 
     w->type = info.client != PA_INVALID_INDEX ? SOURCE_OUTPUT_CLIENT : SOURCE_OUTPUT_VIRTUAL;
 
+    if (is_new || w->sourceIndex() != info.source)
+        if (get_server_protocol_version() >= 13)
+            monitorStreams->subscribe(w, info.source);
+
     w->setSourceIndex(info.source);
 
-    char *txt;
-    if (clientNames.count(info.client)) {
-        w->boldNameLabel->setText(QString::fromUtf8(txt = g_markup_printf_escaped("<b>%s</b>", clientNames[info.client])));
-        g_free(txt);
-        w->nameLabel->setText(QString::fromUtf8(txt = g_markup_printf_escaped(": %s", info.name)));
-        g_free(txt);
-    } else {
-        w->boldNameLabel->setText(QLatin1String(""));
-        w->nameLabel->setText(QString::fromUtf8(info.name));
+    const ClientRecord *client = knownClient(info.client);
+    const bool titleChanged = shownChanged(w->shownTitle, client ? client->name.constData() : nullptr, is_new);
+    if (shownChanged(w->shownText, info.name, titleChanged)) {
+        w->reconnectKey = streamReconnectKey(info.proplist, info.name);
+        setStreamTitle(w, client);
     }
 
-    w->nameLabel->setToolTip(QString::fromUtf8(info.name));
-
-    setIconFromProplist(w->iconImage, info.proplist, "audio-input-microphone");
+    icon = iconNameFromProplist(info.proplist, "audio-input-microphone");
+    if (shownChanged(w->shownIcon, icon, is_new))
+        setIconByName(w->iconImage, icon, "audio-input-microphone");
 
 #if HAVE_SOURCE_OUTPUT_VOLUMES
-    w->setVolume(info.volume);
+    if (is_new || w->timeout.isActive() || !pa_cvolume_equal(&w->volume, &info.volume))
+        w->setVolume(info.volume);
     w->muteToggleButton->setChecked(info.mute);
 #endif
 
     w->updating = false;
 
-    if (is_new)
-        updateDeviceVisibility();
+    applyFilter(w, filterAccepts(w), TAB_RECORDING, is_new);
+}
+
+void MainWindow::setDeviceCard(DeviceWidget *w, uint32_t card, bool is_new) {
+    if (!is_new) {
+        if (w->card_index == card)
+            return;
+        forgetDeviceCard(w);
+    }
+
+    w->card_index = card;
+    if (card != PA_INVALID_INDEX)
+        cardDevices[card].insert(w);
+}
+
+void MainWindow::forgetDeviceCard(DeviceWidget *w) {
+    auto devices = cardDevices.find(w->card_index);
+
+    if (devices == cardDevices.end())
+        return;
+
+    devices->second.erase(w);
+    if (devices->second.empty())
+        cardDevices.erase(devices);
+}
+
+const ClientRecord *MainWindow::knownClient(uint32_t index) const {
+    auto c = clients.find(index);
+
+    return c != clients.end() && !c->second.name.isNull() ? &c->second : nullptr;
 }
 
 void MainWindow::updateClient(const pa_client_info &info) {
-    g_free(clientNames[info.index]);
-    clientNames[info.index] = g_strdup(info.name);
+    ClientRecord &c = clients[info.index];
 
-    for (auto & sinkInputWidget : sinkInputWidgets) {
-        SinkInputWidget *w = sinkInputWidget.second;
+    if (!c.name.isNull() && c.name == info.name)
+        return;
 
-        if (!w)
-            continue;
+    const bool known = !c.name.isNull();
+    gchar *txt = g_markup_printf_escaped("<b>%s</b>", info.name);
+    c.name = info.name;
+    c.markup = QString::fromUtf8(txt);
+    g_free(txt);
 
-        if (w->clientIndex == info.index) {
-            gchar *txt;
-            w->boldNameLabel->setText(QString::fromUtf8(txt = g_markup_printf_escaped("<b>%s</b>", info.name)));
-            g_free(txt);
-        }
+    if (sinkInputModel)
+        sinkInputModel->setClientName(info.index, QString::fromUtf8(info.name));
+    if (sourceOutputModel)
+        sourceOutputModel->setClientName(info.index, QString::fromUtf8(info.name));
+
+    /* Once the client is known only its part of the labels changes */
+    for (SinkInputWidget *w : c.sinkInputs) {
+        shownChanged(w->shownTitle, info.name, true);
+        if (known)
+            w->boldNameLabel->setText(c.markup);
+        else
+            setStreamTitle(w, &c);
+    }
+
+    for (SourceOutputWidget *w : c.sourceOutputs) {
+        shownChanged(w->shownTitle, info.name, true);
+        if (known)
+            w->boldNameLabel->setText(c.markup);
+        else
+            setStreamTitle(w, &c);
     }
 }
 
@@ -753,7 +1069,10 @@ bool MainWindow::createEventRoleWidget() {
     };
 
     eventRoleWidget = new RoleWidget(this);
-    streamsVBox->layout()->addWidget(eventRoleWidget);
+    if (sinkInputView)
+        static_cast<QBoxLayout*>(sinkInputView->parentWidget()->layout())->insertWidget(0, eventRoleWidget);
+    else
+        streamsVBox->layout()->addWidget(eventRoleWidget);
     eventRoleWidget->role = "sink-input-by-media-role:event";
     eventRoleWidget->setChannelMap(cm, true);
 
@@ -774,22 +1093,27 @@ bool MainWindow::createEventRoleWidget() {
     eventRoleWidget->muteToggleButton->setChecked(false);
 
     eventRoleWidget->updating = false;
+
+    updateTabVisibility(TAB_PLAYBACK);
     return TRUE;
 }
 
 void MainWindow::deleteEventRoleWidget() {
+    if (!eventRoleWidget)
+        return;
+
     delete eventRoleWidget;
     eventRoleWidget = nullptr;
+    updateTabVisibility(TAB_PLAYBACK);
 }
 
 void MainWindow::updateRole(const pa_ext_stream_restore_info &info) {
     pa_cvolume volume;
-    bool is_new = false;
 
     if (strcmp(info.name, "sink-input-by-media-role:event") != 0)
         return;
 
-    is_new = createEventRoleWidget();
+    createEventRoleWidget();
 
     eventRoleWidget->updating = true;
 
@@ -802,9 +1126,6 @@ void MainWindow::updateRole(const pa_ext_stream_restore_info &info) {
     eventRoleWidget->muteToggleButton->setChecked(info.mute);
 
     eventRoleWidget->updating = false;
-
-    if (is_new)
-        updateDeviceVisibility();
 }
 
 #if HAVE_EXT_DEVICE_RESTORE_API
@@ -838,40 +1159,6 @@ void MainWindow::updateDeviceInfo(const pa_ext_device_restore_info &info) {
 #endif
 
 
-void MainWindow::updateVolumeMeter(uint32_t source_index, uint32_t sink_input_idx, double v) {
-    if (sink_input_idx != PA_INVALID_INDEX) {
-        SinkInputWidget *w;
-
-        if (sinkInputWidgets.count(sink_input_idx)) {
-            w = sinkInputWidgets[sink_input_idx];
-            w->updatePeak(v);
-        }
-
-    } else {
-
-        for (auto & sinkWidget : sinkWidgets) {
-            SinkWidget* w = sinkWidget.second;
-
-            if (w->monitor_index == source_index)
-                w->updatePeak(v);
-        }
-
-        for (auto & sourceWidget : sourceWidgets) {
-            SourceWidget* w = sourceWidget.second;
-
-            if (w->index == source_index)
-                w->updatePeak(v);
-        }
-
-        for (auto & sourceOutputWidget : sourceOutputWidgets) {
-            SourceOutputWidget* w = sourceOutputWidget.second;
-
-            if (w->sourceIndex() == source_index)
-                w->updatePeak(v);
-        }
-    }
-}
-
 static guint idle_source = 0;
 
 gboolean idle_cb(gpointer data) {
@@ -885,15 +1172,25 @@ void MainWindow::setConnectionState(gboolean connected) {
         m_connected = connected;
         if (m_connected) {
             connectingLabel->hide();
+            notebook->setEnabled(true);
             notebook->show();
         } else {
-            notebook->hide();
+            /* Whatever was shown stays, out of reach, until reconnected */
+            notebook->setEnabled(false);
             connectingLabel->show();
         }
     }
 }
 
 void MainWindow::updateDeviceVisibility() {
+    for (int tab = TAB_PLAYBACK; tab <= TAB_CONFIGURATION; tab++)
+        refilterTab(tab);
+
+    updateStreamDeviceButtons(true);
+}
+
+void MainWindow::updateTabVisibility(int tab) {
+    m_dirtyTabs |= 1u << tab;
 
     if (idle_source)
         return;
@@ -901,188 +1198,638 @@ void MainWindow::updateDeviceVisibility() {
     idle_source = g_idle_add(idle_cb, this);
 }
 
-void MainWindow::reallyUpdateDeviceVisibility() {
-    bool is_empty = true;
-
-    for (auto & sinkInputWidget : sinkInputWidgets) {
-        SinkInputWidget* w = sinkInputWidget.second;
+bool MainWindow::filterAccepts(const SinkInputWidget *w) const {
+    return showSinkInputType == SINK_INPUT_ALL || w->type == showSinkInputType;
+}
 
-        if (sinkWidgets.size() > 1) {
-            w->directionLabel->show();
-            w->deviceButton->show();
-        } else {
-            w->directionLabel->hide();
-            w->deviceButton->hide();
-        }
+bool MainWindow::filterAccepts(const SourceOutputWidget *w) const {
+    return showSourceOutputType == SOURCE_OUTPUT_ALL || w->type == showSourceOutputType;
+}
 
-        if (showSinkInputType == SINK_INPUT_ALL || w->type == showSinkInputType) {
-            w->show();
-            is_empty = false;
-        } else
-            w->hide();
-    }
+bool MainWindow::filterAccepts(const SinkWidget *w) const {
+    return showSinkType == SINK_ALL || w->type == showSinkType;
+}
 
-    if (eventRoleWidget)
-        is_empty = false;
+bool MainWindow::filterAccepts(const SourceWidget *w) const {
+    return showSourceType == SOURCE_ALL ||
+        w->type == showSourceType ||
+        (showSourceType == SOURCE_NO_MONITOR && w->type != SOURCE_MONITOR);
+}
 
-    if (is_empty)
-        noStreamsLabel->show();
-    else
-        noStreamsLabel->hide();
+void MainWindow::applyFilter(MinimalStreamWidget *w, bool accepted, int tab, bool force) {
+    if (w->filterAccepted != accepted) {
+        if (accepted)
+            m_shownWidgets[tab]++;
+        else
+            m_shownWidgets[tab]--;
+    } else if (!force)
+        return;
 
-    is_empty = true;
+    w->filterAccepted = accepted;
+    w->setVisible(accepted);
+    updateTabVisibility(tab);
+    monitorStreams->scheduleUpdate();
+}
 
-    for (auto & sourceOutputWidget : sourceOutputWidgets) {
-        SourceOutputWidget* w = sourceOutputWidget.second;
+void MainWindow::forgetFiltered(MinimalStreamWidget *w, int tab) {
+    if (w->filterAccepted)
+        m_shownWidgets[tab]--;
 
-        if (sourceWidgets.size() > 1) {
-            w->directionLabel->show();
-            w->deviceButton->show();
-        } else {
-            w->directionLabel->hide();
-            w->deviceButton->hide();
-        }
+    updateTabVisibility(tab);
+}
 
-        if (showSourceOutputType == SOURCE_OUTPUT_ALL || w->type == showSourceOutputType) {
-            w->show();
-            is_empty = false;
-        } else
-            w->hide();
+void MainWindow::refilterTab(int tab) {
+    switch (tab) {
+        case TAB_PLAYBACK:
+            for (auto & sinkInputWidget : sinkInputWidgets)
+                applyFilter(sinkInputWidget.second, filterAccepts(sinkInputWidget.second), tab);
+            if (sinkInputFilter)
+                sinkInputFilter->setFilterFixedString(showSinkInputType == SINK_INPUT_ALL ? QString() : QString::number(showSinkInputType));
+            break;
+
+        case TAB_RECORDING:
+            for (auto & sourceOutputWidget : sourceOutputWidgets)
+                applyFilter(sourceOutputWidget.second, filterAccepts(sourceOutputWidget.second), tab);
+            if (sourceOutputFilter)
+                sourceOutputFilter->setFilterFixedString(showSourceOutputType == SOURCE_OUTPUT_ALL ? QString() : QString::number(showSourceOutputType));
+            break;
+
+        case TAB_OUTPUT_DEVICES:
+            for (auto & sinkWidget : sinkWidgets)
+                applyFilter(sinkWidget.second, filterAccepts(sinkWidget.second), tab);
+            break;
+
+        case TAB_INPUT_DEVICES:
+            for (auto & sourceWidget : sourceWidgets)
+                applyFilter(sourceWidget.second, filterAccepts(sourceWidget.second), tab);
+            break;
     }
 
-    if (is_empty)
-        noRecsLabel->show();
-    else
-        noRecsLabel->hide();
+    updateTabVisibility(tab);
+}
 
-    is_empty = true;
+void MainWindow::updateStreamDeviceButtons(bool force) {
+    const bool multipleSinks = sinks.size() > 1;
+    const bool multipleSources = sources.size() > 1;
 
-    for (auto & sinkWidget : sinkWidgets) {
-        SinkWidget* w = sinkWidget.second;
+    /* Only crossing from one device to more changes anything */
+    if (force || multipleSinks != m_multipleSinks) {
+        m_multipleSinks = multipleSinks;
 
-        if (showSinkType == SINK_ALL || w->type == showSinkType) {
-            w->show();
-            is_empty = false;
-        } else
-            w->hide();
+        for (auto & sinkInputWidget : sinkInputWidgets) {
+            sinkInputWidget.second->directionLabel->setVisible(multipleSinks);
+            sinkInputWidget.second->deviceButton->setVisible(multipleSinks);
+        }
     }
 
-    if (is_empty)
-        noSinksLabel->show();
-    else
-        noSinksLabel->hide();
+    if (force || multipleSources != m_multipleSources) {
+        m_multipleSources = multipleSources;
+
+        for (auto & sourceOutputWidget : sourceOutputWidgets) {
+            sourceOutputWidget.second->directionLabel->setVisible(multipleSources);
+            sourceOutputWidget.second->deviceButton->setVisible(multipleSources);
+        }
+    }
+}
 
-    is_empty = true;
+/* Hmm, if I don't call hide()/show() here some widgets will never
+ * get their proper space allocated */
+static void relayout(QWidget *box) {
+    box->hide();
+    box->show();
+}
 
-    for (auto & cardWidget : cardWidgets) {
-        CardWidget* w = cardWidget.second;
+void MainWindow::reallyUpdateDeviceVisibility() {
+    const unsigned dirty = m_dirtyTabs;
+    bool is_empty;
 
-        w->show();
-        is_empty = false;
+    m_dirtyTabs = 0;
+
+    if (dirty & (1u << TAB_PLAYBACK)) {
+        if (sinkInputFilter)
+            is_empty = sinkInputFilter->rowCount() == 0;
+        else
+            is_empty = m_shownWidgets[TAB_PLAYBACK] == 0;
+
+        noStreamsLabel->setVisible(is_empty && !eventRoleWidget);
+        relayout(streamsVBox);
     }
 
-    if (is_empty)
-        noCardsLabel->show();
-    else
-        noCardsLabel->hide();
+    if (dirty & (1u << TAB_RECORDING)) {
+        if (sourceOutputFilter)
+            is_empty = sourceOutputFilter->rowCount() == 0;
+        else
+            is_empty = m_shownWidgets[TAB_RECORDING] == 0;
 
-    is_empty = true;
+        noRecsLabel->setVisible(is_empty);
+        relayout(recsVBox);
+    }
 
-    for (auto & sourceWidget : sourceWidgets) {
-        SourceWidget* w = sourceWidget.second;
+    if (dirty & (1u << TAB_OUTPUT_DEVICES)) {
+        noSinksLabel->setVisible(m_shownWidgets[TAB_OUTPUT_DEVICES] == 0);
+        relayout(sinksVBox);
+    }
 
-        if (showSourceType == SOURCE_ALL ||
-            w->type == showSourceType ||
-            (showSourceType == SOURCE_NO_MONITOR && w->type != SOURCE_MONITOR)) {
-            w->show();
-            is_empty = false;
-        } else
-            w->hide();
+    if (dirty & (1u << TAB_INPUT_DEVICES)) {
+        noSourcesLabel->setVisible(m_shownWidgets[TAB_INPUT_DEVICES] == 0);
+        relayout(sourcesVBox);
     }
 
-    if (is_empty)
-        noSourcesLabel->show();
-    else
-        noSourcesLabel->hide();
-
-    /* Hmm, if I don't call hide()/show() here some widgets will never
-     * get their proper space allocated */
-    sinksVBox->hide();
-    sinksVBox->show();
-    sourcesVBox->hide();
-    sourcesVBox->show();
-    streamsVBox->hide();
-    streamsVBox->show();
-    recsVBox->hide();
-    recsVBox->show();
-    cardsVBox->hide();
-    cardsVBox->show();
+    if (dirty & (1u << TAB_CONFIGURATION)) {
+        noCardsLabel->setVisible(cardWidgets.empty() && m_staleCards.empty());
+        relayout(cardsVBox);
+    }
 }
 
 void MainWindow::removeCard(uint32_t index) {
+    cardPorts.erase(index);
+
     if (!cardWidgets.count(index))
         return;
 
     delete cardWidgets[index];
     cardWidgets.erase(index);
-    updateDeviceVisibility();
+    updateTabVisibility(TAB_CONFIGURATION);
 }
 
 void MainWindow::removeSink(uint32_t index) {
+    if (sinks.erase(index))
+        updateStreamDeviceButtons();
+
     if (!sinkWidgets.count(index))
         return;
 
+    monitorStreams->unsubscribe(sinkWidgets[index]);
+    forgetDeviceCard(sinkWidgets[index]);
+    forgetFiltered(sinkWidgets[index], TAB_OUTPUT_DEVICES);
     delete sinkWidgets[index];
     sinkWidgets.erase(index);
-    updateDeviceVisibility();
 }
 
 void MainWindow::removeSource(uint32_t index) {
+    if (sources.erase(index))
+        updateStreamDeviceButtons();
+
     if (!sourceWidgets.count(index))
         return;
 
+    monitorStreams->unsubscribe(sourceWidgets[index]);
+    forgetDeviceCard(sourceWidgets[index]);
+    forgetFiltered(sourceWidgets[index], TAB_INPUT_DEVICES);
     delete sourceWidgets[index];
     sourceWidgets.erase(index);
-    updateDeviceVisibility();
 }
 
 void MainWindow::removeSinkInput(uint32_t index) {
+    if (sinkInputModel) {
+        sinkInputModel->remove(index);
+        updateTabVisibility(TAB_PLAYBACK);
+        return;
+    }
+
+    sinkInputIndexes.erase(index);
+
     if (!sinkInputWidgets.count(index))
         return;
 
-    delete sinkInputWidgets[index];
+    SinkInputWidget *w = sinkInputWidgets[index];
+    auto c = clients.find(w->clientIndex);
+    if (c != clients.end())
+        c->second.sinkInputs.erase(w);
+
+    monitorStreams->unsubscribe(w);
+    forgetFiltered(w, TAB_PLAYBACK);
+    delete w;
     sinkInputWidgets.erase(index);
-    updateDeviceVisibility();
 }
 
 void MainWindow::removeSourceOutput(uint32_t index) {
+    if (sourceOutputModel) {
+        sourceOutputModel->remove(index);
+        updateTabVisibility(TAB_RECORDING);
+        return;
+    }
+
+    sourceOutputIndexes.erase(index);
+
     if (!sourceOutputWidgets.count(index))
         return;
 
-    delete sourceOutputWidgets[index];
+    SourceOutputWidget *w = sourceOutputWidgets[index];
+    auto c = clients.find(w->clientIndex);
+    if (c != clients.end())
+        c->second.sourceOutputs.erase(w);
+
+    monitorStreams->unsubscribe(w);
+    forgetFiltered(w, TAB_RECORDING);
+    delete w;
     sourceOutputWidgets.erase(index);
-    updateDeviceVisibility();
 }
 
 void MainWindow::removeClient(uint32_t index) {
-    g_free(clientNames[index]);
-    clientNames.erase(index);
+    clients.erase(index);
 }
 
-void MainWindow::removeAllWidgets() {
+void MainWindow::markWidgetsStale() {
+    /* The lists are cheap to fill again */
+    if (sinkInputModel)
+        sinkInputModel->clear();
+    if (sourceOutputModel)
+        sourceOutputModel->clear();
+
     for (auto & sinkInputWidget : sinkInputWidgets)
-        removeSinkInput(sinkInputWidget.first);
+        m_staleSinkInputs.insert(std::make_pair(sinkInputWidget.second->reconnectKey, sinkInputWidget.second));
     for (auto & sourceOutputWidget : sourceOutputWidgets)
-        removeSourceOutput(sourceOutputWidget.first);
+        m_staleSourceOutputs.insert(std::make_pair(sourceOutputWidget.second->reconnectKey, sourceOutputWidget.second));
     for (auto & sinkWidget : sinkWidgets)
-        removeSink(sinkWidget.first);
+        m_staleSinks.insert(std::make_pair(sinkWidget.second->name, sinkWidget.second));
     for (auto & sourceWidget : sourceWidgets)
-        removeSource(sourceWidget.first);
+        m_staleSources.insert(std::make_pair(sourceWidget.second->name, sourceWidget.second));
     for (auto & cardWidget : cardWidgets)
-       removeCard(cardWidget.first);
-    for (auto & clientName : clientNames)
-        removeClient(clientName.first);
-    deleteEventRoleWidget();
+        m_staleCards.insert(std::make_pair(cardWidget.second->cardName, cardWidget.second));
+
+    sinkInputWidgets.clear();
+    sourceOutputWidgets.clear();
+    sinkWidgets.clear();
+    sourceWidgets.clear();
+    cardWidgets.clear();
+
+    /* Their peak streams went away with the connection */
+    monitorStreams->reset();
+
+    clients.clear();
+
+    sinks.clear();
+    sources.clear();
+    cardPorts.clear();
+    cardDevices.clear();
+    sinkInputIndexes.clear();
+    sourceOutputIndexes.clear();
+}
+
+void MainWindow::removeStaleWidgets() {
+    for (auto & stale : m_staleSinkInputs) {
+        forgetFiltered(stale.second, TAB_PLAYBACK);
+        delete stale.second;
+    }
+    for (auto & stale : m_staleSourceOutputs) {
+        forgetFiltered(stale.second, TAB_RECORDING);
+        delete stale.second;
+    }
+    for (auto & stale : m_staleSinks) {
+        forgetFiltered(stale.second, TAB_OUTPUT_DEVICES);
+        delete stale.second;
+    }
+    for (auto & stale : m_staleSources) {
+        forgetFiltered(stale.second, TAB_INPUT_DEVICES);
+        delete stale.second;
+    }
+    for (auto & stale : m_staleCards)
+        delete stale.second;
+
+    if (!m_staleCards.empty())
+        updateTabVisibility(TAB_CONFIGURATION);
+
+    m_staleSinkInputs.clear();
+    m_staleSourceOutputs.clear();
+    m_staleSinks.clear();
+    m_staleSources.clear();
+    m_staleCards.clear();
+}
+
+bool MainWindow::hasPlaybackStreams() const {
+    return sinkInputModel ? sinkInputModel->rowCount() > 0 : !sinkInputIndexes.empty();
+}
+
+bool MainWindow::hasRecordingStreams() const {
+    return sourceOutputModel ? sourceOutputModel->rowCount() > 0 : !sourceOutputIndexes.empty();
+}
+
+void MainWindow::resetTabs() {
+    /* Only the visible tab is filled by the initial enumeration, the others
+     * are requested again when they are first shown */
+    m_builtTabs = 1u << notebook->currentIndex();
+
+    /* Except for those with widgets waiting to be matched */
+    if (!m_staleSinkInputs.empty())
+        m_builtTabs |= 1u << TAB_PLAYBACK;
+    if (!m_staleSourceOutputs.empty())
+        m_builtTabs |= 1u << TAB_RECORDING;
+    if (!m_staleSinks.empty())
+        m_builtTabs |= 1u << TAB_OUTPUT_DEVICES;
+    if (!m_staleSources.empty())
+        m_builtTabs |= 1u << TAB_INPUT_DEVICES;
+    if (!m_staleCards.empty())
+        m_builtTabs |= 1u << TAB_CONFIGURATION;
+
+    /* The stream lists are cheap, no need to defer them */
+    if (sinkInputModel)
+        m_builtTabs |= (1u << TAB_PLAYBACK) | (1u << TAB_RECORDING);
+}
+
+void MainWindow::markAllTabsBuilt() {
+    m_builtTabs = ~0u;
+}
+
+bool MainWindow::isTabBuilt(int tab) const {
+    return m_builtTabs & (1u << tab);
+}
+
+void MainWindow::onNotebookCurrentChanged(int index) {
+    monitorStreams->scheduleUpdate();
+
+    if (index < 0 || isTabBuilt(index))
+        return;
+
+    if (!get_context() || pa_context_get_state(get_context()) != PA_CONTEXT_READY)
+        return;
+
+    m_builtTabs |= 1u << index;
+    request_tab_contents(this, index);
+}
+
+void MainWindow::createStreamList(QGridLayout *grid, QScrollArea *area, QLabel *emptyLabel, StreamListModel *model,
+                                      QSortFilterProxyModel *&filter, StreamListView *&view, const QString &direction) {
+    QWidget *host = new QWidget(area->parentWidget());
+    QVBoxLayout *layout = new QVBoxLayout(host);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    filter = new QSortFilterProxyModel(this);
+    filter->setSourceModel(model);
+    filter->setFilterRole(StreamListModel::TypeRole);
+
+    view = new StreamListView(host);
+    view->setModel(filter);
+    view->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    static_cast<StreamItemDelegate*>(view->itemDelegate())->directionText = direction;
+
+    /* The empty label moves out of the scroll area, which is not used anymore */
+    layout->addWidget(emptyLabel);
+    layout->addWidget(view, 1);
+
+    grid->removeWidget(area);
+    area->hide();
+    grid->addWidget(host, 0, 0, 1, 2);
+
+    StreamListView *v = view;
+    connect(view, &QWidget::customContextMenuRequested, this, [this, v] (const QPoint &pos) {
+        showStreamListMenu(v, pos);
+    });
+}
+
+void MainWindow::setStreamListMode(bool enabled) {
+    if (!enabled || sinkInputModel)
+        return;
+
+    sinkInputModel = new StreamListModel(StreamListModel::SinkInputs, operations, this);
+    sourceOutputModel = new StreamListModel(StreamListModel::SourceOutputs, operations, this);
+
+    createStreamList(gridLayout, scrollArea, noStreamsLabel, sinkInputModel,
+                     sinkInputFilter, sinkInputView, tr("on"));
+    createStreamList(gridLayout_2, scrollArea_2, noRecsLabel, sourceOutputModel,
+                     sourceOutputFilter, sourceOutputView, tr("from"));
+
+    updateDeviceVisibility();
+}
+
+void MainWindow::showStreamListMenu(StreamListView *view, const QPoint &pos) {
+    const QModelIndex index = view->indexAt(pos);
+
+    if (!index.isValid())
+        return;
+
+    StreamListModel *model = view == sinkInputView ? sinkInputModel : sourceOutputModel;
+    const uint32_t stream = index.data(StreamListModel::IndexRole).toUInt();
+    const uint32_t device = index.data(StreamListModel::DeviceRole).toUInt();
+
+    QMenu menu;
+
+    /* A click outside of the selection only acts on the clicked stream */
+    QItemSelectionModel *selection = view->selectionModel();
+    if (!selection->isSelected(index))
+        selection->select(index, QItemSelectionModel::ClearAndSelect);
+
+    const QModelIndexList rows = selection->selectedIndexes();
+    if (rows.size() > 1) {
+        std::vector<uint32_t> streams;
+        for (const QModelIndex &row : rows)
+            streams.push_back(row.data(StreamListModel::IndexRole).toUInt());
+
+        addBulkActions(&menu, model->kind() == StreamListModel::SinkInputs, streams);
+        menu.exec(view->viewport()->mapToGlobal(pos));
+        return;
+    }
+
+    QMenu *move = menu.addMenu(model->kind() == StreamListModel::SinkInputs ? tr("Move to Output") : tr("Move to Input"));
+
+    auto addDevice = [move, model, stream, device] (uint32_t idx, const QByteArray &description) {
+        QAction *a = move->addAction(QString::fromUtf8(description));
+        a->setCheckable(true);
+        a->setChecked(idx == device);
+        QObject::connect(a, &QAction::triggered, move, [model, stream, idx] {
+            model->moveStream(stream, idx);
+        });
+    };
+
+    /* The device tabs may not have been built yet */
+    for (auto & record : model->kind() == StreamListModel::SinkInputs ? sinks : sources)
+        addDevice(record.first, record.second.description);
+
+    if (model->kind() == StreamListModel::SinkInputs && sinks.count(device)) {
+        const QString title = index.data(Qt::DisplayRole).toString();
+        QAction *spectrum = menu.addAction(tr("Spectrum..."));
+        connect(spectrum, &QAction::triggered, this, [this, stream, device, title] {
+            if (sinks.count(device))
+                showSpectrum(sinks[device].monitor_index, stream, title);
+        });
+    }
+
+    menu.addSeparator();
+    QAction *terminate = menu.addAction(model->kind() == StreamListModel::SinkInputs ? tr("Terminate Playback") : tr("Terminate Recording"));
+    connect(terminate, &QAction::triggered, &menu, [model, stream] {
+        model->killStream(stream);
+    });
+
+    menu.exec(view->viewport()->mapToGlobal(pos));
+}
+
+std::vector<uint32_t> MainWindow::selectedStreams(bool playback) const {
+    std::vector<uint32_t> streams;
+
+    if (playback) {
+        for (auto & sinkInputWidget : sinkInputWidgets)
+            if (sinkInputWidget.second->selected && sinkInputWidget.second->filterAccepted)
+                streams.push_back(sinkInputWidget.first);
+    } else {
+        for (auto & sourceOutputWidget : sourceOutputWidgets)
+            if (sourceOutputWidget.second->selected && sourceOutputWidget.second->filterAccepted)
+                streams.push_back(sourceOutputWidget.first);
+    }
+
+    return streams;
+}
+
+void MainWindow::showSpectrum(uint32_t source_idx, uint32_t stream_idx, const QString &title) {
+    const auto key = std::make_pair(source_idx, stream_idx);
+    auto it = m_spectrumDialogs.find(key);
+
+    if (it != m_spectrumDialogs.end() && it->second) {
+        it->second->raise();
+        it->second->activateWindow();
+        return;
+    }
+
+    SpectrumDialog *d = new SpectrumDialog(title, this);
+    if (!d->monitor(source_idx, stream_idx)) {
+        delete d;
+        return;
+    }
+
+    /* Closed by the user, or by itself once its device or stream is gone */
+    m_spectrumDialogs[key] = d;
+    connect(d, &QObject::destroyed, this, [this, key] { m_spectrumDialogs.erase(key); });
+    d->show();
+}
+
+void MainWindow::showStreamMenu(StreamWidget *w, const QPoint &globalPos) {
+    SinkInputWidget *sinkInput = qobject_cast<SinkInputWidget*>(w);
+    const bool playback = sinkInput != nullptr;
+    const std::vector<uint32_t> streams = selectedStreams(playback);
+
+    QMenu menu;
+    menu.addActions(w->actions());
+
+    if (sinkInput && sinks.count(sinkInput->sinkIndex())) {
+        const uint32_t stream = sinkInput->index;
+        QAction *spectrum = menu.addAction(tr("Spectrum..."));
+        connect(spectrum, &QAction::triggered, this, [this, stream] {
+            /* Looked up again, the menu ran an event loop */
+            auto it = sinkInputWidgets.find(stream);
+            if (it != sinkInputWidgets.end() && sinks.count(it->second->sinkIndex()))
+                showSpectrum(sinks[it->second->sinkIndex()].monitor_index, stream, QString::fromUtf8(it->second->shownText));
+        });
+    }
+
+    QAction *all = menu.addAction(tr("Select All"));
+    connect(all, &QAction::triggered, this, [this, playback] {
+        if (playback) {
+            for (auto & sinkInputWidget : sinkInputWidgets)
+                sinkInputWidget.second->setSelected(sinkInputWidget.second->filterAccepted);
+        } else {
+            for (auto & sourceOutputWidget : sourceOutputWidgets)
+                sourceOutputWidget.second->setSelected(sourceOutputWidget.second->filterAccepted);
+        }
+    });
+
+    if (!streams.empty()) {
+        QAction *none = menu.addAction(tr("Clear Selection"));
+        connect(none, &QAction::triggered, this, [this, playback] {
+            if (playback) {
+                for (auto & sinkInputWidget : sinkInputWidgets)
+                    sinkInputWidget.second->setSelected(false);
+            } else {
+                for (auto & sourceOutputWidget : sourceOutputWidgets)
+                    sourceOutputWidget.second->setSelected(false);
+            }
+        });
+    }
+
+    if (w->selected && streams.size() > 1)
+        addBulkActions(&menu, playback, streams);
+
+    menu.exec(globalPos);
+}
+
+void MainWindow::addBulkActions(QMenu *menu, bool playback, const std::vector<uint32_t> &streams) {
+    const QString type = playback ? QStringLiteral("sink_input") : QStringLiteral("source_output");
+
+    /* One record per stream, all with the same change */
+    auto records = [type, streams] (const QString &key, const QJsonValue &value) {
+        std::vector<QJsonObject> r;
+        for (uint32_t index : streams) {
+            QJsonObject o;
+            o.insert(QStringLiteral("type"), type);
+            o.insert(QStringLiteral("index"), static_cast<qint64>(index));
+            o.insert(key, value);
+            r.push_back(o);
+        }
+        return r;
+    };
+
+    menu->addSection(tr("%1 Selected Streams").arg(streams.size()));
+
+    QMenu *move = menu->addMenu(playback ? tr("Move to Output") : tr("Move to Input"));
+    const QString target = playback ? QStringLiteral("sink") : QStringLiteral("source");
+    for (auto & device : playback ? sinks : sources) {
+        const uint32_t idx = device.first;
+        QAction *a = move->addAction(QString::fromUtf8(device.second.description));
+        connect(a, &QAction::triggered, this, [this, records, target, idx] {
+            runBulkChanges(records(target, static_cast<qint64>(idx)));
+        });
+    }
+
+    if (playback || HAVE_SOURCE_OUTPUT_VOLUMES) {
+        QAction *mute = menu->addAction(tr("Mute"));
+        connect(mute, &QAction::triggered, this, [this, records] {
+            runBulkChanges(records(QStringLiteral("mute"), true));
+        });
+
+        QAction *unmute = menu->addAction(tr("Unmute"));
+        connect(unmute, &QAction::triggered, this, [this, records] {
+            runBulkChanges(records(QStringLiteral("mute"), false));
+        });
+
+        QAction *volume = menu->addAction(tr("Set Volume..."));
+        connect(volume, &QAction::triggered, this, [this, records] {
+            bool ok;
+            const int percent = QInputDialog::getInt(this, tr("Set Volume"), tr("Volume of the selected streams (%):"),
+                                                     100, 0, paVolume2Percent(PA_VOLUME_UI_MAX), 1, &ok);
+            if (ok)
+                runBulkChanges(records(QStringLiteral("volume"), percent));
+        });
+    }
+
+    QAction *terminate = menu->addAction(playback ? tr("Terminate Playback") : tr("Terminate Recording"));
+    connect(terminate, &QAction::triggered, this, [this, records] {
+        runBulkChanges(records(QStringLiteral("kill"), true));
+    });
+}
+
+void MainWindow::runBulkChanges(const std::vector<QJsonObject> &records) {
+    pa_context *c = get_context();
+
+    if (!c || pa_context_get_state(c) != PA_CONTEXT_READY)
+        return;
+
+    /* The events caused by the changes are refetched in one go at the end,
+     * instead of in as many refreshes as the answers are spread over */
+    hold_refresh();
+
+    ChangeBatch *batch = new ChangeBatch(records, [this] (ChangeBatch *b) {
+        /* Streams that went away meanwhile are not worth a dialog */
+        for (const QString &e : b->errors())
+            g_debug("%s", e.toUtf8().constData());
+
+        m_bulkBatches.erase(b);
+        delete b;
+        release_refresh(this);
+    });
+
+    m_bulkBatches.insert(batch);
+    batch->start(c);
+}
+
+void MainWindow::cancelBulkChanges() {
+    for (ChangeBatch *batch : m_bulkBatches)
+        delete batch;
+    m_bulkBatches.clear();
+}
+
+bool MainWindow::startControlServer(const QString &name) {
+    if (!controlServer)
+        controlServer = new ControlServer(this);
+
+    return controlServer->listen(name);
 }
 
 void MainWindow::setConnectingMessage(const char *string) {
@@ -1101,7 +1848,7 @@ void MainWindow::onSinkTypeComboBoxChanged(int /*index*/) {
     if (showSinkType == (SinkType) -1)
         sinkTypeComboBox->setCurrentIndex((int) SINK_ALL);
 
-    updateDeviceVisibility();
+    refilterTab(TAB_OUTPUT_DEVICES);
 }
 
 void MainWindow::onSourceTypeComboBoxChanged(int /*index*/) {
@@ -1110,7 +1857,7 @@ void MainWindow::onSourceTypeComboBoxChanged(int /*index*/) {
     if (showSourceType == (SourceType) -1)
         sourceTypeComboBox->setCurrentIndex((int) SOURCE_NO_MONITOR);
 
-    updateDeviceVisibility();
+    refilterTab(TAB_INPUT_DEVICES);
 }
 
 void MainWindow::onSinkInputTypeComboBoxChanged(int /*index*/) {
@@ -1119,7 +1866,7 @@ void MainWindow::onSinkInputTypeComboBoxChanged(int /*index*/) {
     if (showSinkInputType == (SinkInputType) -1)
         sinkInputTypeComboBox->setCurrentIndex((int) SINK_INPUT_CLIENT);
 
-    updateDeviceVisibility();
+    refilterTab(TAB_PLAYBACK);
 }
 
 void MainWindow::onSourceOutputTypeComboBoxChanged(int /*index*/) {
@@ -1128,48 +1875,70 @@ void MainWindow::onSourceOutputTypeComboBoxChanged(int /*index*/) {
     if (showSourceOutputType == (SourceOutputType) -1)
         sourceOutputTypeComboBox->setCurrentIndex((int) SOURCE_OUTPUT_CLIENT);
 
-    updateDeviceVisibility();
+    refilterTab(TAB_RECORDING);
 }
 
 
+void MainWindow::changeEvent(QEvent *event) {
+    if (event->type() == QEvent::WindowStateChange)
+        monitorStreams->scheduleUpdate();
+
+    QDialog::changeEvent(event);
+}
+
+void MainWindow::showEvent(QShowEvent *event) {
+    monitorStreams->scheduleUpdate();
+    QDialog::showEvent(event);
+}
+
+void MainWindow::hideEvent(QHideEvent *event) {
+    monitorStreams->scheduleUpdate();
+    QDialog::hideEvent(event);
+}
+
+bool MainWindow::eventFilter(QObject *object, QEvent *event) {
+    /* The cost of the meters, measured over the time since last asked */
+    if (object == showVolumeMetersCheckButton && event->type() == QEvent::ToolTip)
+        showVolumeMetersCheckButton->setToolTip(tr("Meter updates: %1 per second").arg(monitorStreams->wakeupsPerSecond(), 0, 'f', 1));
+
+    return QDialog::eventFilter(object, event);
+}
+
+void MainWindow::showMeterMenu(const QPoint &pos) {
+    MeterBallistics *ballistics = MeterBallistics::instance();
+    QMenu menu;
+
+    auto addPreset = [&menu, ballistics] (const QString &text, MeterBallistics::Preset preset) {
+        QAction *a = menu.addAction(text);
+        a->setCheckable(true);
+        a->setChecked(ballistics->preset() == preset);
+        connect(a, &QAction::triggered, [ballistics, preset] { ballistics->setPreset(preset); });
+    };
+
+    addPreset(tr("Peak"), MeterBallistics::PresetPeak);
+    addPreset(tr("PPM"), MeterBallistics::PresetPpm);
+    addPreset(tr("VU"), MeterBallistics::PresetVu);
+
+    menu.addSeparator();
+    QAction *perChannel = menu.addAction(tr("Meter Each Channel of Devices"));
+    perChannel->setCheckable(true);
+    perChannel->setChecked(monitorStreams->perChannel());
+    connect(perChannel, &QAction::toggled, [this] (bool checked) { monitorStreams->setPerChannel(checked); });
+
+    menu.exec(showVolumeMetersCheckButton->mapToGlobal(pos));
+}
+
 void MainWindow::onShowVolumeMetersCheckButtonToggled(bool /*toggled*/) {
     bool state = showVolumeMetersCheckButton->isChecked();
-    pa_operation *o;
 
-    for (auto & sinkWidget : sinkWidgets) {
-        SinkWidget *sw = sinkWidget.second;
-        if (sw->peak) {
-            o = pa_stream_cork(sw->peak, (int)!state, nullptr, nullptr);
-            if (o)
-                pa_operation_unref(o);
-        }
-        sw->setVolumeMeterVisible(state);
-    }
-    for (auto & sourceWidget : sourceWidgets) {
-        SourceWidget *sw = sourceWidget.second;
-        if (sw->peak) {
-            o = pa_stream_cork(sw->peak, (int)!state, nullptr, nullptr);
-            if (o)
-                pa_operation_unref(o);
-        }
-        sw->setVolumeMeterVisible(state);
-    }
-    for (auto & sinkInputWidget : sinkInputWidgets) {
-        SinkInputWidget *sw = sinkInputWidget.second;
-        if (sw->peak) {
-            o = pa_stream_cork(sw->peak, (int)!state, nullptr, nullptr);
-            if (o)
-                pa_operation_unref(o);
-        }
-        sw->setVolumeMeterVisible(state);
-    }
-    for (auto & sourceOutputWidget : sourceOutputWidgets) {
-        SourceOutputWidget *sw = sourceOutputWidget.second;
-        if (sw->peak) {
-            o = pa_stream_cork(sw->peak, (int)!state, nullptr, nullptr);
-            if (o)
-                pa_operation_unref(o);
-        }
-        sw->setVolumeMeterVisible(state);
-    }
+    monitorStreams->setEnabled(state);
+
+    for (auto & sinkWidget : sinkWidgets)
+        sinkWidget.second->setVolumeMeterVisible(state);
+    for (auto & sourceWidget : sourceWidgets)
+        sourceWidget.second->setVolumeMeterVisible(state);
+    for (auto & sinkInputWidget : sinkInputWidgets)
+        sinkInputWidget.second->setVolumeMeterVisible(state);
+    for (auto & sourceOutputWidget : sourceOutputWidgets)
+        sourceOutputWidget.second->setVolumeMeterVisible(state);
 }
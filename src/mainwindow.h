@@ -27,15 +27,52 @@
 #  include <pulse/ext-device-restore.h>
 #endif
 
+#include <map>
+#include <set>
+#include <vector>
+
 #include <QDialog>
+#include <QJsonObject>
+#include <QPointer>
 #include "ui_mainwindow.h"
+#include "cardwidget.h"
 
 class CardWidget;
+class DeviceWidget;
 class SinkWidget;
 class SourceWidget;
 class SinkInputWidget;
 class SourceOutputWidget;
 class RoleWidget;
+class MinimalStreamWidget;
+class MonitorStreamManager;
+class OperationCoalescer;
+class ControlServer;
+class ChangeBatch;
+class StreamWidget;
+class StreamListModel;
+class StreamListView;
+class QSortFilterProxyModel;
+class QMenu;
+class SpectrumDialog;
+
+/* What the other tabs need to know about a device. Kept for every device,
+ * whether or not the tab showing it has been built yet. */
+struct DeviceRecord {
+    QByteArray name;
+    QByteArray description;
+    uint32_t card;
+    uint32_t monitor_index;
+};
+
+/* A client with its name escaped for the stream labels once, and the
+ * stream widgets showing it, so that a rename only touches those */
+struct ClientRecord {
+    QByteArray name;
+    QString markup;
+    std::set<SinkInputWidget*> sinkInputs;
+    std::set<SourceOutputWidget*> sourceOutputs;
+};
 
 class MainWindow : public QDialog, public Ui::MainWindow {
     Q_OBJECT
@@ -50,7 +87,6 @@ public:
     void updateSourceOutput(const pa_source_output_info &info);
     void updateClient(const pa_client_info &info);
     void updateServer(const pa_server_info &info);
-    void updateVolumeMeter(uint32_t source_index, uint32_t sink_input_index, double v);
     void updateRole(const pa_ext_stream_restore_info &info);
 #if HAVE_EXT_DEVICE_RESTORE_API
     void updateDeviceInfo(const pa_ext_device_restore_info &info);
@@ -63,36 +99,95 @@ public:
     void removeSourceOutput(uint32_t index);
     void removeClient(uint32_t index);
 
-    void removeAllWidgets();
+    /* When the connection is lost the widgets stay up, out of reach, and
+     * are matched by name against the objects of the next connection,
+     * keeping those whose object came back. The others are removed once
+     * the new connection has been enumerated. */
+    void markWidgetsStale();
+    void removeStaleWidgets();
 
     void setConnectingMessage(const char *string = NULL);
 
+    /* Show playback and recording streams in a list view instead of one
+     * widget per stream. Must be called before connecting. */
+    void setStreamListMode(bool enabled);
+    bool hasPlaybackStreams() const;
+    bool hasRecordingStreams() const;
+
     std::map<uint32_t, CardWidget*> cardWidgets;
     std::map<uint32_t, SinkWidget*> sinkWidgets;
     std::map<uint32_t, SourceWidget*> sourceWidgets;
     std::map<uint32_t, SinkInputWidget*> sinkInputWidgets;
     std::map<uint32_t, SourceOutputWidget*> sourceOutputWidgets;
 
-    std::map<uint32_t, char*> clientNames;
+    /* Widgets are only created for tabs that have been shown, these are
+     * maintained for all objects */
+    std::map<uint32_t, DeviceRecord> sinks;
+    std::map<uint32_t, DeviceRecord> sources;
+    std::map<uint32_t, std::map<QByteArray, PortInfo> > cardPorts;
+    /* The sink and source widgets of each card */
+    std::map<uint32_t, std::set<DeviceWidget*> > cardDevices;
+    std::set<uint32_t> sinkInputIndexes;
+    std::set<uint32_t> sourceOutputIndexes;
+
+    void resetTabs();
+    void markAllTabsBuilt();
+    bool isTabBuilt(int tab) const;
+
+    std::map<uint32_t, ClientRecord> clients;
     SinkInputType showSinkInputType;
     SinkType showSinkType;
     SourceOutputType showSourceOutputType;
     SourceType showSourceType;
 
+protected:
+    /* Meters are only fed while the window can be seen */
+    void changeEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    bool eventFilter(QObject *object, QEvent *event) override;
+
 protected Q_SLOTS:
     virtual void onSinkInputTypeComboBoxChanged(int index);
     virtual void onSourceOutputTypeComboBoxChanged(int index);
     virtual void onSinkTypeComboBoxChanged(int index);
     virtual void onSourceTypeComboBoxChanged(int index);
     virtual void onShowVolumeMetersCheckButtonToggled(bool toggled);
+    virtual void onNotebookCurrentChanged(int index);
 
 public:
     void setConnectionState(gboolean connected);
+    /* Applies the type filters to all widgets again */
     void updateDeviceVisibility();
+    /* Refreshes the empty label and layout of the tab when idle */
+    void updateTabVisibility(int tab);
     void reallyUpdateDeviceVisibility();
-    pa_stream* createMonitorStreamForSource(uint32_t source_idx, uint32_t stream_idx, bool suspend);
+    /* Peaks are detected rate times per second and read samples at a time,
+     * per channel of map if given, mixed down to mono otherwise */
+    pa_stream* createMonitorStreamForSource(uint32_t source_idx, uint32_t stream_idx, bool suspend, uint32_t rate, uint32_t samples,
+                                            const pa_channel_map *map, pa_stream_request_cb_t read_cb,
+                                            pa_stream_notify_cb_t suspended_cb, void *userdata);
     void createMonitorStreamForSinkInput(SinkInputWidget* w, uint32_t sink_idx);
 
+    MonitorStreamManager *monitorStreams;
+    OperationCoalescer *operations;
+
+    /* Accepts batches of changes from scripts, only when asked for */
+    bool startControlServer(const QString &name);
+    ControlServer *controlServer;
+
+    /* Changes to several streams at once are sent together, and the widgets
+     * refreshed once the server answered all of them */
+    void showStreamMenu(StreamWidget *w, const QPoint &globalPos);
+    void runBulkChanges(const std::vector<QJsonObject> &records);
+    /* Drops the changes of a connection that went away */
+    void cancelBulkChanges();
+
+    /* Of a source, or of a sink input on the monitor of its sink, one
+     * dialog each */
+    void showSpectrum(uint32_t source_idx, uint32_t stream_idx, const QString &title);
+
+    static const char *iconNameFromProplist(pa_proplist *l, const char *def);
     void setIconFromProplist(QLabel *icon, pa_proplist *l, const char *name);
 
     RoleWidget *eventRoleWidget;
@@ -105,6 +200,50 @@ public:
     bool canRenameDevices;
 
 private:
+    void createStreamList(QGridLayout *grid, QScrollArea *area, QLabel *emptyLabel, StreamListModel *model,
+                              QSortFilterProxyModel *&filter, StreamListView *&view, const QString &direction);
+    void showStreamListMenu(StreamListView *view, const QPoint &pos);
+    std::vector<uint32_t> selectedStreams(bool playback) const;
+    void addBulkActions(QMenu *menu, bool playback, const std::vector<uint32_t> &streams);
+    void showMeterMenu(const QPoint &pos);
+
+    /* Visibility is kept up to date per widget as widgets come and go, with
+     * a count of the shown widgets per tab for the empty labels */
+    bool filterAccepts(const SinkInputWidget *w) const;
+    bool filterAccepts(const SourceOutputWidget *w) const;
+    bool filterAccepts(const SinkWidget *w) const;
+    bool filterAccepts(const SourceWidget *w) const;
+    void applyFilter(MinimalStreamWidget *w, bool accepted, int tab, bool force = false);
+    void forgetFiltered(MinimalStreamWidget *w, int tab);
+    void refilterTab(int tab);
+    void updateStreamDeviceButtons(bool force = false);
+
+    void setDeviceCard(DeviceWidget *w, uint32_t card, bool is_new);
+    void forgetDeviceCard(DeviceWidget *w);
+
+    /* The client of a stream, once its name is known */
+    const ClientRecord *knownClient(uint32_t index) const;
+
+    StreamListModel *sinkInputModel;
+    StreamListModel *sourceOutputModel;
+    QSortFilterProxyModel *sinkInputFilter;
+    QSortFilterProxyModel *sourceOutputFilter;
+    StreamListView *sinkInputView;
+    StreamListView *sourceOutputView;
+
+    std::set<ChangeBatch*> m_bulkBatches;
+    std::map<std::pair<uint32_t, uint32_t>, QPointer<SpectrumDialog> > m_spectrumDialogs;
+
+    std::multimap<QByteArray, CardWidget*> m_staleCards;
+    std::multimap<QByteArray, SinkWidget*> m_staleSinks;
+    std::multimap<QByteArray, SourceWidget*> m_staleSources;
+    std::multimap<QByteArray, SinkInputWidget*> m_staleSinkInputs;
+    std::multimap<QByteArray, SourceOutputWidget*> m_staleSourceOutputs;
+
+    unsigned m_builtTabs;
+    unsigned m_dirtyTabs;
+    unsigned m_shownWidgets[TAB_CONFIGURATION + 1];
+    bool m_multipleSinks, m_multipleSources;
     gboolean m_connected;
     gchar* m_config_filename;
 };
@@ -0,0 +1,169 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "meterballistics.h"
+#include "levelmeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#define FRAME_INTERVAL_MS 16
+
+/* Close enough to the target for the meter to stop moving */
+#define SETTLED .001f
+
+MeterBallistics *MeterBallistics::instance() {
+    /* Outlives the application, like its timer */
+    static MeterBallistics *ballistics = new MeterBallistics;
+    return ballistics;
+}
+
+MeterBallistics::MeterBallistics() :
+    mLastFrame(0) {
+
+    setPreset(PresetPeak);
+    setPeakHold(1.5);
+
+    mTimer.setInterval(FRAME_INTERVAL_MS);
+    QObject::connect(&mTimer, &QTimer::timeout, [this] { frame(); });
+}
+
+void MeterBallistics::setPreset(Preset preset) {
+    mPreset = preset;
+
+    switch (preset) {
+        case PresetPeak:
+            mRms = false;
+            setTimes(0, .25);
+            break;
+        case PresetPpm:
+            /* 24 dB is a factor of 15.85 */
+            mRms = false;
+            setTimes(.0025, 2.8 / std::log(15.85));
+            break;
+        case PresetVu:
+            /* 99% of a step within 300 ms */
+            mRms = true;
+            setTimes(.065, .065);
+            break;
+    }
+}
+
+void MeterBallistics::setTimes(double attack, double release) {
+    mAttack = std::max(attack, 0.);
+    mRelease = std::max(release, 0.);
+}
+
+void MeterBallistics::setPeakHold(double seconds) {
+    mHold = (gint64) (std::max(seconds, 0.) * 1e6);
+}
+
+int MeterBallistics::add(LevelMeter *meter) {
+    mStates.push_back(State{-1, -1, -1, 0});
+    mMeters.push_back(meter);
+    return (int) mStates.size() - 1;
+}
+
+void MeterBallistics::remove(int slot) {
+    /* The last meter takes the place of the removed one */
+    const int last = (int) mStates.size() - 1;
+
+    if (slot != last) {
+        mStates[slot] = mStates[last];
+        mMeters[slot] = mMeters[last];
+        mMeters[slot]->mSlot = slot;
+    }
+
+    mStates.pop_back();
+    mMeters.pop_back();
+
+    if (mStates.empty())
+        mTimer.stop();
+}
+
+void MeterBallistics::input(int slot, const LevelSample &level) {
+    State &s = mStates[slot];
+    const float v = mRms && level.rms >= 0 ? level.rms : level.peak;
+
+    s.target = v;
+
+    if (v < 0) {
+        /* Suspended, shown at once */
+        s.value = s.hold = -1;
+        mMeters[slot]->setLevel(-1, -1);
+        return;
+    }
+
+    if (s.value < 0)
+        s.value = 0;
+
+    if (mHold && v >= s.hold) {
+        s.hold = v;
+        s.holdUntil = level.timestamp + mHold;
+    }
+
+    if (!mTimer.isActive()) {
+        mLastFrame = g_get_monotonic_time();
+        mTimer.start();
+    }
+}
+
+void MeterBallistics::frame() {
+    const gint64 now = g_get_monotonic_time();
+    const double dt = (now - mLastFrame) / 1e6;
+    const float attack = mAttack > 0 ? (float) (1 - std::exp(-dt / mAttack)) : 1;
+    const float release = mRelease > 0 ? (float) (1 - std::exp(-dt / mRelease)) : 1;
+    const size_t n = mStates.size();
+    bool moving = false;
+
+    mLastFrame = now;
+
+    for (size_t i = 0; i < n; i++) {
+        State &s = mStates[i];
+
+        if (s.target < 0)
+            continue;
+
+        const float d = s.target - s.value;
+        const float before = s.value, held = s.hold;
+
+        if (std::fabs(d) <= SETTLED)
+            s.value = s.target;
+        else {
+            s.value += d * (d > 0 ? attack : release);
+            moving = true;
+        }
+
+        /* A marker that has served its time falls back to the bar */
+        if (s.hold >= 0) {
+            if (now >= s.holdUntil)
+                s.hold = -1;
+            else
+                moving = true;
+        }
+
+        if (s.value != before || s.hold != held)
+            mMeters[i]->setLevel(s.value, s.hold);
+    }
+
+    if (!moving)
+        mTimer.stop();
+}
@@ -0,0 +1,85 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef meterballistics_h
+#define meterballistics_h
+
+#include "levelkernel.h"
+
+#include <QTimer>
+#include <vector>
+
+class LevelMeter;
+
+/* Turns the readings of the peak streams into what the meters show. Rise
+ * and fall follow time constants on the monotonic clock, so they do not
+ * depend on how often readings arrive, and the highest level is marked
+ * for a while after it was reached.
+ *
+ * The state of all meters is kept in one array and evaluated once per
+ * display frame, and only while some meter is still moving. */
+class MeterBallistics {
+public:
+    enum Preset {
+        /* Instant rise and quick fall on sample peaks */
+        PresetPeak,
+        /* IEC 60268-10 type II: 10 ms integration, 24 dB fall in 2.8 s */
+        PresetPpm,
+        /* IEC 60268-17: 300 ms rise and fall on the RMS level */
+        PresetVu
+    };
+
+    static MeterBallistics *instance();
+
+    void setPreset(Preset preset);
+    Preset preset() const { return mPreset; }
+
+    /* Attack and release time constants, in seconds, 0 is instant */
+    void setTimes(double attack, double release);
+    /* How long the peak marker stays, 0 hides it */
+    void setPeakHold(double seconds);
+
+    /* Every meter has a slot for as long as it exists */
+    int add(LevelMeter *meter);
+    void remove(int slot);
+    void input(int slot, const LevelSample &level);
+
+private:
+    MeterBallistics();
+
+    struct State {
+        float target;
+        float value;
+        float hold;
+        gint64 holdUntil;
+    };
+
+    void frame();
+
+    std::vector<State> mStates;
+    std::vector<LevelMeter*> mMeters;
+
+    Preset mPreset;
+    double mAttack, mRelease;
+    gint64 mHold;
+    bool mRms;
+
+    QTimer mTimer;
+    gint64 mLastFrame;
+};
+
+#endif
@@ -23,46 +23,54 @@
 #endif
 
 #include "minimalstreamwidget.h"
+#include "levelmeter.h"
+#include "loudnessmonitor.h"
 #include <QGridLayout>
-#include <QProgressBar>
+#include <QLabel>
 #include <QDebug>
 
 /*** MinimalStreamWidget ***/
 MinimalStreamWidget::MinimalStreamWidget(QWidget *parent) :
     QWidget(parent),
-    peakProgressBar(new QProgressBar(this)),
-    lastPeak(0),
-    peak(nullptr),
+    peakMeter(new LevelMeter(this)),
     updating(false),
+    filterAccepted(false),
     volumeMeterEnabled(false),
-    volumeMeterVisible(true) {
+    volumeMeterVisible(true),
+    loudnessLabel(new QLabel(this)),
+    loudness(nullptr) {
 
-    peakProgressBar->setTextVisible(false);
-    peakProgressBar->hide();
+    peakMeter->hide();
+    loudnessLabel->setTextFormat(Qt::PlainText);
+    loudnessLabel->hide();
 }
 
-void MinimalStreamWidget::initPeakProgressBar(QGridLayout* channelsGrid) {
-    channelsGrid->addWidget(peakProgressBar, channelsGrid->rowCount(), 0, 1, -1);
+void MinimalStreamWidget::initPeakMeter(QGridLayout* channelsGrid) {
+    const int row = channelsGrid->rowCount();
+    channelsGrid->addWidget(peakMeter, row, 0, 1, -1);
+    channelsGrid->addWidget(loudnessLabel, row + 1, 0, 1, -1);
 }
 
-#define DECAY_STEP .04
+void MinimalStreamWidget::startLoudness(uint32_t source_idx, uint32_t stream_idx) {
+    stopLoudness();
 
-void MinimalStreamWidget::updatePeak(double v) {
-
-    if (lastPeak >= DECAY_STEP)
-        if (v < lastPeak - DECAY_STEP)
-            v = lastPeak - DECAY_STEP;
+    loudness = new LoudnessMonitor(loudnessLabel, this);
+    if (!loudness->monitor(source_idx, stream_idx)) {
+        stopLoudness();
+        return;
+    }
+    loudnessLabel->show();
+}
 
-    lastPeak = v;
+void MinimalStreamWidget::stopLoudness() {
+    delete loudness;
+    loudness = nullptr;
+    loudnessLabel->hide();
+}
 
-    if (v >= 0) {
-        peakProgressBar->setEnabled(TRUE);
-        int value = qRound(v * peakProgressBar->maximum());
-        peakProgressBar->setValue(value);
-    } else {
-        peakProgressBar->setEnabled(FALSE);
-        peakProgressBar->setValue(0);
-    }
+void MinimalStreamWidget::updateLevel(const LevelSample &level) {
+    /* Shown by the ballistics at the next frame */
+    peakMeter->setReading(level);
 
     enableVolumeMeter();
 }
@@ -73,7 +81,7 @@ void MinimalStreamWidget::enableVolumeMeter() {
 
     volumeMeterEnabled = true;
     if (volumeMeterVisible) {
-        peakProgressBar->show();
+        peakMeter->show();
     }
 }
 
@@ -81,9 +89,9 @@ void MinimalStreamWidget::setVolumeMeterVisible(bool v) {
     volumeMeterVisible = v;
     if (v) {
         if (volumeMeterEnabled) {
-            peakProgressBar->show();
+            peakMeter->show();
         }
     } else {
-        peakProgressBar->hide();
+        peakMeter->hide();
     }
 }
@@ -22,35 +22,58 @@
 #define minimalstreamwidget_h
 
 #include "pavucontrol.h"
+#include "levelkernel.h"
 #include <QWidget>
 
-class QProgressBar;
+class LevelMeter;
+class LoudnessMonitor;
 class QGridLayout;
+class QLabel;
 
 class MinimalStreamWidget : public QWidget {
     Q_OBJECT
 public:
     MinimalStreamWidget(QWidget* parent = nullptr);
-    void initPeakProgressBar(QGridLayout* channelsGrid);
+    void initPeakMeter(QGridLayout* channelsGrid);
 
-    QProgressBar* peakProgressBar;
-    double lastPeak;
-    pa_stream *peak;
+    LevelMeter* peakMeter;
 
     bool updating;
 
+    /* Whether the type filter of its tab lets the widget be shown */
+    bool filterAccepted;
+
+    /* Texts and icon last applied from the server info, so that an update
+     * only touches what changed */
+    QByteArray shownTitle;
+    QByteArray shownText;
+    QByteArray shownIcon;
+
     virtual void onMuteToggleButton() = 0;
     virtual void onLockToggleButton() = 0;
     virtual void updateChannelVolume(int channel, pa_volume_t v) = 0;
 
     bool volumeMeterEnabled;
     void enableVolumeMeter();
-    void updatePeak(double v);
-    void setVolumeMeterVisible(bool v);
+    void updateLevel(const LevelSample &level);
+    /* The levels of each channel, with the per-channel meters. None when
+     * the stream is mixed down to mono. */
+    virtual void updateChannelLevels(const LevelSample * /*levels*/, unsigned /*n*/) {}
+    virtual void setVolumeMeterVisible(bool v);
+
+    /* EBU R128 loudness, under the meter. Starting again moves it to
+     * another stream and restarts the measurement. */
+    void startLoudness(uint32_t source_idx, uint32_t stream_idx = PA_INVALID_INDEX);
+    void stopLoudness();
+    bool loudnessShown() const { return loudness != nullptr; }
+    bool volumeMeterShown() const { return volumeMeterEnabled && volumeMeterVisible; }
 
 private :
     bool volumeMeterVisible;
 
+    QLabel *loudnessLabel;
+    LoudnessMonitor *loudness;
+
 };
 
 #endif
@@ -0,0 +1,330 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "monitorstreammanager.h"
+#include "minimalstreamwidget.h"
+#include "mainwindow.h"
+
+#include <algorithm>
+
+MonitorStreamManager::MonitorStreamManager(MainWindow *parent) :
+    mpMainWindow(parent),
+    mEnabled(true),
+    mPerChannel(false),
+    mPeakRate(200),
+    mDeviceRate(25),
+    mStreamRate(10),
+    mReads(0),
+    mReadsSince(g_get_monotonic_time()) {
+
+    mTimer.setSingleShot(true);
+    mTimer.setInterval(0);
+    QObject::connect(&mTimer, &QTimer::timeout, [this] { update(); });
+}
+
+MonitorStreamManager::~MonitorStreamManager() {
+    for (auto & stream : mStreams)
+        release(stream.second);
+}
+
+void MonitorStreamManager::subscribe(MinimalStreamWidget *w, uint32_t source_idx, uint32_t stream_idx, bool suspend,
+                                     const pa_channel_map *map) {
+    const Key key(source_idx, stream_idx);
+
+    auto sub = mSubscriptions.find(w);
+    if (sub != mSubscriptions.end()) {
+        if (sub->second == key)
+            return;
+        unsubscribe(w);
+    }
+
+    MonitorStream *m;
+    auto it = mStreams.find(key);
+
+    if (it != mStreams.end()) {
+        m = it->second;
+
+        /* Opened for one of the recording streams, before the device
+         * told its channel map and whether it may be suspended */
+        if (map) {
+            bool reconnect = false;
+
+            if (!m->map.channels) {
+                m->map = *map;
+                reconnect = mPerChannel && map->channels > 1;
+            }
+
+            if (m->suspend != suspend) {
+                m->suspend = suspend;
+                reconnect = true;
+            }
+
+            if (reconnect) {
+                disconnect(m);
+                if (!connect(key, m)) {
+                    drop(it);
+                    return;
+                }
+            }
+        }
+    } else {
+        m = new MonitorStream;
+        m->manager = this;
+        m->suspend = suspend;
+        if (map)
+            m->map = *map;
+        else
+            pa_channel_map_init(&m->map);
+        if (!connect(key, m)) {
+            delete m;
+            return;
+        }
+        mStreams[key] = m;
+    }
+
+    m->subscribers.push_back(w);
+    mSubscriptions[w] = key;
+
+    scheduleUpdate();
+}
+
+void MonitorStreamManager::unsubscribe(MinimalStreamWidget *w) {
+    auto sub = mSubscriptions.find(w);
+    if (sub == mSubscriptions.end())
+        return;
+
+    auto it = mStreams.find(sub->second);
+    mSubscriptions.erase(sub);
+
+    if (it == mStreams.end())
+        return;
+
+    MonitorStream *m = it->second;
+    m->subscribers.erase(std::remove(m->subscribers.begin(), m->subscribers.end(), w), m->subscribers.end());
+
+    if (m->subscribers.empty()) {
+        mStreams.erase(it);
+        release(m);
+    }
+}
+
+void MonitorStreamManager::reset() {
+    for (auto & stream : mStreams)
+        release(stream.second);
+
+    mStreams.clear();
+    mSubscriptions.clear();
+}
+
+void MonitorStreamManager::setEnabled(bool enabled) {
+    mEnabled = enabled;
+    update();
+}
+
+void MonitorStreamManager::setPerChannel(bool perChannel) {
+    if (perChannel == mPerChannel)
+        return;
+
+    mPerChannel = perChannel;
+
+    for (auto it = mStreams.begin(); it != mStreams.end();) {
+        MonitorStream *m = it->second;
+
+        if (it->first.second != PA_INVALID_INDEX || m->map.channels <= 1) {
+            ++it;
+            continue;
+        }
+
+        disconnect(m);
+        if (connect(it->first, m))
+            ++it;
+        else
+            it = drop(it);
+    }
+}
+
+void MonitorStreamManager::setRates(unsigned peakRate, unsigned deviceRate, unsigned streamRate) {
+    mPeakRate = qBound(1u, peakRate, 1000u);
+    mDeviceRate = qBound(1u, deviceRate, mPeakRate);
+    mStreamRate = qBound(1u, streamRate, mPeakRate);
+}
+
+double MonitorStreamManager::wakeupsPerSecond() {
+    const gint64 now = g_get_monotonic_time();
+    const double rate = now > mReadsSince ? mReads * 1e6 / (now - mReadsSince) : 0;
+
+    mReads = 0;
+    mReadsSince = now;
+    return rate;
+}
+
+void MonitorStreamManager::scheduleUpdate() {
+    if (!mTimer.isActive())
+        mTimer.start();
+}
+
+bool MonitorStreamManager::onScreen(const MonitorStream *m) const {
+    for (MinimalStreamWidget *w : m->subscribers)
+        if (w->isVisible() && !w->visibleRegion().isEmpty())
+            return true;
+
+    return false;
+}
+
+void MonitorStreamManager::update() {
+    const bool shown = mEnabled && mpMainWindow->isVisible() && !mpMainWindow->isMinimized();
+
+    mTimer.stop();
+
+    for (auto & stream : mStreams) {
+        MonitorStream *m = stream.second;
+        const bool corked = !shown || !onScreen(m);
+
+        /* Streams still connecting are looked at again once ready */
+        if (corked == m->corked || pa_stream_get_state(m->stream) != PA_STREAM_READY)
+            continue;
+
+        pa_operation *o = pa_stream_cork(m->stream, (int) corked, nullptr, nullptr);
+        if (o) {
+            m->corked = corked;
+            pa_operation_unref(o);
+        }
+    }
+}
+
+bool MonitorStreamManager::connect(const Key &key, MonitorStream *m) {
+    /* Streams of a single sink input are stream meters, the rest are
+     * shared by the device widgets */
+    const unsigned rate = key.second != PA_INVALID_INDEX ? mStreamRate : mDeviceRate;
+    const bool perChannel = mPerChannel && key.second == PA_INVALID_INDEX && m->map.channels > 1;
+
+    m->channels = perChannel ? m->map.channels : 1;
+    /* Created corked, until its meter turns out to be on screen */
+    m->corked = true;
+
+    if (!(m->stream = mpMainWindow->createMonitorStreamForSource(key.first, key.second, m->suspend, mPeakRate, mPeakRate / rate,
+                                                                 perChannel ? &m->map : nullptr,
+                                                                 read_callback, suspended_callback, m)))
+        return false;
+
+    pa_stream_set_state_callback(m->stream, state_callback, this);
+    scheduleUpdate();
+    return true;
+}
+
+void MonitorStreamManager::disconnect(MonitorStream *m) {
+    pa_stream_set_read_callback(m->stream, nullptr, nullptr);
+    pa_stream_set_suspended_callback(m->stream, nullptr, nullptr);
+    pa_stream_set_state_callback(m->stream, nullptr, nullptr);
+    pa_stream_disconnect(m->stream);
+    pa_stream_unref(m->stream);
+    m->stream = nullptr;
+}
+
+void MonitorStreamManager::release(MonitorStream *m) {
+    disconnect(m);
+    delete m;
+}
+
+std::map<MonitorStreamManager::Key, MonitorStreamManager::MonitorStream*>::iterator
+MonitorStreamManager::drop(std::map<Key, MonitorStream*>::iterator it) {
+    MonitorStream *m = it->second;
+
+    for (MinimalStreamWidget *w : m->subscribers)
+        mSubscriptions.erase(w);
+
+    delete m;
+    return mStreams.erase(it);
+}
+
+void MonitorStreamManager::MonitorStream::dispatch(const LevelSample &level, const LevelSample *levels, unsigned n) {
+    for (MinimalStreamWidget *w : subscribers) {
+        w->updateLevel(level);
+        w->updateChannelLevels(levels, n);
+    }
+}
+
+void MonitorStreamManager::state_callback(pa_stream *s, void *userdata) {
+    if (pa_stream_get_state(s) == PA_STREAM_READY)
+        static_cast<MonitorStreamManager*>(userdata)->scheduleUpdate();
+}
+
+void MonitorStreamManager::suspended_callback(pa_stream *s, void *userdata) {
+    MonitorStream *m = static_cast<MonitorStream*>(userdata);
+
+    if (pa_stream_is_suspended(s)) {
+        LevelSample levels[LEVEL_CHANNELS_MAX];
+        LevelSample level;
+        level.peak = level.rms = -1;
+        level.timestamp = g_get_monotonic_time();
+        for (unsigned c = 0; c < m->channels; c++)
+            levels[c] = level;
+        m->dispatch(level, levels, m->channels > 1 ? m->channels : 0);
+    }
+}
+
+void MonitorStreamManager::read_callback(pa_stream *s, size_t length, void *userdata) {
+    MonitorStream *m = static_cast<MonitorStream*>(userdata);
+    const void *data;
+    LevelSample level;
+    LevelSample levels[LEVEL_CHANNELS_MAX];
+    float peaks[LEVEL_CHANNELS_MAX], rms[LEVEL_CHANNELS_MAX];
+
+    if (pa_stream_peek(s, &data, &length) < 0) {
+        show_error(MainWindow::tr("Failed to read data from stream").toUtf8().constData());
+        return;
+    }
+
+    if (!data) {
+        /* nullptr data means either a hole or empty buffer.
+         * Only drop the stream when there is a hole (length > 0) */
+        if (length)
+            pa_stream_drop(s);
+        return;
+    }
+
+    assert(length > 0);
+    assert(length % sizeof(float) == 0);
+
+    m->manager->mReads++;
+
+    /* All of the fragment counts, not only its last sample */
+    level_compute(static_cast<const float*>(data), length / sizeof(float), &level.peak, &level.rms);
+    level.timestamp = g_get_monotonic_time();
+
+    if (m->channels > 1)
+        level_compute_channels(static_cast<const float*>(data), length / sizeof(float) / m->channels, m->channels, peaks, rms);
+
+    pa_stream_drop(s);
+
+    if (level.peak > 1)
+        level.peak = 1;
+    if (level.rms > 1)
+        level.rms = 1;
+
+    for (unsigned c = 0; m->channels > 1 && c < m->channels; c++) {
+        levels[c].peak = std::min(peaks[c], 1.0f);
+        levels[c].rms = std::min(rms[c], 1.0f);
+        levels[c].timestamp = level.timestamp;
+    }
+
+    m->dispatch(level, levels, m->channels > 1 ? m->channels : 0);
+}
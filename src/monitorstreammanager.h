@@ -0,0 +1,124 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef monitorstreammanager_h
+#define monitorstreammanager_h
+
+#include "pavucontrol.h"
+#include "levelkernel.h"
+
+#include <QTimer>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+class MainWindow;
+class MinimalStreamWidget;
+
+/* Owns the PEAK_DETECT record streams used for the volume meters. There is
+ * at most one stream per source (shared by the sink whose monitor it is, the
+ * source widget and all recording streams on it) and one per monitored sink
+ * input. Streams are reference counted by their subscribers and every peak
+ * sample is dispatched to all of them.
+ *
+ * Streams are only uncorked while one of their meters is on screen: meters
+ * are enabled, the window is shown and not minimized, and the widget is on
+ * the current tab and scrolled into view.
+ *
+ * The server detects peaks at a rate well above the display rate, so that
+ * short transients are not missed, and sends them in fragments. Each
+ * fragment is reduced to one reading, so there is one wakeup per fragment
+ * rather than per peak. Device meters and stream meters are read at their
+ * own rates, from the meters/peakRate, meters/deviceRate and
+ * meters/streamRate settings.
+ *
+ * In the per-channel mode the streams of devices are opened with the
+ * channel map of the device, and every reading also carries the level of
+ * each channel. Subscribers that only have one meter use the overall one. */
+class MonitorStreamManager {
+public:
+    MonitorStreamManager(MainWindow *parent);
+    ~MonitorStreamManager();
+
+    /* A widget has at most one subscription, subscribing again moves it.
+     * Device widgets pass their channel map for the per-channel mode. */
+    void subscribe(MinimalStreamWidget *w, uint32_t source_idx, uint32_t stream_idx = PA_INVALID_INDEX, bool suspend = false,
+                   const pa_channel_map *map = nullptr);
+    void unsubscribe(MinimalStreamWidget *w);
+
+    void setEnabled(bool enabled);
+
+    /* Reopens the streams of the devices that have more than one channel */
+    void setPerChannel(bool perChannel);
+    bool perChannel() const { return mPerChannel; }
+
+    /* Applies to the streams created afterwards */
+    void setRates(unsigned peakRate, unsigned deviceRate, unsigned streamRate);
+
+    /* Fragments read per second, since the previous call */
+    double wakeupsPerSecond();
+
+    /* Looks again at which meters are on screen, once back in the event
+     * loop, so that a burst of layout changes costs a single pass */
+    void scheduleUpdate();
+
+    /* Forgets all streams and subscriptions of a connection that went away */
+    void reset();
+
+private:
+    typedef std::pair<uint32_t, uint32_t> Key;
+
+    struct MonitorStream {
+        MonitorStreamManager *manager;
+        pa_stream *stream;
+        bool corked;
+        bool suspend;
+        /* Of the device, no channels until a device widget subscribed */
+        pa_channel_map map;
+        /* As read, 1 unless per channel */
+        unsigned channels;
+        std::vector<MinimalStreamWidget*> subscribers;
+
+        void dispatch(const LevelSample &level, const LevelSample *levels, unsigned n);
+    };
+
+    bool connect(const Key &key, MonitorStream *m);
+    void disconnect(MonitorStream *m);
+    void release(MonitorStream *m);
+    /* Forgets a stream that could not be reconnected and every subscription
+     * to it, so that subscribing again opens a new one */
+    std::map<Key, MonitorStream*>::iterator drop(std::map<Key, MonitorStream*>::iterator it);
+    bool onScreen(const MonitorStream *m) const;
+    void update();
+
+    static void read_callback(pa_stream *s, size_t length, void *userdata);
+    static void state_callback(pa_stream *s, void *userdata);
+    static void suspended_callback(pa_stream *s, void *userdata);
+
+    MainWindow *mpMainWindow;
+    std::map<Key, MonitorStream*> mStreams;
+    std::unordered_map<MinimalStreamWidget*, Key> mSubscriptions;
+    bool mEnabled;
+    bool mPerChannel;
+    QTimer mTimer;
+
+    unsigned mPeakRate, mDeviceRate, mStreamRate;
+    quint64 mReads;
+    gint64 mReadsSince;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "operationcoalescer.h"
+
+OperationCoalescer::OperationCoalescer() {
+}
+
+OperationCoalescer::~OperationCoalescer() {
+    reset();
+}
+
+void OperationCoalescer::submit(Property property, uint32_t index, const QString &error, const Sender &sender) {
+    submit(property, index, QByteArray(), error, sender);
+}
+
+void OperationCoalescer::submit(Property property, uint32_t index, const QByteArray &detail, const QString &error, const Sender &sender) {
+    const Key key(property, index, detail);
+    auto it = mSlots.find(key);
+
+    if (it != mSlots.end()) {
+        /* Replaces whatever was waiting, only the latest value matters */
+        it->second.pending = sender;
+        it->second.pendingError = error;
+        return;
+    }
+
+    Slot &slot = mSlots[key];
+    slot.owner = this;
+    slot.key = key;
+    slot.operation = nullptr;
+
+    if (!start(slot, sender, error))
+        mSlots.erase(key);
+}
+
+void OperationCoalescer::reset() {
+    for (auto & slot : mSlots) {
+        if (slot.second.operation) {
+            /* Cancelling makes sure the callback does not run anymore */
+            pa_operation_cancel(slot.second.operation);
+            pa_operation_unref(slot.second.operation);
+        }
+    }
+
+    mSlots.clear();
+}
+
+bool OperationCoalescer::start(Slot &slot, const Sender &sender, const QString &error) {
+    if (!(slot.operation = sender(success_cb, &slot))) {
+        show_error(error.toUtf8().constData());
+        return false;
+    }
+
+    return true;
+}
+
+void OperationCoalescer::success_cb(pa_context *, int, void *userdata) {
+    Slot *slot = static_cast<Slot*>(userdata);
+    OperationCoalescer *owner = slot->owner;
+
+    pa_operation_unref(slot->operation);
+    slot->operation = nullptr;
+
+    /* A failed operation is not retried, the next value may still work */
+    if (slot->pending) {
+        Sender next;
+        std::swap(next, slot->pending);
+
+        if (owner->start(*slot, next, slot->pendingError))
+            return;
+    }
+
+    const Key key = slot->key;
+    owner->mSlots.erase(key);
+}
@@ -0,0 +1,82 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef operationcoalescer_h
+#define operationcoalescer_h
+
+#include "pavucontrol.h"
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+#include <map>
+#include <tuple>
+
+/* Sends the changes made in the UI to the server with at most one operation
+ * in flight per object and property. While one is outstanding only the
+ * latest requested value is kept, it goes out when the previous operation
+ * completes. Dragging a slider therefore follows the server as fast as it
+ * answers, without piling up operations on a slow connection. */
+class OperationCoalescer {
+public:
+    enum Property {
+        SinkVolume,
+        SinkMute,
+        SinkPort,
+        SourceVolume,
+        SourceMute,
+        SourcePort,
+        SinkInputVolume,
+        SinkInputMute,
+        SourceOutputVolume,
+        SourceOutputMute,
+        PortLatencyOffset,
+        RoleVolume
+    };
+
+    /* Starts the operation, passing the completion callback through */
+    typedef std::function<pa_operation*(pa_context_success_cb_t cb, void *userdata)> Sender;
+
+    OperationCoalescer();
+    ~OperationCoalescer();
+
+    /* `detail` tells apart properties that are more than one per object,
+     * `error` is shown when the operation cannot be started */
+    void submit(Property property, uint32_t index, const QByteArray &detail, const QString &error, const Sender &sender);
+    void submit(Property property, uint32_t index, const QString &error, const Sender &sender);
+
+    /* Forgets all operations, for when the context goes away */
+    void reset();
+
+private:
+    typedef std::tuple<int, uint32_t, QByteArray> Key;
+
+    struct Slot {
+        OperationCoalescer *owner;
+        Key key;
+        pa_operation *operation;
+        Sender pending;
+        QString pendingError;
+    };
+
+    bool start(Slot &slot, const Sender &sender, const QString &error);
+    static void success_cb(pa_context *c, int success, void *userdata);
+
+    std::map<Key, Slot> mSlots;
+};
+
+#endif
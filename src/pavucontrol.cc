@@ -42,6 +42,10 @@
 #include "sourceoutputwidget.h"
 #include "rolewidget.h"
 #include "mainwindow.h"
+#include "operationcoalescer.h"
+#include "controlserver.h"
+#include "trace.h"
+#include "commands.h"
 #include <QMessageBox>
 #include <QApplication>
 #include <QLocale>
@@ -51,12 +55,16 @@
 #include <QCommandLineOption>
 #include <QString>
 
+#include <set>
+
 static pa_context* context = nullptr;
 static pa_mainloop_api* api = nullptr;
 static int n_outstanding = 0;
 static int default_tab = 0;
 static bool retry = false;
-static int reconnect_timeout = 1;
+/* Set once the connection failed for good, without --retry */
+static bool gave_up = false;
+static unsigned reconnect_attempts = 0;
 
 void show_error(const char *txt) {
     char buf[256];
@@ -73,6 +81,7 @@ static void dec_outstanding(MainWindow *w) {
 
     if (--n_outstanding <= 0) {
         // w->get_window()->set_cursor();
+        w->removeStaleWidgets();
         w->setConnectionState(true);
     }
 }
@@ -93,6 +102,7 @@ void card_cb(pa_context *, const pa_card_info *i, int eol, void *userdata) {
         return;
     }
 
+    trace_record_card(*i);
     w->updateCard(*i);
 }
 
@@ -115,6 +125,7 @@ void sink_cb(pa_context *c, const pa_sink_info *i, int eol, void *userdata) {
         dec_outstanding(w);
         return;
     }
+    trace_record_sink(*i);
 #if HAVE_EXT_DEVICE_RESTORE_API
     if (w->updateSink(*i))
         ext_device_restore_subscribe_cb(c, PA_DEVICE_TYPE_SINK, i->index, w);
@@ -139,6 +150,7 @@ void source_cb(pa_context *, const pa_source_info *i, int eol, void *userdata) {
         return;
     }
 
+    trace_record_source(*i);
     w->updateSource(*i);
 }
 
@@ -158,6 +170,7 @@ void sink_input_cb(pa_context *, const pa_sink_input_info *i, int eol, void *use
         return;
     }
 
+    trace_record_sink_input(*i);
     w->updateSinkInput(*i);
 }
 
@@ -179,11 +192,11 @@ void source_output_cb(pa_context *, const pa_source_output_info *i, int eol, voi
              * let's open one that isn't empty */
             if (default_tab != -1) {
                 if (default_tab < 1 || default_tab > w->notebook->count()) {
-                    if (!w->sinkInputWidgets.empty())
+                    if (w->hasPlaybackStreams())
                         w->notebook->setCurrentIndex(0);
-                    else if (!w->sourceOutputWidgets.empty())
+                    else if (w->hasRecordingStreams())
                         w->notebook->setCurrentIndex(1);
-                    else if (!w->sourceWidgets.empty() && w->sinkWidgets.empty())
+                    else if (!w->sources.empty() && w->sinks.empty())
                         w->notebook->setCurrentIndex(3);
                     else
                         w->notebook->setCurrentIndex(2);
@@ -198,6 +211,7 @@ void source_output_cb(pa_context *, const pa_source_output_info *i, int eol, voi
         return;
     }
 
+    trace_record_source_output(*i);
     w->updateSourceOutput(*i);
 }
 
@@ -217,6 +231,7 @@ void client_cb(pa_context *, const pa_client_info *i, int eol, void *userdata) {
         return;
     }
 
+    trace_record_client(*i);
     w->updateClient(*i);
 }
 
@@ -228,6 +243,7 @@ void server_info_cb(pa_context *, const pa_server_info *i, void *userdata) {
         return;
     }
 
+    trace_record_server(*i, pa_context_get_server_protocol_version(context));
     w->updateServer(*i);
     dec_outstanding(w);
 }
@@ -343,104 +359,225 @@ static void ext_device_manager_subscribe_cb(pa_context *c, void *userdata) {
     pa_operation_unref(o);
 }
 
-void subscribe_cb(pa_context *c, pa_subscription_event_type_t t, uint32_t index, void *userdata) {
+/* Subscription events are not acted upon immediately. Instead the affected
+ * indexes are collected per facility and refetched at most once per frame, so
+ * a burst of CHANGE events on one object costs a single round trip and a
+ * single widget refresh. */
+#define REFRESH_INTERVAL_MS 16
+
+struct PendingRefresh {
+    std::set<uint32_t> cards;
+    std::set<uint32_t> sinks;
+    std::set<uint32_t> sources;
+    std::set<uint32_t> sinkInputs;
+    std::set<uint32_t> sourceOutputs;
+    std::set<uint32_t> clients;
+    bool server = false;
+};
+
+static PendingRefresh pending_refresh;
+static guint refresh_source = 0;
+/* While bulk changes are in flight the events they cause pile up here */
+static int refresh_holds = 0;
+
+static bool check_refresh_operation(pa_operation *o, const QString &error) {
+    if (!o) {
+        show_error(error.toUtf8().constData());
+        return false;
+    }
+
+    pa_operation_unref(o);
+    return true;
+}
+
+static gboolean refresh_cb(gpointer userdata) {
     MainWindow *w = static_cast<MainWindow*>(userdata);
+    PendingRefresh p;
+
+    refresh_source = 0;
+    std::swap(p, pending_refresh);
+
+    if (!context || pa_context_get_state(context) != PA_CONTEXT_READY)
+        return FALSE;
+
+    if (p.server && !check_refresh_operation(pa_context_get_server_info(context, server_info_cb, w), QObject::tr("pa_context_get_server_info() failed")))
+        return FALSE;
+
+    for (uint32_t index : p.clients)
+        if (!check_refresh_operation(pa_context_get_client_info(context, index, client_cb, w), QObject::tr("pa_context_get_client_info() failed")))
+            return FALSE;
+
+    for (uint32_t index : p.cards)
+        if (!check_refresh_operation(pa_context_get_card_info_by_index(context, index, card_cb, w), QObject::tr("pa_context_get_card_info_by_index() failed")))
+            return FALSE;
+
+    for (uint32_t index : p.sinks)
+        if (!check_refresh_operation(pa_context_get_sink_info_by_index(context, index, sink_cb, w), QObject::tr("pa_context_get_sink_info_by_index() failed")))
+            return FALSE;
+
+    for (uint32_t index : p.sources)
+        if (!check_refresh_operation(pa_context_get_source_info_by_index(context, index, source_cb, w), QObject::tr("pa_context_get_source_info_by_index() failed")))
+            return FALSE;
+
+    for (uint32_t index : p.sinkInputs)
+        if (!check_refresh_operation(pa_context_get_sink_input_info(context, index, sink_input_cb, w), QObject::tr("pa_context_get_sink_input_info() failed")))
+            return FALSE;
+
+    for (uint32_t index : p.sourceOutputs)
+        if (!check_refresh_operation(pa_context_get_source_output_info(context, index, source_output_cb, w), QObject::tr("pa_context_get_source_output_info() failed")))
+            return FALSE;
+
+    return FALSE;
+}
+
+static void cancel_refresh() {
+    if (refresh_source) {
+        g_source_remove(refresh_source);
+        refresh_source = 0;
+    }
+    pending_refresh = PendingRefresh();
+    refresh_holds = 0;
+}
+
+static bool refresh_pending() {
+    const PendingRefresh &p = pending_refresh;
+    return p.server || !p.cards.empty() || !p.sinks.empty() || !p.sources.empty()
+        || !p.sinkInputs.empty() || !p.sourceOutputs.empty() || !p.clients.empty();
+}
+
+void hold_refresh(void) {
+    refresh_holds++;
+}
+
+void release_refresh(MainWindow *w) {
+    if (refresh_holds == 0 || --refresh_holds > 0)
+        return;
+
+    if (!refresh_source && refresh_pending())
+        refresh_source = g_timeout_add(REFRESH_INTERVAL_MS, refresh_cb, w);
+}
+
+/* Fills a tab whose widgets were skipped during the initial enumeration */
+void request_tab_contents(MainWindow *w, int tab) {
+    pa_operation *o;
+    QString error;
+
+    if (!context || pa_context_get_state(context) != PA_CONTEXT_READY)
+        return;
+
+    switch (tab) {
+        case TAB_PLAYBACK:
+            o = pa_context_get_sink_input_info_list(context, sink_input_cb, w);
+            error = QObject::tr("pa_context_get_sink_input_info_list() failed");
+            break;
+
+        case TAB_RECORDING:
+            o = pa_context_get_source_output_info_list(context, source_output_cb, w);
+            error = QObject::tr("pa_context_get_source_output_info_list() failed");
+            break;
+
+        case TAB_OUTPUT_DEVICES:
+            o = pa_context_get_sink_info_list(context, sink_cb, w);
+            error = QObject::tr("pa_context_get_sink_info_list() failed");
+            break;
+
+        case TAB_INPUT_DEVICES:
+            o = pa_context_get_source_info_list(context, source_cb, w);
+            error = QObject::tr("pa_context_get_source_info_list() failed");
+            break;
+
+        case TAB_CONFIGURATION:
+            o = pa_context_get_card_info_list(context, card_cb, w);
+            error = QObject::tr("pa_context_get_card_info_list() failed");
+            break;
+
+        default:
+            return;
+    }
+
+    if (!check_refresh_operation(o, error))
+        return;
+
+    /* The list callbacks end with dec_outstanding(), balance it if the
+     * initial enumeration is still running */
+    if (n_outstanding > 0)
+        n_outstanding++;
+}
+
+/* Marks an object as dirty, or drops it from the pending set and removes its
+ * widget when the object went away. A REMOVE supersedes any NEW or CHANGE
+ * seen earlier in the same frame. */
+template<typename RemoveFunc>
+static void mark_dirty(std::set<uint32_t> &dirty, pa_subscription_event_type_t t, uint32_t index, RemoveFunc remove) {
+    if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE) {
+        dirty.erase(index);
+        remove(index);
+    } else
+        dirty.insert(index);
+}
+
+void subscribe_cb(pa_context *, pa_subscription_event_type_t t, uint32_t index, void *userdata) {
+    MainWindow *w = static_cast<MainWindow*>(userdata);
+
+    trace_record_event(t, index);
 
     switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) {
         case PA_SUBSCRIPTION_EVENT_SINK:
-            if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
-                w->removeSink(index);
-            else {
-                pa_operation *o;
-                if (!(o = pa_context_get_sink_info_by_index(c, index, sink_cb, w))) {
-                    show_error(QObject::tr("pa_context_get_sink_info_by_index() failed").toUtf8().constData());
-                    return;
-                }
-                pa_operation_unref(o);
-            }
+            mark_dirty(pending_refresh.sinks, t, index, [w] (uint32_t i) { w->removeSink(i); });
             break;
 
         case PA_SUBSCRIPTION_EVENT_SOURCE:
-            if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
-                w->removeSource(index);
-            else {
-                pa_operation *o;
-                if (!(o = pa_context_get_source_info_by_index(c, index, source_cb, w))) {
-                    show_error(QObject::tr("pa_context_get_source_info_by_index() failed").toUtf8().constData());
-                    return;
-                }
-                pa_operation_unref(o);
-            }
+            mark_dirty(pending_refresh.sources, t, index, [w] (uint32_t i) { w->removeSource(i); });
             break;
 
         case PA_SUBSCRIPTION_EVENT_SINK_INPUT:
-            if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
-                w->removeSinkInput(index);
-            else {
-                pa_operation *o;
-                if (!(o = pa_context_get_sink_input_info(c, index, sink_input_cb, w))) {
-                    show_error(QObject::tr("pa_context_get_sink_input_info() failed").toUtf8().constData());
-                    return;
-                }
-                pa_operation_unref(o);
-            }
+            mark_dirty(pending_refresh.sinkInputs, t, index, [w] (uint32_t i) { w->removeSinkInput(i); });
             break;
 
         case PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT:
-            if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
-                w->removeSourceOutput(index);
-            else {
-                pa_operation *o;
-                if (!(o = pa_context_get_source_output_info(c, index, source_output_cb, w))) {
-                    show_error(QObject::tr("pa_context_get_sink_input_info() failed").toUtf8().constData());
-                    return;
-                }
-                pa_operation_unref(o);
-            }
+            mark_dirty(pending_refresh.sourceOutputs, t, index, [w] (uint32_t i) { w->removeSourceOutput(i); });
             break;
 
         case PA_SUBSCRIPTION_EVENT_CLIENT:
-            if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
-                w->removeClient(index);
-            else {
-                pa_operation *o;
-                if (!(o = pa_context_get_client_info(c, index, client_cb, w))) {
-                    show_error(QObject::tr("pa_context_get_client_info() failed").toUtf8().constData());
-                    return;
-                }
-                pa_operation_unref(o);
-            }
+            mark_dirty(pending_refresh.clients, t, index, [w] (uint32_t i) { w->removeClient(i); });
             break;
 
-        case PA_SUBSCRIPTION_EVENT_SERVER: {
-                pa_operation *o;
-                if (!(o = pa_context_get_server_info(c, server_info_cb, w))) {
-                    show_error(QObject::tr("pa_context_get_server_info() failed").toUtf8().constData());
-                    return;
-                }
-                pa_operation_unref(o);
-            }
+        case PA_SUBSCRIPTION_EVENT_SERVER:
+            pending_refresh.server = true;
             break;
 
         case PA_SUBSCRIPTION_EVENT_CARD:
-            if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
-                w->removeCard(index);
-            else {
-                pa_operation *o;
-                if (!(o = pa_context_get_card_info_by_index(c, index, card_cb, w))) {
-                    show_error(QObject::tr("pa_context_get_card_info_by_index() failed").toUtf8().constData());
-                    return;
-                }
-                pa_operation_unref(o);
-            }
+            mark_dirty(pending_refresh.cards, t, index, [w] (uint32_t i) { w->removeCard(i); });
             break;
 
+        default:
+            return;
     }
+
+    if (!refresh_source && refresh_holds == 0)
+        refresh_source = g_timeout_add(REFRESH_INTERVAL_MS, refresh_cb, w);
 }
 
 /* Forward Declaration */
 gboolean connect_to_pulse(gpointer userdata);
 
+/* Reconnects back off exponentially up to a cap. The delay is drawn from
+ * its upper half, so that the clients of a restarted server do not all
+ * come back at the same moment. */
+#define RECONNECT_MIN_MS 250
+#define RECONNECT_MAX_MS 30000
+
+static void schedule_reconnect(MainWindow *w) {
+    guint delay = RECONNECT_MAX_MS;
+
+    if (reconnect_attempts < 8)
+        delay = MIN(RECONNECT_MIN_MS << reconnect_attempts, RECONNECT_MAX_MS);
+    reconnect_attempts++;
+
+    delay = delay / 2 + g_random_int_range(0, delay / 2 + 1);
+    g_timeout_add(delay, connect_to_pulse, w);
+}
+
 void context_state_callback(pa_context *c, void *userdata) {
     MainWindow *w = static_cast<MainWindow*>(userdata);
 
@@ -456,7 +593,9 @@ void context_state_callback(pa_context *c, void *userdata) {
         case PA_CONTEXT_READY: {
             pa_operation *o;
 
-            reconnect_timeout = 1;
+            reconnect_attempts = 0;
+
+            w->resetTabs();
 
             /* Create event widget immediately so it's first in the list */
             w->createEventRoleWidget();
@@ -575,14 +714,20 @@ void context_state_callback(pa_context *c, void *userdata) {
         case PA_CONTEXT_FAILED:
             w->setConnectionState(false);
 
-            w->removeAllWidgets();
+            cancel_refresh();
+            w->operations->reset();
+            w->cancelBulkChanges();
+            if (w->controlServer)
+                w->controlServer->reset();
+
+            w->markWidgetsStale();
             w->updateDeviceVisibility();
             pa_context_unref(context);
             context = nullptr;
 
-            if (reconnect_timeout > 0) {
+            if (!gave_up) {
                 g_debug("%s", QObject::tr("Connection failed, attempting reconnect").toUtf8().constData());
-                g_timeout_add_seconds(reconnect_timeout, connect_to_pulse, w);
+                schedule_reconnect(w);
             }
             return;
 
@@ -597,18 +742,28 @@ pa_context* get_context(void) {
   return context;
 }
 
-gboolean connect_to_pulse(gpointer userdata) {
-    MainWindow *w = static_cast<MainWindow*>(userdata);
-
-    if (context)
-        return false;
+uint32_t get_server_protocol_version(void) {
+    if (!context)
+        return trace_replay_protocol_version();
+    return pa_context_get_server_protocol_version(context);
+}
 
+pa_proplist *new_client_proplist(void) {
     pa_proplist *proplist = pa_proplist_new();
     pa_proplist_sets(proplist, PA_PROP_APPLICATION_NAME, QObject::tr("PulseAudio Volume Control").toUtf8().constData());
     pa_proplist_sets(proplist, PA_PROP_APPLICATION_ID, "org.PulseAudio.pavucontrol");
     pa_proplist_sets(proplist, PA_PROP_APPLICATION_ICON_NAME, "audio-card");
     pa_proplist_sets(proplist, PA_PROP_APPLICATION_VERSION, PACKAGE_VERSION);
+    return proplist;
+}
+
+gboolean connect_to_pulse(gpointer userdata) {
+    MainWindow *w = static_cast<MainWindow*>(userdata);
 
+    if (context)
+        return false;
+
+    pa_proplist *proplist = new_client_proplist();
     context = pa_context_new_with_proplist(api, nullptr, proplist);
     g_assert(context);
 
@@ -619,22 +774,20 @@ gboolean connect_to_pulse(gpointer userdata) {
     w->setConnectingMessage();
     if (pa_context_connect(context, nullptr, PA_CONTEXT_NOFAIL, nullptr) < 0) {
         if (pa_context_errno(context) == PA_ERR_INVALID) {
-            w->setConnectingMessage(QObject::tr("Connection to PulseAudio failed. Automatic retry in 5s.<br><br>"
+            w->setConnectingMessage(QObject::tr("Connection to PulseAudio failed. Retrying automatically.<br><br>"
                 "In this case this is likely because PULSE_SERVER in the Environment/X11 Root Window Properties"
                 "or default-server in client.conf is misconfigured.<br>"
                 "This situation can also arrise when PulseAudio crashed and left stale details in the X11 Root Window.<br>"
                 "If this is the case, then PulseAudio should autospawn again, or if this is not configured you should"
                 "run start-pulseaudio-x11 manually.").toUtf8().constData());
-            reconnect_timeout = 5;
         }
         else {
             if(!retry) {
-                reconnect_timeout = -1;
+                gave_up = true;
                 qApp->quit();
             } else {
                 g_debug("%s", QObject::tr("Connection failed, attempting reconnect").toUtf8().constData());
-                reconnect_timeout = 5;
-                g_timeout_add_seconds(reconnect_timeout, connect_to_pulse, userdata);
+                schedule_reconnect(w);
             }
         }
     }
@@ -646,6 +799,10 @@ int main(int argc, char *argv[]) {
 
     signal(SIGPIPE, SIG_IGN);
 
+    /* --dump and --apply run without any widgets */
+    if (commands_requested(argc, argv))
+        return commands_main(argc, argv);
+
     QApplication app(argc, argv);
 
     app.setOrganizationName(QStringLiteral("pavucontrol-qt"));
@@ -672,12 +829,37 @@ int main(int argc, char *argv[]) {
     QCommandLineOption tabOption(QStringList() << QStringLiteral("tab") << QStringLiteral("t"), QObject::tr("Select a specific tab on load."), QStringLiteral("tab"));
     parser.addOption(tabOption);
 
-    QCommandLineOption retryOption(QStringList() << QStringLiteral("retry") << QStringLiteral("r"), QObject::tr("Retry forever if pa quits (every 5 seconds)."));
+    QCommandLineOption retryOption(QStringList() << QStringLiteral("retry") << QStringLiteral("r"), QObject::tr("Retry forever if pa quits, waiting longer after each failed attempt (up to 30 seconds)."));
     parser.addOption(retryOption);
 
     QCommandLineOption maximizeOption(QStringList() << QStringLiteral("maximize") << QStringLiteral("m"), QObject::tr("Maximize the window."));
     parser.addOption(maximizeOption);
 
+    QCommandLineOption streamListOption(QStringLiteral("stream-list"), QObject::tr("Show streams in a compact list, for systems with many streams."));
+    parser.addOption(streamListOption);
+
+    QCommandLineOption recordTraceOption(QStringLiteral("record-trace"), QObject::tr("Record everything received from PulseAudio to a trace file."), QStringLiteral("file"));
+    parser.addOption(recordTraceOption);
+
+    QCommandLineOption replayTraceOption(QStringLiteral("replay-trace"), QObject::tr("Replay a trace file instead of connecting to PulseAudio. The window is read-only."), QStringLiteral("file"));
+    parser.addOption(replayTraceOption);
+
+    QCommandLineOption replayFastOption(QStringLiteral("replay-fast"), QObject::tr("Replay the trace as fast as possible, print timings and quit."));
+    parser.addOption(replayFastOption);
+
+    QCommandLineOption controlSocketOption(QStringLiteral("control-socket"), QObject::tr("Accept batches of changes from scripts on a local socket."), QStringLiteral("name"));
+    parser.addOption(controlSocketOption);
+
+    /* Only listed for --help, commands_main() handles them */
+    QCommandLineOption dumpOption(QStringLiteral("dump"), QObject::tr("Print the state of PulseAudio and exit."));
+    parser.addOption(dumpOption);
+
+    QCommandLineOption applyOption(QStringLiteral("apply"), QObject::tr("Apply the changes in a file, or - for standard input, and exit."), QStringLiteral("file"));
+    parser.addOption(applyOption);
+
+    QCommandLineOption formatOption(QStringLiteral("format"), QObject::tr("Output format of --dump, json or text."), QStringLiteral("format"), QStringLiteral("json"));
+    parser.addOption(formatOption);
+
     parser.process(app);
     default_tab = parser.value(tabOption).toInt();
     retry = parser.isSet(retryOption);
@@ -685,6 +867,12 @@ int main(int argc, char *argv[]) {
     // ca_context_set_driver(ca_gtk_context_get(), "pulse");
 
     MainWindow* mainWindow = new MainWindow();
+    mainWindow->setStreamListMode(parser.isSet(streamListOption));
+
+    /* Build the requested tab first, the others are filled when shown */
+    if (default_tab >= 1 && default_tab <= mainWindow->notebook->count())
+        mainWindow->notebook->setCurrentIndex(default_tab - 1);
+
     if(parser.isSet(maximizeOption))
         mainWindow->showMaximized();
 
@@ -693,14 +881,42 @@ int main(int argc, char *argv[]) {
     api = pa_glib_mainloop_get_api(m);
     g_assert(api);
 
-    connect_to_pulse(mainWindow);
-    if (reconnect_timeout >= 0) {
+    if (parser.isSet(replayTraceOption)) {
+        if (!trace_replay_start(mainWindow, parser.value(replayTraceOption).toLocal8Bit().constData(), parser.isSet(replayFastOption))) {
+            QMessageBox::critical(nullptr, QObject::tr("Error"), QObject::tr("Unable to read trace file %1").arg(parser.value(replayTraceOption)));
+            delete mainWindow;
+            pa_glib_mainloop_free(m);
+            return 1;
+        }
+
         mainWindow->show();
         app.exec();
-    }
+    } else {
+        if (parser.isSet(recordTraceOption) && !trace_record_open(parser.value(recordTraceOption).toLocal8Bit().constData())) {
+            QMessageBox::critical(nullptr, QObject::tr("Error"), QObject::tr("Unable to write trace file %1").arg(parser.value(recordTraceOption)));
+            delete mainWindow;
+            pa_glib_mainloop_free(m);
+            return 1;
+        }
+
+        if (parser.isSet(controlSocketOption) && !mainWindow->startControlServer(parser.value(controlSocketOption))) {
+            QMessageBox::critical(nullptr, QObject::tr("Error"), QObject::tr("Unable to listen on control socket %1").arg(parser.value(controlSocketOption)));
+            delete mainWindow;
+            pa_glib_mainloop_free(m);
+            return 1;
+        }
 
-    if (reconnect_timeout < 0)
-        show_error(QObject::tr("Fatal Error: Unable to connect to PulseAudio").toUtf8().constData());
+        connect_to_pulse(mainWindow);
+        if (!gave_up) {
+            mainWindow->show();
+            app.exec();
+        }
+
+        if (gave_up)
+            show_error(QObject::tr("Fatal Error: Unable to connect to PulseAudio").toUtf8().constData());
+
+        trace_record_close();
+    }
 
     delete mainWindow;
 
@@ -61,7 +61,25 @@ enum SourceType {
     SOURCE_MONITOR,
 };
 
+enum NotebookTab {
+    TAB_PLAYBACK,
+    TAB_RECORDING,
+    TAB_OUTPUT_DEVICES,
+    TAB_INPUT_DEVICES,
+    TAB_CONFIGURATION
+};
+
+class MainWindow;
+
 pa_context* get_context(void);
+uint32_t get_server_protocol_version(void);
+/* Properties identifying us to the server, to be freed by the caller */
+pa_proplist *new_client_proplist(void);
 void show_error(const char *txt);
+void request_tab_contents(MainWindow *w, int tab);
+/* Holds back the widget refresh for subscription events until every hold
+ * has been released, so changes to many objects are shown at once */
+void hold_refresh(void);
+void release_refresh(MainWindow *w);
 
 #endif
@@ -0,0 +1,99 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "portavailability.h"
+
+#include <QHash>
+
+PortAvailability::PortAvailability() :
+    mWords(0) {
+}
+
+bool PortAvailability::layoutChanged(const pa_card_info &info) const {
+    if (mProfiles.size() != info.n_profiles || mPorts.size() != info.n_ports)
+        return true;
+
+    for (uint32_t i = 0; i < info.n_profiles; i++)
+        if (mProfiles[i] != info.profiles2[i]->name)
+            return true;
+
+    for (uint32_t i = 0; i < info.n_ports; i++)
+        if (mPorts[i] != info.ports[i]->name)
+            return true;
+
+    return false;
+}
+
+void PortAvailability::rebuild(const pa_card_info &info) {
+    QHash<QByteArray, uint32_t> columns;
+
+    mProfiles.clear();
+    mPorts.clear();
+
+    for (uint32_t i = 0; i < info.n_profiles; i++) {
+        mProfiles.push_back(info.profiles2[i]->name);
+        columns.insert(mProfiles.back(), i);
+    }
+
+    for (uint32_t i = 0; i < info.n_ports; i++)
+        mPorts.push_back(info.ports[i]->name);
+
+    mWords = (info.n_ports + 63) / 64;
+    mMembers.assign(mWords * info.n_profiles, 0);
+    mUnplugged.assign(mWords, 0);
+
+    for (uint32_t port = 0; port < info.n_ports; port++) {
+        for (pa_card_profile_info2 **p = info.ports[port]->profiles2; p && *p; p++) {
+            auto column = columns.constFind(QByteArray((*p)->name));
+            if (column != columns.constEnd())
+                mMembers[*column * mWords + port / 64] |= Q_UINT64_C(1) << (port % 64);
+        }
+    }
+}
+
+void PortAvailability::update(const pa_card_info &info) {
+    if (layoutChanged(info))
+        rebuild(info);
+
+    for (auto & word : mUnplugged)
+        word = 0;
+
+    for (uint32_t port = 0; port < info.n_ports; port++)
+        if (info.ports[port]->available == PA_PORT_AVAILABLE_NO)
+            mUnplugged[port / 64] |= Q_UINT64_C(1) << (port % 64);
+}
+
+bool PortAvailability::unplugged(uint32_t profile) const {
+    /* A card without ports has nothing to unplug */
+    if (mWords == 0)
+        return false;
+
+    const quint64 *members = mMembers.data() + profile * mWords;
+    bool any = false;
+
+    for (size_t i = 0; i < mWords; i++) {
+        if (members[i] & ~mUnplugged[i])
+            return false;
+        any = any || (members[i] & mUnplugged[i]);
+    }
+
+    return any;
+}
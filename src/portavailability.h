@@ -0,0 +1,53 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef portavailability_h
+#define portavailability_h
+
+#include "pavucontrol.h"
+
+#include <QByteArray>
+#include <vector>
+
+/* Which ports of a card each of its profiles uses, one bit per port, and
+ * which ports are unplugged. The matrix only depends on the names of the
+ * profiles and ports, so it is rebuilt when those change and otherwise
+ * only the unplugged bits are refreshed. Whether a profile only has
+ * unplugged ports then takes a few word operations. */
+class PortAvailability {
+public:
+    PortAvailability();
+
+    /* Indexes of profiles follow info.profiles2 */
+    void update(const pa_card_info &info);
+
+    /* The profile has ports, and all of them are unplugged */
+    bool unplugged(uint32_t profile) const;
+
+private:
+    bool layoutChanged(const pa_card_info &info) const;
+    void rebuild(const pa_card_info &info);
+
+    std::vector<QByteArray> mProfiles;
+    std::vector<QByteArray> mPorts;
+    size_t mWords;
+    /* mWords words per profile */
+    std::vector<quint64> mMembers;
+    std::vector<quint64> mUnplugged;
+};
+
+#endif
@@ -0,0 +1,223 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+/* Checks the profile/port bitsets against the rule updateCard used to
+ * apply port by port, on generated cards of many shapes, and prints how
+ * long both take per jack event on a large card */
+
+#include "portavailability.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+/* A card as the server describes it, with everything it points to */
+struct Card {
+    std::vector<std::string> profileNames, portNames;
+    std::vector<pa_card_profile_info2> profiles;
+    std::vector<pa_card_profile_info2*> profilePointers;
+    std::vector<std::vector<pa_card_profile_info2*> > portProfiles;
+    std::vector<pa_card_port_info> ports;
+    std::vector<pa_card_port_info*> portPointers;
+    pa_card_info info;
+};
+
+/* Every port is used by about a quarter of the profiles, and also names
+ * one profile the card does not have */
+static void generate(Card &card, uint32_t n_profiles, uint32_t n_ports) {
+    static pa_card_profile_info2 missing = { "missing", "Missing", 0, 0, 0, 1 };
+
+    card.profileNames.clear();
+    card.portNames.clear();
+    for (uint32_t i = 0; i < n_profiles; i++)
+        card.profileNames.push_back("output:profile-" + std::to_string(i));
+    for (uint32_t i = 0; i < n_ports; i++)
+        card.portNames.push_back("port-" + std::to_string(i));
+
+    card.profiles.assign(n_profiles, pa_card_profile_info2());
+    card.profilePointers.clear();
+    for (uint32_t i = 0; i < n_profiles; i++) {
+        card.profiles[i].name = card.profileNames[i].c_str();
+        card.profiles[i].description = card.profileNames[i].c_str();
+        card.profiles[i].available = 1;
+    }
+    for (auto & profile : card.profiles)
+        card.profilePointers.push_back(&profile);
+    card.profilePointers.push_back(nullptr);
+
+    card.portProfiles.assign(n_ports, std::vector<pa_card_profile_info2*>());
+    card.ports.assign(n_ports, pa_card_port_info());
+    card.portPointers.clear();
+    for (uint32_t i = 0; i < n_ports; i++) {
+        for (uint32_t j = 0; j < n_profiles; j++)
+            if (rand() % 4 == 0)
+                card.portProfiles[i].push_back(&card.profiles[j]);
+        card.portProfiles[i].push_back(&missing);
+        card.portProfiles[i].push_back(nullptr);
+
+        card.ports[i].name = card.portNames[i].c_str();
+        card.ports[i].description = card.portNames[i].c_str();
+        card.ports[i].available = rand() % 3;
+        card.ports[i].profiles2 = card.portProfiles[i].data();
+        card.ports[i].n_profiles = card.portProfiles[i].size() - 1;
+    }
+    for (auto & port : card.ports)
+        card.portPointers.push_back(&port);
+    card.portPointers.push_back(nullptr);
+
+    card.info = pa_card_info();
+    card.info.name = "test_card";
+    card.info.n_profiles = n_profiles;
+    card.info.profiles2 = card.profilePointers.data();
+    card.info.n_ports = n_ports;
+    card.info.ports = card.portPointers.data();
+}
+
+struct PortInfo {
+    int available;
+    std::vector<QByteArray> profiles;
+};
+
+/* What updateCard did before the bitsets: copy the ports with the names
+ * of their profiles, then look for each profile in each port */
+static std::vector<bool> reference(const pa_card_info &info) {
+    std::map<QByteArray, PortInfo> ports;
+    std::vector<bool> unplugged;
+
+    for (uint32_t i = 0; i < info.n_ports; i++) {
+        PortInfo p;
+        p.available = info.ports[i]->available;
+        for (pa_card_profile_info2 **profile = info.ports[i]->profiles2; *profile; profile++)
+            p.profiles.push_back((*profile)->name);
+        ports[info.ports[i]->name] = p;
+    }
+
+    for (uint32_t i = 0; i < info.n_profiles; i++) {
+        bool hasNo = false, hasOther = false;
+
+        for (auto it = ports.begin(); it != ports.end(); it++) {
+            PortInfo port = it->second;
+
+            if (std::find(port.profiles.begin(), port.profiles.end(), info.profiles2[i]->name) == port.profiles.end())
+                continue;
+
+            if (port.available == PA_PORT_AVAILABLE_NO)
+                hasNo = true;
+            else {
+                hasOther = true;
+                break;
+            }
+        }
+
+        unplugged.push_back(hasNo && !hasOther);
+    }
+
+    return unplugged;
+}
+
+static int failures = 0;
+
+static void check(const char *what, const Card &card, const PortAvailability &availability) {
+    const std::vector<bool> expected = reference(card.info);
+
+    for (uint32_t i = 0; i < card.info.n_profiles; i++) {
+        if (availability.unplugged(i) == expected[i])
+            continue;
+
+        if (failures++ < 10)
+            std::fprintf(stderr, "%s: %u profiles, %u ports, profile %u: %d, expected %d\n",
+                         what, card.info.n_profiles, card.info.n_ports, i,
+                         static_cast<int>(availability.unplugged(i)), static_cast<int>(expected[i]));
+    }
+}
+
+template<typename F>
+static double us_per_update(int rounds, F f) {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; i++)
+        f(i);
+
+    const std::chrono::duration<double, std::micro> took = std::chrono::steady_clock::now() - start;
+    return took.count() / rounds;
+}
+
+int main() {
+    const uint32_t shapes[][2] = {
+        { 0, 0 }, { 1, 0 }, { 3, 1 }, { 5, 63 }, { 5, 64 }, { 5, 65 }, { 60, 20 }, { 80, 130 },
+    };
+
+    srand(1);
+
+    for (auto & shape : shapes) {
+        for (int round = 0; round < 20; round++) {
+            PortAvailability availability;
+            Card card;
+
+            generate(card, shape[0], shape[1]);
+            availability.update(card.info);
+            check("built", card, availability);
+
+            /* Jack events only change what is plugged in */
+            for (int event = 0; event < 20 && shape[1] > 0; event++) {
+                card.ports[rand() % shape[1]].available = rand() % 3;
+                availability.update(card.info);
+                check("updated", card, availability);
+            }
+
+            /* A profile change can bring other ports */
+            generate(card, shape[0], shape[1] + 1);
+            availability.update(card.info);
+            check("rebuilt", card, availability);
+        }
+    }
+
+    /* An HDMI or USB card of the size that made jack events slow */
+    {
+        const int rounds = 2000;
+        PortAvailability availability;
+        Card card;
+        volatile bool sink = false;
+
+        generate(card, 64, 24);
+        availability.update(card.info);
+
+        const double before = us_per_update(rounds, [&] (int i) {
+            card.ports[i % 24].available = rand() % 3;
+            sink = reference(card.info)[i % 64];
+        });
+        const double after = us_per_update(rounds, [&] (int i) {
+            card.ports[i % 24].available = rand() % 3;
+            availability.update(card.info);
+            for (uint32_t profile = 0; profile < 64; profile++)
+                sink = availability.unplugged(profile);
+        });
+
+        std::printf("64 profiles, 24 ports: reference %.2f us/update, bitsets %.2f us/update\n", before, after);
+    }
+
+    if (failures) {
+        std::fprintf(stderr, "%d mismatches\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
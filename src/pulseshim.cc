@@ -0,0 +1,1863 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* A stand-in for the parts of libpulse that talk to a server, linked into
+ * the test build of the application in their place. It plays a server
+ * with a scripted set of objects and a scripted stream of changes, and at
+ * the end prints how long the window took to take in each change and what
+ * it allocated per change, and checks the window against the server.
+ * Volumes, channel maps and property lists are plain data helpers and still
+ * come from libpulse.
+ *
+ * The script is read from $PULSESHIM_SCRIPT as "key=value,...":
+ *   cards, sinks, sources, streams, recordings  objects present at the start
+ *   events, rate    changes made after connecting, and how many per second
+ *   latency         milliseconds before the server answers a request
+ *   settle          milliseconds between connecting and the first change
+ *   meters          whether monitor streams deliver data
+ *   seed            the same script and seed give the same changes
+ *   p95, p99        limits in milliseconds on the update latency, 0 for none
+ *
+ * When every change has reached the window, or after five seconds without
+ * progress, the report is printed and the server goes away, which quits
+ * the application. The last line of the report is "pulseshim: passed" or
+ * "pulseshim: FAILED, " and what went wrong. */
+
+#include <pulse/pulseaudio.h>
+#include <pulse/glib-mainloop.h>
+#include <pulse/ext-stream-restore.h>
+#include <pulse/ext-device-manager.h>
+#if PA_CHECK_VERSION(0,99,0)
+#  include <pulse/ext-device-restore.h>
+#endif
+
+#include "mainwindow.h"
+#include "sinkwidget.h"
+#include "sourcewidget.h"
+#include "sinkinputwidget.h"
+#include "sourceoutputwidget.h"
+
+#include <QApplication>
+
+#include <glib.h>
+#include <malloc.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*** Allocation accounting ***/
+
+/* Each request of the window allocates an operation, which the shim counts
+ * itself. What the window keeps of the answers shows as growth of the heap,
+ * sampled where glibc can tell. */
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+static bool heap_in_use(size_t &bytes) {
+    const struct mallinfo2 m = mallinfo2();
+
+    bytes = m.uordblks + m.hblkhd;
+    return true;
+}
+#else
+static bool heap_in_use(size_t &bytes) {
+    bytes = 0;
+    return false;
+}
+#endif
+
+/*** Script ***/
+
+struct ShimScript {
+    unsigned cards = 1;
+    unsigned sinks = 2;
+    unsigned sources = 1;
+    unsigned streams = 20;
+    unsigned recordings = 2;
+    unsigned events = 500;
+    unsigned rate = 100;
+    unsigned latency = 1;
+    unsigned settle = 1000;
+    unsigned meters = 1;
+    unsigned seed = 1;
+    unsigned p95 = 0;
+    unsigned p99 = 0;
+};
+
+static bool parse_script(const char *text, ShimScript &script) {
+    const struct {
+        const char *key;
+        unsigned *value;
+    } keys[] = {
+        { "cards", &script.cards },
+        { "sinks", &script.sinks },
+        { "sources", &script.sources },
+        { "streams", &script.streams },
+        { "recordings", &script.recordings },
+        { "events", &script.events },
+        { "rate", &script.rate },
+        { "latency", &script.latency },
+        { "settle", &script.settle },
+        { "meters", &script.meters },
+        { "seed", &script.seed },
+        { "p95", &script.p95 },
+        { "p99", &script.p99 },
+    };
+    gchar **items = g_strsplit(text ? text : "", ",", -1);
+    bool ok = true;
+
+    for (gchar **item = items; ok && *item; item++) {
+        gchar *eq = strchr(*item, '=');
+        char *end;
+        bool known = false;
+
+        if (!**item)
+            continue;
+
+        if (!eq) {
+            ok = false;
+            break;
+        }
+        *eq = 0;
+
+        for (auto & k : keys) {
+            if (strcmp(k.key, *item) == 0) {
+                *k.value = strtoul(eq + 1, &end, 10);
+                known = !*end && end != eq + 1;
+            }
+        }
+
+        ok = known;
+    }
+
+    g_strfreev(items);
+
+    /* The card ports are what the devices are spread over */
+    if (script.cards == 0 && (script.sinks || script.sources))
+        ok = false;
+
+    return ok && script.rate > 0;
+}
+
+/*** Objects ***/
+
+struct ShimDevice {
+    std::string name;
+    std::string description;
+    uint32_t card;
+    pa_channel_map map;
+    pa_cvolume volume;
+    int mute;
+    /* The monitor source of a sink, the sink of a monitor source */
+    uint32_t monitor;
+    /* Names of the card ports it has, and the active one */
+    std::vector<std::string> ports;
+    std::string active_port;
+    pa_proplist *proplist;
+};
+
+struct ShimStream {
+    std::string name;
+    uint32_t client;
+    uint32_t device;
+    pa_channel_map map;
+    pa_cvolume volume;
+    int mute;
+    int corked;
+    pa_proplist *proplist;
+};
+
+struct ShimClient {
+    std::string name;
+    pa_proplist *proplist;
+};
+
+struct ShimPort {
+    const char *name;
+    const char *description;
+    int direction;
+};
+
+static const ShimPort card_ports[] = {
+    { "analog-output-speaker", "Speakers", PA_DIRECTION_OUTPUT },
+    { "analog-output-headphones", "Headphones", PA_DIRECTION_OUTPUT },
+    { "analog-input-mic", "Microphone", PA_DIRECTION_INPUT },
+};
+
+struct ShimCard {
+    std::string name;
+    std::string active_profile;
+    pa_proplist *proplist;
+    int64_t latency_offsets[G_N_ELEMENTS(card_ports)];
+};
+
+struct ShimProfile {
+    const char *name;
+    const char *description;
+    uint32_t n_sinks, n_sources, priority;
+};
+
+static const ShimProfile card_profiles[] = {
+    { "output:analog-stereo+input:analog-stereo", "Analog Stereo Duplex", 1, 1, 6565 },
+    { "output:analog-stereo", "Analog Stereo Output", 1, 0, 6500 },
+    { "off", "Off", 0, 0, 0 },
+};
+
+/*** Operations and loops ***/
+
+struct pa_operation {
+    int ref;
+    bool cancelled;
+    pa_context *context;
+    std::function<void()> reply;
+};
+
+/* The api of both loops carries their GMainContext as userdata */
+struct pa_glib_mainloop {
+    pa_mainloop_api api;
+};
+
+struct pa_mainloop {
+    pa_mainloop_api api;
+    GMainLoop *loop;
+    int retval;
+};
+
+struct pa_context {
+    int ref;
+    GMainContext *loop;
+    pa_context_state_t state;
+    int error;
+    pa_context_notify_cb_t state_cb;
+    void *state_userdata;
+    pa_context_subscribe_cb_t subscribe_cb;
+    void *subscribe_userdata;
+    pa_subscription_mask_t mask;
+    std::set<pa_operation*> pending;
+};
+
+struct pa_stream {
+    int ref;
+    pa_context *context;
+    pa_sample_spec ss;
+    pa_channel_map map;
+    pa_stream_state_t state;
+    uint32_t monitor_stream;
+    uint32_t source;
+    int corked;
+    size_t fragsize;
+    std::vector<char> data;
+    double phase;
+    guint timer;
+    pa_stream_notify_cb_t state_cb;
+    void *state_userdata;
+    pa_stream_request_cb_t read_cb;
+    void *read_userdata;
+    pa_stream_notify_cb_t suspended_cb;
+    void *suspended_userdata;
+};
+
+static guint add_timeout(GMainContext *loop, unsigned ms, GSourceFunc f, gpointer data) {
+    GSource *source = ms ? g_timeout_source_new(ms) : g_idle_source_new();
+    guint id;
+
+    g_source_set_callback(source, f, data, nullptr);
+    id = g_source_attach(source, loop);
+    g_source_unref(source);
+
+    return id;
+}
+
+static void remove_timeout(GMainContext *loop, guint id) {
+    GSource *source = g_main_context_find_source_by_id(loop, id);
+
+    if (source)
+        g_source_destroy(source);
+}
+
+/*** The server ***/
+
+class Shim {
+public:
+    ~Shim();
+
+    ShimScript script;
+    GRand *rand = nullptr;
+
+    std::map<uint32_t, ShimCard> cards;
+    std::map<uint32_t, ShimDevice> sinks;
+    std::map<uint32_t, ShimDevice> sources;
+    std::map<uint32_t, ShimStream> sinkInputs;
+    std::map<uint32_t, ShimStream> sourceOutputs;
+    std::map<uint32_t, ShimClient> clients;
+    std::string defaultSink, defaultSource;
+    uint32_t nextStream = 0, nextClient = 0;
+
+    std::set<pa_context*> contexts;
+    std::set<pa_stream*> streams;
+
+    /* Peak fragments handed to the window, and the time it took to route
+     * them to the meters */
+    unsigned long fragments = 0;
+    gint64 fragmentTime = 0;
+
+    void load();
+    void start(GMainContext *loop);
+
+    pa_operation *reply(pa_context *c, const std::function<void()> &f);
+    void post(pa_subscription_event_type_t t, uint32_t index);
+
+    /* A change made by the script, timed until the window took it in */
+    void scripted(pa_subscription_event_type_t t, uint32_t index);
+    void delivered(pa_subscription_event_type_t facility, uint32_t index);
+
+private:
+    /* With a new client unless one is given */
+    uint32_t addSinkInput(uint32_t sink, uint32_t client = PA_INVALID_INDEX);
+    void addSourceOutput(uint32_t source);
+    void changeVolume(pa_cvolume &volume);
+    void step();
+    void finish();
+    /* What in the window does not match the server, if anything */
+    const char *checkWindow() const;
+
+    static gboolean settle_cb(gpointer userdata);
+    static gboolean step_cb(gpointer userdata);
+    static gboolean watch_cb(gpointer userdata);
+
+    GMainContext *mLoop = nullptr;
+    bool mStarted = false, mFinished = false;
+    unsigned mEmitted = 0;
+    gint64 mStart = 0, mLastProgress = 0;
+    unsigned long mOperations = 0, mOperationsAtStart = 0;
+    size_t mHeapAtStart = 0;
+
+    std::map<std::pair<int, uint32_t>, gint64> mWaiting;
+    std::vector<gint64> mLatencies;
+    unsigned mCoalesced = 0;
+};
+
+static Shim shim;
+
+static pa_proplist *proplist_with(const char *key, const char *value) {
+    pa_proplist *p = pa_proplist_new();
+    pa_proplist_sets(p, key, value);
+    return p;
+}
+
+void Shim::changeVolume(pa_cvolume &volume) {
+    pa_cvolume_set(&volume, volume.channels, g_rand_int_range(rand, PA_VOLUME_MUTED, PA_VOLUME_NORM + 1));
+}
+
+uint32_t Shim::addSinkInput(uint32_t sink, uint32_t client) {
+    const uint32_t index = nextStream++;
+    char text[64];
+
+    if (client == PA_INVALID_INDEX) {
+        client = nextClient++;
+        snprintf(text, sizeof(text), "Application %u", client);
+        ShimClient &c = clients[client];
+        c.name = text;
+        c.proplist = proplist_with(PA_PROP_APPLICATION_NAME, text);
+        snprintf(text, sizeof(text), "%u", 1000 + client);
+        pa_proplist_sets(c.proplist, PA_PROP_APPLICATION_PROCESS_ID, text);
+    }
+
+    snprintf(text, sizeof(text), "Playback %u", index);
+    ShimStream &s = sinkInputs[index];
+    s.name = text;
+    s.client = client;
+    s.device = sink;
+    pa_channel_map_init_stereo(&s.map);
+    pa_cvolume_set(&s.volume, 2, PA_VOLUME_NORM);
+    s.mute = 0;
+    s.corked = 0;
+    s.proplist = pa_proplist_copy(clients[client].proplist);
+
+    return index;
+}
+
+void Shim::addSourceOutput(uint32_t source) {
+    const uint32_t index = nextStream++;
+    const uint32_t client = nextClient++;
+    char text[64];
+
+    snprintf(text, sizeof(text), "Recorder %u", client);
+    ShimClient &c = clients[client];
+    c.name = text;
+    c.proplist = proplist_with(PA_PROP_APPLICATION_NAME, text);
+
+    snprintf(text, sizeof(text), "Recording %u", index);
+    ShimStream &s = sourceOutputs[index];
+    s.name = text;
+    s.client = client;
+    s.device = source;
+    pa_channel_map_init_mono(&s.map);
+    pa_cvolume_set(&s.volume, 1, PA_VOLUME_NORM);
+    s.mute = 0;
+    s.corked = 0;
+    s.proplist = pa_proplist_copy(c.proplist);
+}
+
+Shim::~Shim() {
+    for (auto &i : cards)
+        pa_proplist_free(i.second.proplist);
+    for (auto &i : sinks)
+        pa_proplist_free(i.second.proplist);
+    for (auto &i : sources)
+        pa_proplist_free(i.second.proplist);
+    for (auto &i : sinkInputs)
+        pa_proplist_free(i.second.proplist);
+    for (auto &i : sourceOutputs)
+        pa_proplist_free(i.second.proplist);
+    for (auto &i : clients)
+        pa_proplist_free(i.second.proplist);
+
+    if (rand)
+        g_rand_free(rand);
+}
+
+void Shim::load() {
+    const char *text = getenv("PULSESHIM_SCRIPT");
+    char name[64];
+
+    if (rand)
+        return;
+
+    if (!parse_script(text, script)) {
+        fprintf(stderr, "pulseshim: invalid script \"%s\"\n", text);
+        exit(2);
+    }
+
+    rand = g_rand_new_with_seed(script.seed);
+
+    for (uint32_t i = 0; i < script.cards; i++) {
+        ShimCard &c = cards[i];
+        snprintf(name, sizeof(name), "shim_card.%u", i);
+        c.name = name;
+        c.active_profile = card_profiles[0].name;
+        snprintf(name, sizeof(name), "Sound Card %u", i);
+        c.proplist = proplist_with(PA_PROP_DEVICE_DESCRIPTION, name);
+        for (auto & offset : c.latency_offsets)
+            offset = 0;
+    }
+
+    /* A monitor source for every sink, with the same index */
+    for (uint32_t i = 0; i < script.sinks + script.sources; i++) {
+        const bool is_sink = i < script.sinks;
+        ShimDevice &d = sources[i];
+
+        snprintf(name, sizeof(name), is_sink ? "shim_output.%u.monitor" : "shim_input.%u", i);
+        d.name = name;
+        snprintf(name, sizeof(name), is_sink ? "Monitor of Output %u" : "Input %u", i);
+        d.description = name;
+        d.card = i % script.cards;
+        pa_channel_map_init_stereo(&d.map);
+        pa_cvolume_set(&d.volume, 2, PA_VOLUME_NORM);
+        d.mute = 0;
+        d.monitor = is_sink ? i : PA_INVALID_INDEX;
+        if (!is_sink)
+            d.ports.push_back(card_ports[2].name);
+        d.active_port = is_sink ? "" : card_ports[2].name;
+        d.proplist = proplist_with(PA_PROP_DEVICE_ICON_NAME, "audio-input-microphone");
+
+        if (!is_sink)
+            continue;
+
+        ShimDevice &s = sinks[i];
+        snprintf(name, sizeof(name), "shim_output.%u", i);
+        s.name = name;
+        snprintf(name, sizeof(name), "Output %u", i);
+        s.description = name;
+        s.card = i % script.cards;
+        pa_channel_map_init_stereo(&s.map);
+        pa_cvolume_set(&s.volume, 2, PA_VOLUME_NORM);
+        s.mute = 0;
+        s.monitor = i;
+        s.ports.push_back(card_ports[0].name);
+        s.ports.push_back(card_ports[1].name);
+        s.active_port = card_ports[0].name;
+        s.proplist = proplist_with(PA_PROP_DEVICE_ICON_NAME, "audio-card");
+    }
+
+    if (!sinks.empty())
+        defaultSink = sinks.begin()->second.name;
+    if (script.sources)
+        defaultSource = sources.rbegin()->second.name;
+
+    for (uint32_t i = 0; i < script.streams && !sinks.empty(); i++)
+        addSinkInput(i % sinks.size());
+
+    for (uint32_t i = 0; i < script.recordings && !sources.empty(); i++)
+        addSourceOutput(i % sources.size());
+}
+
+pa_operation *Shim::reply(pa_context *c, const std::function<void()> &f) {
+    pa_operation *o = new pa_operation;
+
+    mOperations++;
+
+    /* One reference for the caller, one until the answer is in */
+    o->ref = 2;
+    o->cancelled = false;
+    o->context = c;
+    o->reply = f;
+    c->pending.insert(o);
+
+    add_timeout(c->loop, script.latency, [] (gpointer userdata) -> gboolean {
+        pa_operation *o = static_cast<pa_operation*>(userdata);
+
+        if (!o->cancelled) {
+            o->context->pending.erase(o);
+            o->reply();
+        }
+
+        pa_operation_unref(o);
+        return FALSE;
+    }, o);
+
+    return o;
+}
+
+static pa_subscription_mask_t mask_of(pa_subscription_event_type_t facility) {
+    return static_cast<pa_subscription_mask_t>(1 << facility);
+}
+
+void Shim::post(pa_subscription_event_type_t t, uint32_t index) {
+    const pa_subscription_event_type_t facility = static_cast<pa_subscription_event_type_t>(t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK);
+
+    for (pa_context *c : std::vector<pa_context*>(contexts.begin(), contexts.end())) {
+        if (c->state != PA_CONTEXT_READY || !c->subscribe_cb || !(c->mask & mask_of(facility)))
+            continue;
+
+        pa_context_ref(c);
+        c->subscribe_cb(c, t, index, c->subscribe_userdata);
+        pa_context_unref(c);
+    }
+}
+
+void Shim::scripted(pa_subscription_event_type_t t, uint32_t index) {
+    const int facility = t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK;
+    const std::pair<int, uint32_t> key(facility, index);
+
+    /* A change the window has not taken in yet is timed from the first */
+    if (!mWaiting.insert(std::make_pair(key, g_get_monotonic_time())).second)
+        mCoalesced++;
+
+    post(t, index);
+
+    /* Removals need no answer from the server */
+    if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) == PA_SUBSCRIPTION_EVENT_REMOVE)
+        delivered(static_cast<pa_subscription_event_type_t>(facility), index);
+}
+
+void Shim::delivered(pa_subscription_event_type_t facility, uint32_t index) {
+    auto it = mWaiting.find(std::make_pair(static_cast<int>(facility), index));
+
+    if (it == mWaiting.end())
+        return;
+
+    mLastProgress = g_get_monotonic_time();
+    mLatencies.push_back(mLastProgress - it->second);
+    mWaiting.erase(it);
+}
+
+void Shim::start(GMainContext *loop) {
+    if (mStarted)
+        return;
+
+    mStarted = true;
+    mLoop = loop;
+    add_timeout(loop, script.settle, settle_cb, this);
+}
+
+gboolean Shim::settle_cb(gpointer userdata) {
+    Shim *s = static_cast<Shim*>(userdata);
+
+    s->mStart = s->mLastProgress = g_get_monotonic_time();
+    s->mOperationsAtStart = s->mOperations;
+    heap_in_use(s->mHeapAtStart);
+    add_timeout(s->mLoop, std::max(1u, 1000 / s->script.rate), step_cb, s);
+    add_timeout(s->mLoop, 100, watch_cb, s);
+
+    return FALSE;
+}
+
+/* Mostly stream volumes, as when an application fades, with some device
+ * volumes and some streams coming and going */
+void Shim::step() {
+    const unsigned kind = g_rand_int_range(rand, 0, 100);
+
+    if (kind < 10 && !sinks.empty()) {
+        auto it = sinks.find(g_rand_int_range(rand, 0, sinks.size()));
+        changeVolume(it->second.volume);
+        scripted(static_cast<pa_subscription_event_type_t>(PA_SUBSCRIPTION_EVENT_SINK | PA_SUBSCRIPTION_EVENT_CHANGE), it->first);
+    } else if (kind < 15 && !sinkInputs.empty()) {
+        /* Another stream of the same application takes its place */
+        auto it = sinkInputs.begin();
+        std::advance(it, g_rand_int_range(rand, 0, sinkInputs.size()));
+        const uint32_t index = it->first, client = it->second.client, sink = it->second.device;
+
+        pa_proplist_free(it->second.proplist);
+        sinkInputs.erase(it);
+        scripted(static_cast<pa_subscription_event_type_t>(PA_SUBSCRIPTION_EVENT_SINK_INPUT | PA_SUBSCRIPTION_EVENT_REMOVE), index);
+
+        scripted(static_cast<pa_subscription_event_type_t>(PA_SUBSCRIPTION_EVENT_SINK_INPUT | PA_SUBSCRIPTION_EVENT_NEW),
+                 addSinkInput(sink, client));
+    } else if (kind < 20 && !sourceOutputs.empty()) {
+        auto it = sourceOutputs.begin();
+        std::advance(it, g_rand_int_range(rand, 0, sourceOutputs.size()));
+        changeVolume(it->second.volume);
+        scripted(static_cast<pa_subscription_event_type_t>(PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT | PA_SUBSCRIPTION_EVENT_CHANGE), it->first);
+    } else if (!sinkInputs.empty()) {
+        auto it = sinkInputs.begin();
+        std::advance(it, g_rand_int_range(rand, 0, sinkInputs.size()));
+        changeVolume(it->second.volume);
+        scripted(static_cast<pa_subscription_event_type_t>(PA_SUBSCRIPTION_EVENT_SINK_INPUT | PA_SUBSCRIPTION_EVENT_CHANGE), it->first);
+    }
+
+    mEmitted++;
+}
+
+gboolean Shim::step_cb(gpointer userdata) {
+    Shim *s = static_cast<Shim*>(userdata);
+    const gint64 elapsed = g_get_monotonic_time() - s->mStart;
+    const unsigned due = std::min<gint64>(s->script.events, elapsed * s->script.rate / G_USEC_PER_SEC + 1);
+
+    while (s->mEmitted < due)
+        s->step();
+
+    return s->mEmitted < s->script.events && !s->mFinished;
+}
+
+gboolean Shim::watch_cb(gpointer userdata) {
+    Shim *s = static_cast<Shim*>(userdata);
+    const bool done = s->mEmitted == s->script.events && s->mWaiting.empty();
+
+    if (!done && g_get_monotonic_time() - s->mLastProgress < 5 * G_USEC_PER_SEC)
+        return TRUE;
+
+    s->finish();
+    return FALSE;
+}
+
+static double percentile(const std::vector<gint64> &sorted, double p) {
+    if (sorted.empty())
+        return 0;
+
+    return sorted[std::min<size_t>(sorted.size() - 1, sorted.size() * p)] / 1000.0;
+}
+
+template<typename Map, typename Object>
+static bool same_indexes(const Map &known, const std::map<uint32_t, Object> &objects) {
+    if (known.size() != objects.size())
+        return false;
+
+    for (auto &i : objects)
+        if (!known.count(i.first))
+            return false;
+
+    return true;
+}
+
+/* Widgets only exist on the tabs that were shown, there they must be one
+ * per object and show its volume */
+template<typename Widget, typename Object>
+static bool same_volumes(const std::map<uint32_t, Widget*> &widgets, const std::map<uint32_t, Object> &objects, bool built) {
+    if (built && widgets.size() != objects.size())
+        return false;
+
+    for (auto &i : widgets) {
+        auto it = objects.find(i.first);
+
+        if (it == objects.end() || !pa_cvolume_equal(&i.second->volume, &it->second.volume))
+            return false;
+    }
+
+    return true;
+}
+
+const char *Shim::checkWindow() const {
+    MainWindow *w = nullptr;
+
+    for (QWidget *widget : QApplication::topLevelWidgets())
+        if ((w = qobject_cast<MainWindow*>(widget)))
+            break;
+
+    if (!w)
+        return "there is no window";
+    if (!same_indexes(w->cardPorts, cards))
+        return "the cards differ";
+    if (!same_indexes(w->sinks, sinks))
+        return "the sinks differ";
+    if (!same_indexes(w->sources, sources))
+        return "the sources differ";
+    if (!same_indexes(w->sinkInputIndexes, sinkInputs))
+        return "the playback streams differ";
+    if (!same_indexes(w->sourceOutputIndexes, sourceOutputs))
+        return "the recording streams differ";
+    if (!same_indexes(w->clients, clients))
+        return "the clients differ";
+    if (!same_volumes(w->sinkWidgets, sinks, w->isTabBuilt(TAB_OUTPUT_DEVICES)))
+        return "the output device widgets differ";
+    if (!same_volumes(w->sourceWidgets, sources, w->isTabBuilt(TAB_INPUT_DEVICES)))
+        return "the input device widgets differ";
+    if (!same_volumes(w->sinkInputWidgets, sinkInputs, w->isTabBuilt(TAB_PLAYBACK)))
+        return "the playback stream widgets differ";
+    if (!same_volumes(w->sourceOutputWidgets, sourceOutputs, w->isTabBuilt(TAB_RECORDING)))
+        return "the recording stream widgets differ";
+
+    return nullptr;
+}
+
+void Shim::finish() {
+    const unsigned long operations = mOperations - mOperationsAtStart;
+    std::vector<gint64> sorted = mLatencies;
+    const char *problem = nullptr;
+    size_t heap;
+
+    mFinished = true;
+    std::sort(sorted.begin(), sorted.end());
+
+    const double p95 = percentile(sorted, 0.95), p99 = percentile(sorted, 0.99);
+
+    printf("pulseshim: %u cards, %u sinks, %u sources, %u streams, %u recordings, %u events at %u/s, %u ms server latency\n",
+           script.cards, script.sinks, script.sources, script.streams, script.recordings, script.events, script.rate, script.latency);
+    printf("pulseshim: update latency median %.2f ms, 95th percentile %.2f ms, 99th percentile %.2f ms, max %.2f ms\n",
+           percentile(sorted, 0.5), p95, p99, percentile(sorted, 1));
+    if (mEmitted) {
+        printf("pulseshim: %.1f operations allocated per event\n", static_cast<double>(operations) / mEmitted);
+        if (heap_in_use(heap))
+            printf("pulseshim: heap grew by %.0f bytes per event\n",
+                   (static_cast<double>(heap) - static_cast<double>(mHeapAtStart)) / mEmitted);
+    }
+    printf("pulseshim: %u events coalesced with one still on its way\n", mCoalesced);
+    if (fragments)
+        printf("pulseshim: %zu peak streams, %lu fragments read at %.2f us each\n",
+               streams.size(), fragments, static_cast<double>(fragmentTime) / fragments);
+
+    if (mWaiting.empty() && mEmitted == script.events)
+        printf("pulseshim: all %zu updates arrived\n", mLatencies.size());
+    else {
+        printf("pulseshim: %zu updates never arrived, %u of %u events sent\n", mWaiting.size(), mEmitted, script.events);
+        problem = "not every update arrived";
+    }
+
+    if (!problem && script.p95 && p95 > script.p95)
+        problem = "the 95th percentile is over the limit";
+    if (!problem && script.p99 && p99 > script.p99)
+        problem = "the 99th percentile is over the limit";
+    if (!problem)
+        problem = checkWindow();
+
+    if (problem)
+        printf("pulseshim: FAILED, %s\n", problem);
+    else
+        printf("pulseshim: passed\n");
+    fflush(stdout);
+
+    /* The server goes away, the application quits */
+    for (pa_context *c : std::vector<pa_context*>(contexts.begin(), contexts.end())) {
+        if (c->state != PA_CONTEXT_READY)
+            continue;
+
+        c->state = PA_CONTEXT_TERMINATED;
+        pa_context_ref(c);
+        if (c->state_cb)
+            c->state_cb(c, c->state_userdata);
+        pa_context_unref(c);
+    }
+}
+
+/*** Mainloops ***/
+
+extern "C" {
+
+pa_glib_mainloop *pa_glib_mainloop_new(GMainContext *c) {
+    pa_glib_mainloop *m = new pa_glib_mainloop;
+
+    memset(&m->api, 0, sizeof(m->api));
+    m->api.userdata = c ? c : g_main_context_default();
+
+    return m;
+}
+
+void pa_glib_mainloop_free(pa_glib_mainloop *g) {
+    delete g;
+}
+
+pa_mainloop_api *pa_glib_mainloop_get_api(pa_glib_mainloop *g) {
+    return &g->api;
+}
+
+pa_mainloop *pa_mainloop_new(void) {
+    pa_mainloop *m = new pa_mainloop;
+
+    memset(&m->api, 0, sizeof(m->api));
+    m->api.userdata = g_main_context_default();
+    m->loop = g_main_loop_new(g_main_context_default(), FALSE);
+    m->retval = 0;
+
+    return m;
+}
+
+void pa_mainloop_free(pa_mainloop *m) {
+    g_main_loop_unref(m->loop);
+    delete m;
+}
+
+pa_mainloop_api *pa_mainloop_get_api(pa_mainloop *m) {
+    return &m->api;
+}
+
+int pa_mainloop_run(pa_mainloop *m, int *retval) {
+    g_main_loop_run(m->loop);
+
+    if (retval)
+        *retval = m->retval;
+    return m->retval;
+}
+
+void pa_mainloop_quit(pa_mainloop *m, int retval) {
+    m->retval = retval;
+    g_main_loop_quit(m->loop);
+}
+
+/*** Context ***/
+
+pa_context *pa_context_new_with_proplist(pa_mainloop_api *mainloop, const char *, const pa_proplist *) {
+    pa_context *c = new pa_context;
+
+    shim.load();
+
+    c->ref = 1;
+    c->loop = static_cast<GMainContext*>(mainloop->userdata);
+    c->state = PA_CONTEXT_UNCONNECTED;
+    c->error = PA_OK;
+    c->state_cb = nullptr;
+    c->state_userdata = nullptr;
+    c->subscribe_cb = nullptr;
+    c->subscribe_userdata = nullptr;
+    c->mask = PA_SUBSCRIPTION_MASK_NULL;
+    shim.contexts.insert(c);
+
+    return c;
+}
+
+pa_context *pa_context_ref(pa_context *c) {
+    c->ref++;
+    return c;
+}
+
+void pa_context_unref(pa_context *c) {
+    if (--c->ref > 0)
+        return;
+
+    for (pa_operation *o : c->pending)
+        o->cancelled = true;
+
+    shim.contexts.erase(c);
+    delete c;
+}
+
+void pa_context_set_state_callback(pa_context *c, pa_context_notify_cb_t cb, void *userdata) {
+    c->state_cb = cb;
+    c->state_userdata = userdata;
+}
+
+int pa_context_errno(const pa_context *c) {
+    return c ? c->error : PA_ERR_INVALID;
+}
+
+pa_context_state_t pa_context_get_state(const pa_context *c) {
+    return c->state;
+}
+
+uint32_t pa_context_get_server_protocol_version(const pa_context *) {
+    return PA_PROTOCOL_VERSION;
+}
+
+static void set_state(pa_context *c, pa_context_state_t state) {
+    c->state = state;
+
+    pa_context_ref(c);
+    if (c->state_cb)
+        c->state_cb(c, c->state_userdata);
+    pa_context_unref(c);
+}
+
+int pa_context_connect(pa_context *c, const char *, pa_context_flags_t, const pa_spawn_api *) {
+    if (c->state != PA_CONTEXT_UNCONNECTED) {
+        c->error = PA_ERR_BADSTATE;
+        return -1;
+    }
+
+    set_state(c, PA_CONTEXT_CONNECTING);
+
+    pa_operation_unref(shim.reply(c, [c] {
+        set_state(c, PA_CONTEXT_AUTHORIZING);
+        set_state(c, PA_CONTEXT_SETTING_NAME);
+        set_state(c, PA_CONTEXT_READY);
+
+        if (c->state == PA_CONTEXT_READY)
+            shim.start(c->loop);
+    }));
+
+    return 0;
+}
+
+void pa_context_disconnect(pa_context *c) {
+    if (c->state == PA_CONTEXT_TERMINATED || c->state == PA_CONTEXT_FAILED)
+        return;
+
+    for (pa_operation *o : c->pending)
+        o->cancelled = true;
+    c->pending.clear();
+
+    set_state(c, PA_CONTEXT_TERMINATED);
+}
+
+pa_operation *pa_context_subscribe(pa_context *c, pa_subscription_mask_t m, pa_context_success_cb_t cb, void *userdata) {
+    c->mask = m;
+
+    return shim.reply(c, [c, cb, userdata] {
+        if (cb)
+            cb(c, 1, userdata);
+    });
+}
+
+void pa_context_set_subscribe_callback(pa_context *c, pa_context_subscribe_cb_t cb, void *userdata) {
+    c->subscribe_cb = cb;
+    c->subscribe_userdata = userdata;
+}
+
+/*** Operations ***/
+
+pa_operation *pa_operation_ref(pa_operation *o) {
+    o->ref++;
+    return o;
+}
+
+void pa_operation_unref(pa_operation *o) {
+    if (--o->ref == 0)
+        delete o;
+}
+
+void pa_operation_cancel(pa_operation *o) {
+    if (o->cancelled)
+        return;
+
+    o->cancelled = true;
+    o->context->pending.erase(o);
+}
+
+pa_operation_state_t pa_operation_get_state(const pa_operation *o) {
+    if (o->cancelled)
+        return PA_OPERATION_CANCELLED;
+
+    return o->context->pending.count(const_cast<pa_operation*>(o)) ? PA_OPERATION_RUNNING : PA_OPERATION_DONE;
+}
+
+}
+
+/*** Introspection ***/
+
+extern "C" {
+
+static void fill_server(pa_server_info &i) {
+    i.user_name = "shim";
+    i.host_name = "localhost";
+    i.server_version = pa_get_library_version();
+    i.server_name = "pulseshim";
+    i.sample_spec.format = PA_SAMPLE_FLOAT32;
+    i.sample_spec.rate = 48000;
+    i.sample_spec.channels = 2;
+    i.default_sink_name = shim.defaultSink.empty() ? nullptr : shim.defaultSink.c_str();
+    i.default_source_name = shim.defaultSource.empty() ? nullptr : shim.defaultSource.c_str();
+    i.cookie = 1;
+    pa_channel_map_init_stereo(&i.channel_map);
+}
+
+pa_operation *pa_context_get_server_info(pa_context *c, pa_server_info_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        pa_server_info i{};
+        fill_server(i);
+        cb(c, &i, userdata);
+        shim.delivered(PA_SUBSCRIPTION_EVENT_SERVER, PA_INVALID_INDEX);
+    });
+}
+
+}
+
+/* Keeps what an info struct points to until its callback returned */
+template<typename Port>
+struct PortList {
+    std::vector<Port> ports;
+    std::vector<Port*> pointers;
+
+    void fill(const ShimDevice &d, uint32_t &n_ports, Port **&list, Port *&active) {
+        ports.resize(d.ports.size());
+        for (size_t i = 0; i < d.ports.size(); i++) {
+            const ShimPort *p = std::find_if(std::begin(card_ports), std::end(card_ports), [&] (const ShimPort &p) {
+                return d.ports[i] == p.name;
+            });
+
+            ports[i] = Port{};
+            ports[i].name = p->name;
+            ports[i].description = p->description;
+            ports[i].priority = 100 - i;
+            ports[i].available = PA_PORT_AVAILABLE_UNKNOWN;
+            pointers.push_back(&ports[i]);
+            if (d.active_port == p->name)
+                active = &ports[i];
+        }
+        pointers.push_back(nullptr);
+
+        n_ports = d.ports.size();
+        list = pointers.data();
+    }
+};
+
+template<typename Info>
+static void fill_device(const ShimDevice &d, uint32_t index, Info &i) {
+    i.name = d.name.c_str();
+    i.index = index;
+    i.description = d.description.c_str();
+    i.sample_spec.format = PA_SAMPLE_FLOAT32;
+    i.sample_spec.rate = 48000;
+    i.sample_spec.channels = d.map.channels;
+    i.channel_map = d.map;
+    i.owner_module = 0;
+    i.volume = d.volume;
+    i.mute = d.mute;
+    i.driver = "pulseshim.c";
+    i.proplist = d.proplist;
+    i.base_volume = PA_VOLUME_NORM;
+    i.n_volume_steps = PA_VOLUME_NORM + 1;
+    i.card = d.card;
+}
+
+static void send_sink(pa_context *c, uint32_t index, const ShimDevice &d, pa_sink_info_cb_t cb, void *userdata) {
+    pa_sink_info i{};
+    PortList<pa_sink_port_info> ports;
+
+    fill_device(d, index, i);
+    i.monitor_source = d.monitor;
+    i.monitor_source_name = shim.sources[d.monitor].name.c_str();
+    i.flags = static_cast<pa_sink_flags_t>(PA_SINK_HW_VOLUME_CTRL | PA_SINK_HARDWARE | PA_SINK_DECIBEL_VOLUME);
+    i.state = PA_SINK_RUNNING;
+    ports.fill(d, i.n_ports, i.ports, i.active_port);
+
+    cb(c, &i, 0, userdata);
+    shim.delivered(PA_SUBSCRIPTION_EVENT_SINK, index);
+}
+
+static void send_source(pa_context *c, uint32_t index, const ShimDevice &d, pa_source_info_cb_t cb, void *userdata) {
+    pa_source_info i{};
+    PortList<pa_source_port_info> ports;
+
+    fill_device(d, index, i);
+    i.monitor_of_sink = d.monitor;
+    i.monitor_of_sink_name = d.monitor != PA_INVALID_INDEX ? shim.sinks[d.monitor].name.c_str() : nullptr;
+    i.flags = static_cast<pa_source_flags_t>(PA_SOURCE_HW_VOLUME_CTRL | PA_SOURCE_HARDWARE | PA_SOURCE_DECIBEL_VOLUME);
+    i.state = PA_SOURCE_RUNNING;
+    ports.fill(d, i.n_ports, i.ports, i.active_port);
+
+    cb(c, &i, 0, userdata);
+    shim.delivered(PA_SUBSCRIPTION_EVENT_SOURCE, index);
+}
+
+template<typename Info>
+static void fill_stream(const ShimStream &s, uint32_t index, Info &i) {
+    i.index = index;
+    i.name = s.name.c_str();
+    i.owner_module = PA_INVALID_INDEX;
+    i.client = s.client;
+    i.sample_spec.format = PA_SAMPLE_FLOAT32;
+    i.sample_spec.rate = 48000;
+    i.sample_spec.channels = s.map.channels;
+    i.channel_map = s.map;
+    i.volume = s.volume;
+    i.resample_method = "speex-float-1";
+    i.driver = "protocol-native.c";
+    i.mute = s.mute;
+    i.proplist = s.proplist;
+    i.corked = s.corked;
+    i.has_volume = 1;
+    i.volume_writable = 1;
+}
+
+static void send_sink_input(pa_context *c, uint32_t index, const ShimStream &s, pa_sink_input_info_cb_t cb, void *userdata) {
+    pa_sink_input_info i{};
+
+    fill_stream(s, index, i);
+    i.sink = s.device;
+
+    cb(c, &i, 0, userdata);
+    shim.delivered(PA_SUBSCRIPTION_EVENT_SINK_INPUT, index);
+}
+
+static void send_source_output(pa_context *c, uint32_t index, const ShimStream &s, pa_source_output_info_cb_t cb, void *userdata) {
+    pa_source_output_info i{};
+
+    fill_stream(s, index, i);
+    i.source = s.device;
+
+    cb(c, &i, 0, userdata);
+    shim.delivered(PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, index);
+}
+
+static void send_client(pa_context *c, uint32_t index, const ShimClient &cl, pa_client_info_cb_t cb, void *userdata) {
+    pa_client_info i{};
+
+    i.index = index;
+    i.name = cl.name.c_str();
+    i.owner_module = PA_INVALID_INDEX;
+    i.driver = "protocol-native.c";
+    i.proplist = cl.proplist;
+
+    cb(c, &i, 0, userdata);
+    shim.delivered(PA_SUBSCRIPTION_EVENT_CLIENT, index);
+}
+
+static void send_card(pa_context *c, uint32_t index, const ShimCard &card, pa_card_info_cb_t cb, void *userdata) {
+    const size_t n_profiles = G_N_ELEMENTS(card_profiles), n_ports = G_N_ELEMENTS(card_ports);
+    pa_card_info i{};
+    pa_card_profile_info profiles[n_profiles];
+    pa_card_profile_info2 profiles2[n_profiles];
+    pa_card_profile_info2 *profile_pointers[n_profiles + 1];
+    pa_card_port_info ports[n_ports];
+    pa_card_port_info *port_pointers[n_ports + 1];
+    /* Every port is part of the duplex profile, the outputs also of the
+     * output only one */
+    pa_card_profile_info2 *output_profiles[] = { &profiles2[0], &profiles2[1], nullptr };
+    pa_card_profile_info2 *input_profiles[] = { &profiles2[0], nullptr };
+
+    for (size_t j = 0; j < n_profiles; j++) {
+        profiles[j] = pa_card_profile_info{};
+        profiles[j].name = card_profiles[j].name;
+        profiles[j].description = card_profiles[j].description;
+        profiles[j].n_sinks = card_profiles[j].n_sinks;
+        profiles[j].n_sources = card_profiles[j].n_sources;
+        profiles[j].priority = card_profiles[j].priority;
+
+        profiles2[j] = pa_card_profile_info2{};
+        profiles2[j].name = card_profiles[j].name;
+        profiles2[j].description = card_profiles[j].description;
+        profiles2[j].n_sinks = card_profiles[j].n_sinks;
+        profiles2[j].n_sources = card_profiles[j].n_sources;
+        profiles2[j].priority = card_profiles[j].priority;
+        profiles2[j].available = 1;
+        profile_pointers[j] = &profiles2[j];
+
+        if (card.active_profile == card_profiles[j].name) {
+            i.active_profile = &profiles[j];
+            i.active_profile2 = &profiles2[j];
+        }
+    }
+    profile_pointers[n_profiles] = nullptr;
+
+    for (size_t j = 0; j < n_ports; j++) {
+        ports[j] = pa_card_port_info{};
+        ports[j].name = card_ports[j].name;
+        ports[j].description = card_ports[j].description;
+        ports[j].priority = 100 - j;
+        ports[j].available = PA_PORT_AVAILABLE_UNKNOWN;
+        ports[j].direction = card_ports[j].direction;
+        ports[j].proplist = card.proplist;
+        ports[j].latency_offset = card.latency_offsets[j];
+        ports[j].profiles2 = card_ports[j].direction == PA_DIRECTION_OUTPUT ? output_profiles : input_profiles;
+        ports[j].n_profiles = card_ports[j].direction == PA_DIRECTION_OUTPUT ? 2 : 1;
+        port_pointers[j] = &ports[j];
+    }
+    port_pointers[n_ports] = nullptr;
+
+    i.index = index;
+    i.name = card.name.c_str();
+    i.owner_module = 0;
+    i.driver = "module-alsa-card.c";
+    i.n_profiles = n_profiles;
+    i.profiles = profiles;
+    i.proplist = card.proplist;
+    i.n_ports = n_ports;
+    i.ports = port_pointers;
+    i.profiles2 = profile_pointers;
+
+    cb(c, &i, 0, userdata);
+    shim.delivered(PA_SUBSCRIPTION_EVENT_CARD, index);
+}
+
+/* A missing object ends the answer with an error, like the server does */
+template<typename Record, typename Callback, typename Send>
+static pa_operation *get_one(pa_context *c, std::map<uint32_t, Record> &records, uint32_t idx, Callback cb, void *userdata, Send send) {
+    return shim.reply(c, [c, &records, idx, cb, userdata, send] {
+        auto it = records.find(idx);
+
+        if (it == records.end()) {
+            c->error = PA_ERR_NOENTITY;
+            cb(c, nullptr, -1, userdata);
+            return;
+        }
+
+        send(c, it->first, it->second, cb, userdata);
+        cb(c, nullptr, 1, userdata);
+    });
+}
+
+template<typename Record, typename Callback, typename Send>
+static pa_operation *get_list(pa_context *c, std::map<uint32_t, Record> &records, Callback cb, void *userdata, Send send) {
+    return shim.reply(c, [c, &records, cb, userdata, send] {
+        for (auto & record : records)
+            send(c, record.first, record.second, cb, userdata);
+        cb(c, nullptr, 1, userdata);
+    });
+}
+
+template<typename Record>
+static typename std::map<uint32_t, Record>::iterator find_by_name(std::map<uint32_t, Record> &records, const char *name) {
+    return std::find_if(records.begin(), records.end(), [name] (const std::pair<const uint32_t, Record> &r) {
+        return name && r.second.name == name;
+    });
+}
+
+extern "C" {
+
+pa_operation *pa_context_get_sink_info_by_index(pa_context *c, uint32_t idx, pa_sink_info_cb_t cb, void *userdata) {
+    return get_one(c, shim.sinks, idx, cb, userdata, send_sink);
+}
+
+pa_operation *pa_context_get_sink_info_list(pa_context *c, pa_sink_info_cb_t cb, void *userdata) {
+    return get_list(c, shim.sinks, cb, userdata, send_sink);
+}
+
+pa_operation *pa_context_get_source_info_by_index(pa_context *c, uint32_t idx, pa_source_info_cb_t cb, void *userdata) {
+    return get_one(c, shim.sources, idx, cb, userdata, send_source);
+}
+
+pa_operation *pa_context_get_source_info_list(pa_context *c, pa_source_info_cb_t cb, void *userdata) {
+    return get_list(c, shim.sources, cb, userdata, send_source);
+}
+
+pa_operation *pa_context_get_sink_input_info(pa_context *c, uint32_t idx, pa_sink_input_info_cb_t cb, void *userdata) {
+    return get_one(c, shim.sinkInputs, idx, cb, userdata, send_sink_input);
+}
+
+pa_operation *pa_context_get_sink_input_info_list(pa_context *c, pa_sink_input_info_cb_t cb, void *userdata) {
+    return get_list(c, shim.sinkInputs, cb, userdata, send_sink_input);
+}
+
+pa_operation *pa_context_get_source_output_info(pa_context *c, uint32_t idx, pa_source_output_info_cb_t cb, void *userdata) {
+    return get_one(c, shim.sourceOutputs, idx, cb, userdata, send_source_output);
+}
+
+pa_operation *pa_context_get_source_output_info_list(pa_context *c, pa_source_output_info_cb_t cb, void *userdata) {
+    return get_list(c, shim.sourceOutputs, cb, userdata, send_source_output);
+}
+
+pa_operation *pa_context_get_client_info(pa_context *c, uint32_t idx, pa_client_info_cb_t cb, void *userdata) {
+    return get_one(c, shim.clients, idx, cb, userdata, send_client);
+}
+
+pa_operation *pa_context_get_client_info_list(pa_context *c, pa_client_info_cb_t cb, void *userdata) {
+    return get_list(c, shim.clients, cb, userdata, send_client);
+}
+
+pa_operation *pa_context_get_card_info_by_index(pa_context *c, uint32_t idx, pa_card_info_cb_t cb, void *userdata) {
+    return get_one(c, shim.cards, idx, cb, userdata, send_card);
+}
+
+pa_operation *pa_context_get_card_info_list(pa_context *c, pa_card_info_cb_t cb, void *userdata) {
+    return get_list(c, shim.cards, cb, userdata, send_card);
+}
+
+}
+
+/*** Changes ***/
+
+/* Applies a change to an object, tells the subscribers and answers. The
+ * change returns false when the object does not take it. */
+template<typename Record>
+static pa_operation *change(pa_context *c, std::map<uint32_t, Record> &records, typename std::map<uint32_t, Record>::iterator it,
+                            pa_subscription_event_type_t facility, const std::function<bool(Record&)> &apply,
+                            pa_context_success_cb_t cb, void *userdata) {
+    bool ok = it != records.end() && apply(it->second);
+    const uint32_t index = ok ? it->first : PA_INVALID_INDEX;
+
+    return shim.reply(c, [c, ok, index, facility, cb, userdata] {
+        if (ok)
+            shim.post(static_cast<pa_subscription_event_type_t>(facility | PA_SUBSCRIPTION_EVENT_CHANGE), index);
+        else
+            c->error = PA_ERR_NOENTITY;
+
+        if (cb)
+            cb(c, ok, userdata);
+    });
+}
+
+static std::function<bool(ShimDevice&)> set_device_volume(const pa_cvolume *volume) {
+    const pa_cvolume v = *volume;
+
+    return [v] (ShimDevice &d) {
+        if (v.channels == 1)
+            pa_cvolume_set(&d.volume, d.map.channels, v.values[0]);
+        else if (v.channels == d.map.channels)
+            d.volume = v;
+        else
+            return false;
+        return true;
+    };
+}
+
+static std::function<bool(ShimStream&)> set_stream_volume(const pa_cvolume *volume) {
+    const pa_cvolume v = *volume;
+
+    return [v] (ShimStream &s) {
+        if (v.channels == 1)
+            pa_cvolume_set(&s.volume, s.map.channels, v.values[0]);
+        else if (v.channels == s.map.channels)
+            s.volume = v;
+        else
+            return false;
+        return true;
+    };
+}
+
+template<typename Record>
+static std::function<bool(Record&)> set_mute(int mute) {
+    return [mute] (Record &r) {
+        r.mute = !!mute;
+        return true;
+    };
+}
+
+static std::function<bool(ShimDevice&)> set_port(const char *port) {
+    const std::string p = port ? port : "";
+
+    return [p] (ShimDevice &d) {
+        if (std::find(d.ports.begin(), d.ports.end(), p) == d.ports.end())
+            return false;
+        d.active_port = p;
+        return true;
+    };
+}
+
+static std::function<bool(ShimStream&)> move_to(std::map<uint32_t, ShimDevice> &devices, std::map<uint32_t, ShimDevice>::iterator device) {
+    const uint32_t index = device != devices.end() ? device->first : PA_INVALID_INDEX;
+
+    return [index] (ShimStream &s) {
+        if (index == PA_INVALID_INDEX)
+            return false;
+        s.device = index;
+        return true;
+    };
+}
+
+static pa_operation *kill_stream(pa_context *c, std::map<uint32_t, ShimStream> &streams, uint32_t idx, pa_subscription_event_type_t facility,
+                          pa_context_success_cb_t cb, void *userdata) {
+    auto it = streams.find(idx);
+    const bool ok = it != streams.end();
+
+    if (ok) {
+        pa_proplist_free(it->second.proplist);
+        streams.erase(it);
+    }
+
+    return shim.reply(c, [c, ok, idx, facility, cb, userdata] {
+        if (ok)
+            shim.post(static_cast<pa_subscription_event_type_t>(facility | PA_SUBSCRIPTION_EVENT_REMOVE), idx);
+        else
+            c->error = PA_ERR_NOENTITY;
+
+        if (cb)
+            cb(c, ok, userdata);
+    });
+}
+
+static pa_operation *set_default(pa_context *c, std::map<uint32_t, ShimDevice> &devices, std::string &current, const char *name,
+                                 pa_context_success_cb_t cb, void *userdata) {
+    const bool ok = find_by_name(devices, name) != devices.end();
+
+    if (ok)
+        current = name;
+
+    return shim.reply(c, [c, ok, cb, userdata] {
+        if (ok)
+            shim.post(static_cast<pa_subscription_event_type_t>(PA_SUBSCRIPTION_EVENT_SERVER | PA_SUBSCRIPTION_EVENT_CHANGE), PA_INVALID_INDEX);
+        else
+            c->error = PA_ERR_NOENTITY;
+
+        if (cb)
+            cb(c, ok, userdata);
+    });
+}
+
+static std::function<bool(ShimCard&)> set_profile(const char *profile) {
+    const std::string p = profile ? profile : "";
+
+    return [p] (ShimCard &card) {
+        for (auto & known : card_profiles) {
+            if (p == known.name) {
+                card.active_profile = p;
+                return true;
+            }
+        }
+        return false;
+    };
+}
+
+extern "C" {
+
+pa_operation *pa_context_set_sink_volume_by_index(pa_context *c, uint32_t idx, const pa_cvolume *volume, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinks, shim.sinks.find(idx), PA_SUBSCRIPTION_EVENT_SINK, set_device_volume(volume), cb, userdata);
+}
+
+pa_operation *pa_context_set_sink_volume_by_name(pa_context *c, const char *name, const pa_cvolume *volume, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinks, find_by_name(shim.sinks, name), PA_SUBSCRIPTION_EVENT_SINK, set_device_volume(volume), cb, userdata);
+}
+
+pa_operation *pa_context_set_sink_mute_by_index(pa_context *c, uint32_t idx, int mute, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinks, shim.sinks.find(idx), PA_SUBSCRIPTION_EVENT_SINK, set_mute<ShimDevice>(mute), cb, userdata);
+}
+
+pa_operation *pa_context_set_sink_mute_by_name(pa_context *c, const char *name, int mute, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinks, find_by_name(shim.sinks, name), PA_SUBSCRIPTION_EVENT_SINK, set_mute<ShimDevice>(mute), cb, userdata);
+}
+
+pa_operation *pa_context_set_sink_port_by_index(pa_context *c, uint32_t idx, const char *port, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinks, shim.sinks.find(idx), PA_SUBSCRIPTION_EVENT_SINK, set_port(port), cb, userdata);
+}
+
+pa_operation *pa_context_set_sink_port_by_name(pa_context *c, const char *name, const char *port, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinks, find_by_name(shim.sinks, name), PA_SUBSCRIPTION_EVENT_SINK, set_port(port), cb, userdata);
+}
+
+pa_operation *pa_context_set_source_volume_by_index(pa_context *c, uint32_t idx, const pa_cvolume *volume, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sources, shim.sources.find(idx), PA_SUBSCRIPTION_EVENT_SOURCE, set_device_volume(volume), cb, userdata);
+}
+
+pa_operation *pa_context_set_source_volume_by_name(pa_context *c, const char *name, const pa_cvolume *volume, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sources, find_by_name(shim.sources, name), PA_SUBSCRIPTION_EVENT_SOURCE, set_device_volume(volume), cb, userdata);
+}
+
+pa_operation *pa_context_set_source_mute_by_index(pa_context *c, uint32_t idx, int mute, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sources, shim.sources.find(idx), PA_SUBSCRIPTION_EVENT_SOURCE, set_mute<ShimDevice>(mute), cb, userdata);
+}
+
+pa_operation *pa_context_set_source_mute_by_name(pa_context *c, const char *name, int mute, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sources, find_by_name(shim.sources, name), PA_SUBSCRIPTION_EVENT_SOURCE, set_mute<ShimDevice>(mute), cb, userdata);
+}
+
+pa_operation *pa_context_set_source_port_by_index(pa_context *c, uint32_t idx, const char *port, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sources, shim.sources.find(idx), PA_SUBSCRIPTION_EVENT_SOURCE, set_port(port), cb, userdata);
+}
+
+pa_operation *pa_context_set_source_port_by_name(pa_context *c, const char *name, const char *port, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sources, find_by_name(shim.sources, name), PA_SUBSCRIPTION_EVENT_SOURCE, set_port(port), cb, userdata);
+}
+
+pa_operation *pa_context_set_sink_input_volume(pa_context *c, uint32_t idx, const pa_cvolume *volume, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinkInputs, shim.sinkInputs.find(idx), PA_SUBSCRIPTION_EVENT_SINK_INPUT, set_stream_volume(volume), cb, userdata);
+}
+
+pa_operation *pa_context_set_sink_input_mute(pa_context *c, uint32_t idx, int mute, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinkInputs, shim.sinkInputs.find(idx), PA_SUBSCRIPTION_EVENT_SINK_INPUT, set_mute<ShimStream>(mute), cb, userdata);
+}
+
+pa_operation *pa_context_set_source_output_volume(pa_context *c, uint32_t idx, const pa_cvolume *volume, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sourceOutputs, shim.sourceOutputs.find(idx), PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, set_stream_volume(volume), cb, userdata);
+}
+
+pa_operation *pa_context_set_source_output_mute(pa_context *c, uint32_t idx, int mute, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sourceOutputs, shim.sourceOutputs.find(idx), PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, set_mute<ShimStream>(mute), cb, userdata);
+}
+
+pa_operation *pa_context_move_sink_input_by_index(pa_context *c, uint32_t idx, uint32_t sink_idx, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinkInputs, shim.sinkInputs.find(idx), PA_SUBSCRIPTION_EVENT_SINK_INPUT,
+                  move_to(shim.sinks, shim.sinks.find(sink_idx)), cb, userdata);
+}
+
+pa_operation *pa_context_move_sink_input_by_name(pa_context *c, uint32_t idx, const char *sink_name, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sinkInputs, shim.sinkInputs.find(idx), PA_SUBSCRIPTION_EVENT_SINK_INPUT,
+                  move_to(shim.sinks, find_by_name(shim.sinks, sink_name)), cb, userdata);
+}
+
+pa_operation *pa_context_move_source_output_by_index(pa_context *c, uint32_t idx, uint32_t source_idx, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sourceOutputs, shim.sourceOutputs.find(idx), PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT,
+                  move_to(shim.sources, shim.sources.find(source_idx)), cb, userdata);
+}
+
+pa_operation *pa_context_move_source_output_by_name(pa_context *c, uint32_t idx, const char *source_name, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.sourceOutputs, shim.sourceOutputs.find(idx), PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT,
+                  move_to(shim.sources, find_by_name(shim.sources, source_name)), cb, userdata);
+}
+
+pa_operation *pa_context_kill_sink_input(pa_context *c, uint32_t idx, pa_context_success_cb_t cb, void *userdata) {
+    return kill_stream(c, shim.sinkInputs, idx, PA_SUBSCRIPTION_EVENT_SINK_INPUT, cb, userdata);
+}
+
+pa_operation *pa_context_kill_source_output(pa_context *c, uint32_t idx, pa_context_success_cb_t cb, void *userdata) {
+    return kill_stream(c, shim.sourceOutputs, idx, PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT, cb, userdata);
+}
+
+pa_operation *pa_context_set_default_sink(pa_context *c, const char *name, pa_context_success_cb_t cb, void *userdata) {
+    return set_default(c, shim.sinks, shim.defaultSink, name, cb, userdata);
+}
+
+pa_operation *pa_context_set_default_source(pa_context *c, const char *name, pa_context_success_cb_t cb, void *userdata) {
+    return set_default(c, shim.sources, shim.defaultSource, name, cb, userdata);
+}
+
+pa_operation *pa_context_set_card_profile_by_index(pa_context *c, uint32_t idx, const char *profile, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.cards, shim.cards.find(idx), PA_SUBSCRIPTION_EVENT_CARD, set_profile(profile), cb, userdata);
+}
+
+pa_operation *pa_context_set_card_profile_by_name(pa_context *c, const char *name, const char *profile, pa_context_success_cb_t cb, void *userdata) {
+    return change(c, shim.cards, find_by_name(shim.cards, name), PA_SUBSCRIPTION_EVENT_CARD, set_profile(profile), cb, userdata);
+}
+
+pa_operation *pa_context_set_port_latency_offset(pa_context *c, const char *card_name, const char *port_name, int64_t offset,
+                                                 pa_context_success_cb_t cb, void *userdata) {
+    const std::string port = port_name ? port_name : "";
+
+    return change<ShimCard>(c, shim.cards, find_by_name(shim.cards, card_name), PA_SUBSCRIPTION_EVENT_CARD, [port, offset] (ShimCard &card) {
+        for (size_t j = 0; j < G_N_ELEMENTS(card_ports); j++) {
+            if (port == card_ports[j].name) {
+                card.latency_offsets[j] = offset;
+                return true;
+            }
+        }
+        return false;
+    }, cb, userdata);
+}
+
+}
+
+/*** Extensions ***/
+
+/* Stream and device restore are loaded but have nothing stored, the device
+ * manager is not loaded, as on most systems */
+
+extern "C" {
+
+pa_operation *pa_ext_stream_restore_read(pa_context *c, pa_ext_stream_restore_read_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        cb(c, nullptr, 1, userdata);
+    });
+}
+
+pa_operation *pa_ext_stream_restore_write(pa_context *c, pa_update_mode_t, const pa_ext_stream_restore_info[], unsigned, int,
+                                          pa_context_success_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        if (cb)
+            cb(c, 1, userdata);
+    });
+}
+
+pa_operation *pa_ext_stream_restore_subscribe(pa_context *c, int, pa_context_success_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        if (cb)
+            cb(c, 1, userdata);
+    });
+}
+
+void pa_ext_stream_restore_set_subscribe_cb(pa_context *, pa_ext_stream_restore_subscribe_cb_t, void *) {
+}
+
+#if PA_CHECK_VERSION(0,99,0)
+pa_operation *pa_ext_device_restore_read_formats_all(pa_context *c, pa_ext_device_restore_read_device_formats_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        cb(c, nullptr, 1, userdata);
+    });
+}
+
+pa_operation *pa_ext_device_restore_read_formats(pa_context *c, pa_device_type_t, uint32_t, pa_ext_device_restore_read_device_formats_cb_t cb,
+                                                 void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        cb(c, nullptr, 1, userdata);
+    });
+}
+
+pa_operation *pa_ext_device_restore_save_formats(pa_context *c, pa_device_type_t, uint32_t, uint8_t, pa_format_info **,
+                                                 pa_context_success_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        if (cb)
+            cb(c, 1, userdata);
+    });
+}
+
+pa_operation *pa_ext_device_restore_subscribe(pa_context *c, int, pa_context_success_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        if (cb)
+            cb(c, 1, userdata);
+    });
+}
+
+void pa_ext_device_restore_set_subscribe_cb(pa_context *, pa_ext_device_restore_subscribe_cb_t, void *) {
+}
+#endif
+
+pa_operation *pa_ext_device_manager_read(pa_context *c, pa_ext_device_manager_read_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        c->error = PA_ERR_NOEXTENSION;
+        cb(c, nullptr, -1, userdata);
+    });
+}
+
+pa_operation *pa_ext_device_manager_set_device_description(pa_context *c, const char *, const char *, pa_context_success_cb_t cb,
+                                                           void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        c->error = PA_ERR_NOEXTENSION;
+        if (cb)
+            cb(c, 0, userdata);
+    });
+}
+
+pa_operation *pa_ext_device_manager_subscribe(pa_context *c, int, pa_context_success_cb_t cb, void *userdata) {
+    return shim.reply(c, [c, cb, userdata] {
+        c->error = PA_ERR_NOEXTENSION;
+        if (cb)
+            cb(c, 0, userdata);
+    });
+}
+
+void pa_ext_device_manager_set_subscribe_cb(pa_context *, pa_ext_device_manager_subscribe_cb_t, void *) {
+}
+
+}
+
+/*** Streams ***/
+
+extern "C" {
+
+pa_stream *pa_stream_new(pa_context *c, const char *, const pa_sample_spec *ss, const pa_channel_map *map) {
+    pa_stream *s = new pa_stream;
+
+    s->ref = 1;
+    s->context = c;
+    s->ss = *ss;
+    if (map)
+        s->map = *map;
+    else
+        pa_channel_map_init_extend(&s->map, ss->channels, PA_CHANNEL_MAP_DEFAULT);
+    s->state = PA_STREAM_UNCONNECTED;
+    s->monitor_stream = PA_INVALID_INDEX;
+    s->source = PA_INVALID_INDEX;
+    s->corked = 0;
+    s->fragsize = 0;
+    s->phase = 0;
+    s->timer = 0;
+    s->state_cb = nullptr;
+    s->state_userdata = nullptr;
+    s->read_cb = nullptr;
+    s->read_userdata = nullptr;
+    s->suspended_cb = nullptr;
+    s->suspended_userdata = nullptr;
+    shim.streams.insert(s);
+
+    return s;
+}
+
+pa_stream *pa_stream_ref(pa_stream *s) {
+    s->ref++;
+    return s;
+}
+
+static void stop_stream(pa_stream *s) {
+    if (s->timer)
+        remove_timeout(s->context->loop, s->timer);
+    s->timer = 0;
+}
+
+void pa_stream_unref(pa_stream *s) {
+    if (--s->ref > 0)
+        return;
+
+    stop_stream(s);
+    shim.streams.erase(s);
+    delete s;
+}
+
+static void set_stream_state(pa_stream *s, pa_stream_state_t state) {
+    s->state = state;
+
+    pa_stream_ref(s);
+    if (s->state_cb)
+        s->state_cb(s, s->state_userdata);
+    pa_stream_unref(s);
+}
+
+pa_stream_state_t pa_stream_get_state(const pa_stream *s) {
+    return s->state;
+}
+
+int pa_stream_set_monitor_stream(pa_stream *s, uint32_t sink_input_idx) {
+    s->monitor_stream = sink_input_idx;
+    return 0;
+}
+
+void pa_stream_set_state_callback(pa_stream *s, pa_stream_notify_cb_t cb, void *userdata) {
+    s->state_cb = cb;
+    s->state_userdata = userdata;
+}
+
+void pa_stream_set_read_callback(pa_stream *s, pa_stream_request_cb_t cb, void *userdata) {
+    s->read_cb = cb;
+    s->read_userdata = userdata;
+}
+
+void pa_stream_set_suspended_callback(pa_stream *s, pa_stream_notify_cb_t cb, void *userdata) {
+    s->suspended_cb = cb;
+    s->suspended_userdata = userdata;
+}
+
+/* A fragment of a tone, a little louder for every source */
+static gboolean stream_read_cb(gpointer userdata) {
+    pa_stream *s = static_cast<pa_stream*>(userdata);
+    const size_t frame = pa_frame_size(&s->ss);
+    const size_t frames = s->fragsize / frame;
+
+    if (s->corked || !shim.script.meters)
+        return TRUE;
+
+    if (s->ss.format == PA_SAMPLE_FLOAT32NE) {
+        const float amplitude = 0.1f + 0.8f * (s->source % 8) / 8;
+        const size_t start = s->data.size();
+
+        s->data.resize(start + frames * frame);
+        float *samples = reinterpret_cast<float*>(s->data.data() + start);
+
+        for (size_t i = 0; i < frames; i++, s->phase += 2 * M_PI * 440 / s->ss.rate)
+            for (unsigned ch = 0; ch < s->ss.channels; ch++)
+                samples[i * s->ss.channels + ch] = amplitude * sinf(s->phase);
+    } else
+        s->data.resize(s->data.size() + frames * frame, 0);
+
+    pa_stream_ref(s);
+    if (s->read_cb) {
+        const gint64 before = g_get_monotonic_time();
+
+        s->read_cb(s, s->data.size(), s->read_userdata);
+        shim.fragmentTime += g_get_monotonic_time() - before;
+        shim.fragments++;
+    }
+    pa_stream_unref(s);
+
+    return TRUE;
+}
+
+int pa_stream_connect_record(pa_stream *s, const char *dev, const pa_buffer_attr *attr, pa_stream_flags_t flags) {
+    char *end;
+
+    if (s->state != PA_STREAM_UNCONNECTED || s->context->state != PA_CONTEXT_READY) {
+        s->context->error = PA_ERR_BADSTATE;
+        return -1;
+    }
+
+    s->source = dev ? strtoul(dev, &end, 10) : 0;
+    if (dev && *end) {
+        auto it = find_by_name(shim.sources, dev);
+        s->source = it != shim.sources.end() ? it->first : PA_INVALID_INDEX;
+    }
+
+    s->corked = !!(flags & PA_STREAM_START_CORKED);
+    s->fragsize = attr && attr->fragsize && attr->fragsize != (uint32_t) -1 ? attr->fragsize : pa_usec_to_bytes(25000, &s->ss);
+    s->fragsize = std::max(s->fragsize - s->fragsize % pa_frame_size(&s->ss), pa_frame_size(&s->ss));
+
+    set_stream_state(s, PA_STREAM_CREATING);
+
+    pa_stream_ref(s);
+    pa_operation_unref(shim.reply(s->context, [s] {
+        if (s->state == PA_STREAM_CREATING) {
+            const unsigned ms = 1000 * (s->fragsize / pa_frame_size(&s->ss)) / s->ss.rate;
+
+            if (shim.sources.count(s->source)) {
+                s->timer = add_timeout(s->context->loop, std::max(1u, ms), stream_read_cb, s);
+                set_stream_state(s, PA_STREAM_READY);
+            } else {
+                s->context->error = PA_ERR_NOENTITY;
+                set_stream_state(s, PA_STREAM_FAILED);
+            }
+        }
+        pa_stream_unref(s);
+    }));
+
+    return 0;
+}
+
+int pa_stream_disconnect(pa_stream *s) {
+    if (s->state != PA_STREAM_CREATING && s->state != PA_STREAM_READY) {
+        s->context->error = PA_ERR_BADSTATE;
+        return -1;
+    }
+
+    stop_stream(s);
+    set_stream_state(s, PA_STREAM_TERMINATED);
+    return 0;
+}
+
+pa_operation *pa_stream_cork(pa_stream *s, int b, pa_stream_success_cb_t cb, void *userdata) {
+    s->corked = !!b;
+
+    pa_stream_ref(s);
+    return shim.reply(s->context, [s, cb, userdata] {
+        if (cb)
+            cb(s, 1, userdata);
+        pa_stream_unref(s);
+    });
+}
+
+int pa_stream_peek(pa_stream *s, const void **data, size_t *nbytes) {
+    *data = s->data.empty() ? nullptr : s->data.data();
+    *nbytes = s->data.size();
+    return 0;
+}
+
+int pa_stream_drop(pa_stream *s) {
+    if (s->data.empty()) {
+        s->context->error = PA_ERR_BADSTATE;
+        return -1;
+    }
+
+    s->data.clear();
+    return 0;
+}
+
+int pa_stream_is_suspended(const pa_stream *) {
+    return 0;
+}
+
+const pa_sample_spec *pa_stream_get_sample_spec(pa_stream *s) {
+    return &s->ss;
+}
+
+const pa_channel_map *pa_stream_get_channel_map(pa_stream *s) {
+    return &s->map;
+}
+
+}
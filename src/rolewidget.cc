@@ -23,6 +23,8 @@
 #endif
 
 #include "rolewidget.h"
+#include "mainwindow.h"
+#include "operationcoalescer.h"
 
 #include <pulse/ext-stream-restore.h>
 
@@ -32,6 +34,7 @@ RoleWidget::RoleWidget(MainWindow *parent) :
     lockToggleButton->hide();
     directionLabel->hide();
     deviceButton->hide();
+    select->setEnabled(false);
     setContextMenuPolicy(Qt::DefaultContextMenu);
 }
 
@@ -42,24 +45,25 @@ void RoleWidget::onMuteToggleButton() {
 }
 
 void RoleWidget::executeVolumeUpdate() {
-    pa_ext_stream_restore_info info;
-
     if (updating)
         return;
 
-    info.name = role.constData();
-    info.channel_map.channels = 1;
-    info.channel_map.map[0] = PA_CHANNEL_POSITION_MONO;
-    info.volume = volume;
-    info.device = device == "" ? nullptr : device.constData();
-    info.mute = muteToggleButton->isChecked();
-
-    pa_operation* o;
-    if (!(o = pa_ext_stream_restore_write(get_context(), PA_UPDATE_REPLACE, &info, 1, TRUE, nullptr, nullptr))) {
-        show_error(tr("pa_ext_stream_restore_write() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const QByteArray r = role;
+    const QByteArray d = device;
+    const pa_cvolume v = volume;
+    const int mute = muteToggleButton->isChecked();
+    mpMainWindow->operations->submit(OperationCoalescer::RoleVolume, 0, r, tr("pa_ext_stream_restore_write() failed"),
+        [r, d, v, mute] (pa_context_success_cb_t cb, void *userdata) {
+            pa_ext_stream_restore_info info;
+
+            info.name = r.constData();
+            info.channel_map.channels = 1;
+            info.channel_map.map[0] = PA_CHANNEL_POSITION_MONO;
+            info.volume = v;
+            info.device = d == "" ? nullptr : d.constData();
+            info.mute = mute;
+
+            return pa_ext_stream_restore_write(get_context(), PA_UPDATE_REPLACE, &info, 1, TRUE, cb, userdata);
+        });
 }
 
@@ -0,0 +1,75 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "samplering.h"
+
+#include <algorithm>
+#include <string.h>
+
+SampleRing::SampleRing(size_t capacity) :
+    mWriting(0),
+    mWritten(0) {
+    size_t size = 1;
+
+    while (size < capacity)
+        size <<= 1;
+
+    mBuffer.resize(size);
+    mMask = size - 1;
+}
+
+void SampleRing::write(const float *data, size_t n) {
+    quint64 pos = mWritten.load(std::memory_order_relaxed);
+
+    /* Only the end of a block larger than the ring survives */
+    if (n > mBuffer.size()) {
+        pos += n - mBuffer.size();
+        data += n - mBuffer.size();
+        n = mBuffer.size();
+    }
+
+    /* A reader that sees any of the new samples also sees this */
+    mWriting.store(pos + n, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const size_t start = pos & mMask;
+    const size_t first = std::min(n, mBuffer.size() - start);
+
+    memcpy(&mBuffer[start], data, first * sizeof(float));
+    memcpy(&mBuffer[0], data + first, (n - first) * sizeof(float));
+
+    mWritten.store(pos + n, std::memory_order_release);
+}
+
+bool SampleRing::read(quint64 from, float *dst, size_t n) const {
+    if (n > mBuffer.size())
+        return false;
+
+    const size_t start = from & mMask;
+    const size_t first = std::min(n, mBuffer.size() - start);
+
+    memcpy(dst, &mBuffer[start], first * sizeof(float));
+    memcpy(dst + first, &mBuffer[0], (n - first) * sizeof(float));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return from + mBuffer.size() >= mWriting.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,52 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef samplering_h
+#define samplering_h
+
+#include <QtGlobal>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+/* Samples handed from the main loop to one analysis thread without
+ * locking. The writer never waits: the ring keeps the last samples it was
+ * given, and a reader that fell behind finds out when it reads. Positions
+ * count all samples written and do not wrap with the ring. */
+class SampleRing {
+public:
+    /* Rounded up to a power of two */
+    explicit SampleRing(size_t capacity);
+
+    size_t capacity() const { return mBuffer.size(); }
+
+    void write(const float *data, size_t n);
+    quint64 written() const { return mWritten.load(std::memory_order_acquire); }
+
+    /* Copies the samples at [from, from + n), which must have been written.
+     * False if some of them were overwritten before or during the copy. */
+    bool read(quint64 from, float *dst, size_t n) const;
+
+private:
+    std::vector<float> mBuffer;
+    size_t mMask;
+    /* Bumped before a write starts, and after it is done */
+    std::atomic<quint64> mWriting;
+    std::atomic<quint64> mWritten;
+};
+
+#endif
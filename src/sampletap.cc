@@ -0,0 +1,150 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "sampletap.h"
+
+#include <QObject>
+
+/* Fragments of about that long, as the analysis runs once per frame */
+#define FRAGMENT_USEC 10000
+
+SampleTap::SampleTap(bool mono, double seconds, const Callback &ready, const Callback &data, const Callback &failed) :
+    mStream(nullptr),
+    mMono(mono),
+    mSeconds(seconds),
+    mCorked(true),
+    mReady(ready),
+    mData(data),
+    mFailed(failed) {
+
+    mSpec.format = PA_SAMPLE_FLOAT32;
+    mSpec.rate = 48000;
+    mSpec.channels = mono ? 1 : 2;
+    pa_channel_map_init(&mMap);
+}
+
+SampleTap::~SampleTap() {
+    if (!mStream)
+        return;
+
+    pa_stream_set_state_callback(mStream, nullptr, nullptr);
+    pa_stream_set_read_callback(mStream, nullptr, nullptr);
+    pa_stream_disconnect(mStream);
+    pa_stream_unref(mStream);
+}
+
+bool SampleTap::connect(uint32_t source_idx, uint32_t stream_idx) {
+    pa_buffer_attr attr;
+    char t[16];
+
+    if (!get_context())
+        return false;
+
+    /* The server picks the rate, and the channels unless mixed down */
+    if (!(mStream = pa_stream_new(get_context(), QObject::tr("Analyzer").toUtf8().constData(), &mSpec, nullptr))) {
+        show_error(QObject::tr("Failed to create monitoring stream").toUtf8().constData());
+        return false;
+    }
+
+    if (stream_idx != PA_INVALID_INDEX)
+        pa_stream_set_monitor_stream(mStream, stream_idx);
+
+    pa_stream_set_state_callback(mStream, state_callback, this);
+    pa_stream_set_read_callback(mStream, read_callback, this);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.fragsize = (uint32_t) pa_usec_to_bytes(FRAGMENT_USEC, &mSpec);
+    attr.maxlength = (uint32_t) -1;
+
+    const pa_stream_flags_t flags = (pa_stream_flags_t) (PA_STREAM_DONT_MOVE | PA_STREAM_ADJUST_LATENCY | PA_STREAM_FIX_RATE |
+                                                         (mMono ? PA_STREAM_NOFLAGS : PA_STREAM_FIX_CHANNELS) |
+                                                         PA_STREAM_START_CORKED);
+
+    snprintf(t, sizeof(t), "%u", source_idx);
+
+    if (pa_stream_connect_record(mStream, t, &attr, flags) < 0) {
+        show_error(QObject::tr("Failed to connect monitoring stream").toUtf8().constData());
+        pa_stream_unref(mStream);
+        mStream = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void SampleTap::setCorked(bool corked) {
+    mCorked = corked;
+
+    /* Applied once ready otherwise */
+    if (!mStream || pa_stream_get_state(mStream) != PA_STREAM_READY)
+        return;
+
+    pa_operation *o = pa_stream_cork(mStream, (int) corked, nullptr, nullptr);
+    if (o)
+        pa_operation_unref(o);
+}
+
+void SampleTap::state_callback(pa_stream *s, void *userdata) {
+    SampleTap *t = static_cast<SampleTap*>(userdata);
+
+    switch (pa_stream_get_state(s)) {
+        case PA_STREAM_READY:
+            t->mSpec = *pa_stream_get_sample_spec(s);
+            t->mMap = *pa_stream_get_channel_map(s);
+            t->mRing.reset(new SampleRing((size_t) (t->mSeconds * t->mSpec.rate) * t->mSpec.channels));
+            if (!t->mCorked)
+                t->setCorked(false);
+            t->mReady();
+            break;
+
+        case PA_STREAM_FAILED:
+        case PA_STREAM_TERMINATED:
+            t->mFailed();
+            break;
+
+        default:
+            break;
+    }
+}
+
+void SampleTap::read_callback(pa_stream *s, size_t length, void *userdata) {
+    SampleTap *t = static_cast<SampleTap*>(userdata);
+    const void *data;
+
+    if (pa_stream_peek(s, &data, &length) < 0) {
+        show_error(QObject::tr("Failed to read data from stream").toUtf8().constData());
+        return;
+    }
+
+    if (!data) {
+        if (length)
+            pa_stream_drop(s);
+        return;
+    }
+
+    if (t->mRing)
+        t->mRing->write(static_cast<const float*>(data), length / sizeof(float));
+
+    pa_stream_drop(s);
+
+    if (t->mData)
+        t->mData();
+}
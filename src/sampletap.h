@@ -0,0 +1,68 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef sampletap_h
+#define sampletap_h
+
+#include "pavucontrol.h"
+#include "samplering.h"
+
+#include <functional>
+#include <memory>
+
+/* A record stream at the native rate of a source, or of a single sink
+ * input through the monitor of its sink, copying what it reads into a
+ * SampleRing for an analysis thread. Samples are mixed down to mono, or
+ * kept in the channel map of the source.
+ *
+ * The stream is created corked. The callbacks run in the main loop: ready
+ * once the rate and channels are known and the ring exists, data after
+ * every read if given, and failed when the stream or its source went away.
+ * They must not delete the tap. */
+class SampleTap {
+public:
+    typedef std::function<void()> Callback;
+
+    /* The ring holds that many seconds */
+    SampleTap(bool mono, double seconds, const Callback &ready, const Callback &data, const Callback &failed);
+    ~SampleTap();
+
+    bool connect(uint32_t source_idx, uint32_t stream_idx = PA_INVALID_INDEX);
+    void setCorked(bool corked);
+
+    /* Once ready */
+    uint32_t rate() const { return mSpec.rate; }
+    const pa_channel_map &channelMap() const { return mMap; }
+    const SampleRing *ring() const { return mRing.get(); }
+
+private:
+    static void state_callback(pa_stream *s, void *userdata);
+    static void read_callback(pa_stream *s, size_t length, void *userdata);
+
+    pa_stream *mStream;
+    bool mMono;
+    double mSeconds;
+    bool mCorked;
+
+    pa_sample_spec mSpec;
+    pa_channel_map mMap;
+    std::unique_ptr<SampleRing> mRing;
+
+    Callback mReady, mData, mFailed;
+};
+
+#endif
@@ -24,6 +24,7 @@
 
 #include "sinkinputwidget.h"
 #include "mainwindow.h"
+#include "operationcoalescer.h"
 #include "sinkwidget.h"
 #include <QMenu>
 
@@ -37,6 +38,17 @@ SinkInputWidget::SinkInputWidget(MainWindow *parent) :
     g_free(txt);
 
     terminate->setText(tr("Terminate Playback"));
+
+    QAction *loudness = new QAction{tr("Loudness (EBU R128)"), this};
+    loudness->setCheckable(true);
+    connect(loudness, &QAction::toggled, this, [this, loudness] (bool checked) {
+        if (checked && mpMainWindow->sinks.count(mSinkIndex))
+            startLoudness(mpMainWindow->sinks[mSinkIndex].monitor_index, index);
+        else
+            stopLoudness();
+        loudness->setChecked(loudnessShown());
+    });
+    addAction(loudness);
 }
 
 SinkInputWidget::~SinkInputWidget(void) {
@@ -45,10 +57,8 @@ SinkInputWidget::~SinkInputWidget(void) {
 void SinkInputWidget::setSinkIndex(uint32_t idx) {
     mSinkIndex = idx;
 
-    if (mpMainWindow->sinkWidgets.count(idx)) {
-        SinkWidget *w = mpMainWindow->sinkWidgets[idx];
-        deviceButton->setText(QString::fromUtf8(w->description));
-    }
+    if (mpMainWindow->sinks.count(idx))
+        deviceButton->setText(QString::fromUtf8(mpMainWindow->sinks[idx].description));
     else
         deviceButton->setText(tr("Unknown output"));
 }
@@ -58,14 +68,12 @@ uint32_t SinkInputWidget::sinkIndex() {
 }
 
 void SinkInputWidget::executeVolumeUpdate() {
-    pa_operation* o;
-
-    if (!(o = pa_context_set_sink_input_volume(get_context(), index, &volume, nullptr, nullptr))) {
-        show_error(tr("pa_context_set_sink_input_volume() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const uint32_t idx = index;
+    const pa_cvolume v = volume;
+    mpMainWindow->operations->submit(OperationCoalescer::SinkInputVolume, idx, tr("pa_context_set_sink_input_volume() failed"),
+        [idx, v] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_sink_input_volume(get_context(), idx, &v, cb, userdata);
+        });
 }
 
 void SinkInputWidget::onMuteToggleButton() {
@@ -74,13 +82,12 @@ void SinkInputWidget::onMuteToggleButton() {
     if (updating)
         return;
 
-    pa_operation* o;
-    if (!(o = pa_context_set_sink_input_mute(get_context(), index, muteToggleButton->isChecked(), nullptr, nullptr))) {
-        show_error(tr("pa_context_set_sink_input_mute() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const uint32_t idx = index;
+    const int mute = muteToggleButton->isChecked();
+    mpMainWindow->operations->submit(OperationCoalescer::SinkInputMute, idx, tr("pa_context_set_sink_input_mute() failed"),
+        [idx, mute] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_sink_input_mute(get_context(), idx, mute, cb, userdata);
+        });
 }
 
 void SinkInputWidget::onKill() {
@@ -94,8 +101,8 @@ void SinkInputWidget::onKill() {
 }
 
 void SinkInputWidget::buildMenu() {
-  for (auto & sinkWidget : mpMainWindow->sinkWidgets) {
-      menu->addAction(new SinkMenuItem{this, sinkWidget.second->description.constData(), sinkWidget.second->index, sinkWidget.second->index == mSinkIndex, menu});
+  for (auto & sink : mpMainWindow->sinks) {
+      menu->addAction(new SinkMenuItem{this, sink.second.description.constData(), sink.first, sink.first == mSinkIndex, menu});
   }
 }
 
@@ -23,6 +23,9 @@
 #endif
 
 #include "sinkwidget.h"
+#include "mainwindow.h"
+#include "operationcoalescer.h"
+#include <QAction>
 
 // #include <canberra-gtk.h>
 #if HAVE_EXT_DEVICE_RESTORE_API
@@ -65,7 +68,7 @@ SinkWidget::SinkWidget(MainWindow *parent) :
     encodings[i].widget = encodingFormatAAC;
     encodings[i].widget->setEnabled(false);
 #ifdef PA_ENCODING_MPEG2_AAC_IEC61937
-    if (pa_context_get_server_protocol_version(get_context()) >= 28) {
+    if (get_server_protocol_version() >= 28) {
         encodings[i].encoding = PA_ENCODING_MPEG2_AAC_IEC61937;
         connect(encodings[i].widget, &QCheckBox::toggled, this, &SinkWidget::onEncodingsChange);
         encodings[i].widget->setEnabled(true);
@@ -73,16 +76,25 @@ SinkWidget::SinkWidget(MainWindow *parent) :
 #endif
 #endif
 
+    QAction *loudness = new QAction{tr("Loudness (EBU R128)"), this};
+    loudness->setCheckable(true);
+    connect(loudness, &QAction::toggled, this, [this, loudness] (bool checked) {
+        if (checked)
+            startLoudness(monitor_index);
+        else
+            stopLoudness();
+        loudness->setChecked(loudnessShown());
+    });
+    addAction(loudness);
 }
 
 void SinkWidget::executeVolumeUpdate() {
-    pa_operation* o;
-    if (!(o = pa_context_set_sink_volume_by_index(get_context(), index, &volume, nullptr, nullptr))) {
-        show_error(tr("pa_context_set_sink_volume_by_index() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const uint32_t idx = index;
+    const pa_cvolume v = volume;
+    mpMainWindow->operations->submit(OperationCoalescer::SinkVolume, idx, tr("pa_context_set_sink_volume_by_index() failed"),
+        [idx, v] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_sink_volume_by_index(get_context(), idx, &v, cb, userdata);
+        });
 }
 
 void SinkWidget::onMuteToggleButton() {
@@ -91,13 +103,12 @@ void SinkWidget::onMuteToggleButton() {
     if (updating)
         return;
 
-    pa_operation* o;
-    if (!(o = pa_context_set_sink_mute_by_index(get_context(), index, muteToggleButton->isChecked(), nullptr, nullptr))) {
-        show_error(tr("pa_context_set_sink_mute_by_index() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const uint32_t idx = index;
+    const int mute = muteToggleButton->isChecked();
+    mpMainWindow->operations->submit(OperationCoalescer::SinkMute, idx, tr("pa_context_set_sink_mute_by_index() failed"),
+        [idx, mute] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_sink_mute_by_index(get_context(), idx, mute, cb, userdata);
+        });
 }
 
 void SinkWidget::onDefaultToggleButton() {
@@ -119,18 +130,20 @@ void SinkWidget::onPortChange() {
 
     int sel = portList->currentIndex();
     if (sel != -1) {
-        pa_operation* o;
-        QByteArray port = portList->itemData(sel).toString().toUtf8();
+        const uint32_t idx = index;
+        const QByteArray port = portList->itemData(sel).toString().toUtf8();
 
-        if (!(o = pa_context_set_sink_port_by_index(get_context(), index, port.constData(), nullptr, nullptr))) {
-            show_error(tr("pa_context_set_sink_port_by_index() failed").toUtf8().constData());
-            return;
-        }
-
-        pa_operation_unref(o);
+        mpMainWindow->operations->submit(OperationCoalescer::SinkPort, idx, tr("pa_context_set_sink_port_by_index() failed"),
+            [idx, port] (pa_context_success_cb_t cb, void *userdata) {
+                return pa_context_set_sink_port_by_index(get_context(), idx, port.constData(), cb, userdata);
+            });
     }
 }
 
+void SinkWidget::onSpectrum() {
+    mpMainWindow->showSpectrum(monitor_index, PA_INVALID_INDEX, QString::fromUtf8(description));
+}
+
 void SinkWidget::setDigital(bool digital) {
 #if HAVE_EXT_DEVICE_RESTORE_API
     if (digital) {
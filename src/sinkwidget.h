@@ -58,6 +58,7 @@ public:
 
 protected Q_SLOTS:
     virtual void onPortChange();
+    virtual void onSpectrum();
     virtual void onEncodingsChange();
 };
 
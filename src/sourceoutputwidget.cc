@@ -24,6 +24,7 @@
 
 #include "sourceoutputwidget.h"
 #include "mainwindow.h"
+#include "operationcoalescer.h"
 #include "sourcewidget.h"
 #include <QMenu>
 
@@ -52,10 +53,8 @@ SourceOutputWidget::~SourceOutputWidget(void) {
 void SourceOutputWidget::setSourceIndex(uint32_t idx) {
     mSourceIndex = idx;
 
-    if (mpMainWindow->sourceWidgets.count(idx)) {
-      SourceWidget *w = mpMainWindow->sourceWidgets[idx];
-      deviceButton->setText(QString::fromUtf8(w->description));
-    }
+    if (mpMainWindow->sources.count(idx))
+      deviceButton->setText(QString::fromUtf8(mpMainWindow->sources[idx].description));
     else
       deviceButton->setText(tr("Unknown input"));
 }
@@ -66,14 +65,12 @@ uint32_t SourceOutputWidget::sourceIndex() {
 
 #if HAVE_SOURCE_OUTPUT_VOLUMES
 void SourceOutputWidget::executeVolumeUpdate() {
-    pa_operation* o;
-
-    if (!(o = pa_context_set_source_output_volume(get_context(), index, &volume, nullptr, nullptr))) {
-        show_error(tr("pa_context_set_source_output_volume() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const uint32_t idx = index;
+    const pa_cvolume v = volume;
+    mpMainWindow->operations->submit(OperationCoalescer::SourceOutputVolume, idx, tr("pa_context_set_source_output_volume() failed"),
+        [idx, v] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_source_output_volume(get_context(), idx, &v, cb, userdata);
+        });
 }
 
 void SourceOutputWidget::onMuteToggleButton() {
@@ -82,13 +79,12 @@ void SourceOutputWidget::onMuteToggleButton() {
     if (updating)
         return;
 
-    pa_operation* o;
-    if (!(o = pa_context_set_source_output_mute(get_context(), index, muteToggleButton->isChecked(), nullptr, nullptr))) {
-        show_error(tr("pa_context_set_source_output_mute() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const uint32_t idx = index;
+    const int mute = muteToggleButton->isChecked();
+    mpMainWindow->operations->submit(OperationCoalescer::SourceOutputMute, idx, tr("pa_context_set_source_output_mute() failed"),
+        [idx, mute] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_source_output_mute(get_context(), idx, mute, cb, userdata);
+        });
 }
 #endif
 
@@ -104,8 +100,8 @@ void SourceOutputWidget::onKill() {
 
 
 void SourceOutputWidget::buildMenu() {
-  for (auto & sourceWidget : mpMainWindow->sourceWidgets) {
-      menu->addAction(new SourceMenuItem{this, sourceWidget.second->description.constData(), sourceWidget.second->index, sourceWidget.second->index == mSourceIndex, menu});
+  for (auto & source : mpMainWindow->sources) {
+      menu->addAction(new SourceMenuItem{this, source.second.description.constData(), source.first, source.first == mSourceIndex, menu});
   }
 }
 
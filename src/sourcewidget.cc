@@ -23,20 +23,20 @@
 #endif
 
 #include "sourcewidget.h"
+#include "mainwindow.h"
+#include "operationcoalescer.h"
 
 SourceWidget::SourceWidget(MainWindow *parent) :
     DeviceWidget(parent, "source") {
 }
 
 void SourceWidget::executeVolumeUpdate() {
-    pa_operation* o;
-
-    if (!(o = pa_context_set_source_volume_by_index(get_context(), index, &volume, nullptr, nullptr))) {
-        show_error(tr("pa_context_set_source_volume_by_index() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const uint32_t idx = index;
+    const pa_cvolume v = volume;
+    mpMainWindow->operations->submit(OperationCoalescer::SourceVolume, idx, tr("pa_context_set_source_volume_by_index() failed"),
+        [idx, v] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_source_volume_by_index(get_context(), idx, &v, cb, userdata);
+        });
 }
 
 void SourceWidget::onMuteToggleButton() {
@@ -45,13 +45,12 @@ void SourceWidget::onMuteToggleButton() {
     if (updating)
         return;
 
-    pa_operation* o;
-    if (!(o = pa_context_set_source_mute_by_index(get_context(), index, muteToggleButton->isChecked(), nullptr, nullptr))) {
-        show_error(tr("pa_context_set_source_mute_by_index() failed").toUtf8().constData());
-        return;
-    }
-
-    pa_operation_unref(o);
+    const uint32_t idx = index;
+    const int mute = muteToggleButton->isChecked();
+    mpMainWindow->operations->submit(OperationCoalescer::SourceMute, idx, tr("pa_context_set_source_mute_by_index() failed"),
+        [idx, mute] (pa_context_success_cb_t cb, void *userdata) {
+            return pa_context_set_source_mute_by_index(get_context(), idx, mute, cb, userdata);
+        });
 }
 
 void SourceWidget::onDefaultToggleButton() {
@@ -73,14 +72,16 @@ void SourceWidget::onPortChange() {
 
     int current = portList->currentIndex();
     if (current != -1) {
-        pa_operation* o;
-        QByteArray port = portList->itemData(current).toByteArray();
+        const uint32_t idx = index;
+        const QByteArray port = portList->itemData(current).toByteArray();
 
-        if (!(o = pa_context_set_source_port_by_index(get_context(), index, port.constData(), nullptr, nullptr))) {
-            show_error(tr("pa_context_set_source_port_by_index() failed").toUtf8().constData());
-        return;
+        mpMainWindow->operations->submit(OperationCoalescer::SourcePort, idx, tr("pa_context_set_source_port_by_index() failed"),
+            [idx, port] (pa_context_success_cb_t cb, void *userdata) {
+                return pa_context_set_source_port_by_index(get_context(), idx, port.constData(), cb, userdata);
+            });
     }
+}
 
-    pa_operation_unref(o);
-    }
+void SourceWidget::onSpectrum() {
+    mpMainWindow->showSpectrum(index, PA_INVALID_INDEX, QString::fromUtf8(description));
 }
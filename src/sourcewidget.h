@@ -40,6 +40,7 @@ public:
 
 protected:
     virtual void onPortChange();
+    virtual void onSpectrum();
 };
 
 #endif
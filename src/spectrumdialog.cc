@@ -0,0 +1,322 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "spectrumdialog.h"
+
+#include <QEvent>
+#include <QGuiApplication>
+#include <QPainter>
+#include <QScreen>
+#include <QVBoxLayout>
+
+#include <algorithm>
+#include <cmath>
+
+/* 8192 points, a resolution of about 6 Hz at 48 kHz, enough to tell hum
+ * at 50 Hz from hum at 60 Hz */
+#define FFT_ORDER 13
+#define SPECTRUM_BANDS 160
+#define LOWEST_FREQUENCY 20.
+#define HIGHEST_FREQUENCY 20000.
+#define FLOOR_DB -100.f
+#define FALL_DB_PER_SECOND 60.f
+
+/*** SpectrumWorker ***/
+
+SpectrumWorker::SpectrumWorker(QObject *parent) :
+    QThread(parent),
+    mPlan(FFT_ORDER),
+    mRing(nullptr),
+    mAnalyzed(0),
+    mLastFrame(0),
+    mLowest(LOWEST_FREQUENCY),
+    mHighest(HIGHEST_FREQUENCY),
+    mRequested(false),
+    mStopping(false),
+    mFresh(false) {
+}
+
+SpectrumWorker::~SpectrumWorker() {
+    stopAnalysis();
+}
+
+void SpectrumWorker::startAnalysis(const SampleRing *ring, uint32_t rate) {
+    const size_t n = mPlan.size();
+
+    stopAnalysis();
+
+    mRing = ring;
+    mAnalyzed = 0;
+    mLastFrame = g_get_monotonic_time();
+    mStopping = mRequested = mFresh = false;
+
+    /* Hann, whose coherent gain of one half is made up for in analyze() */
+    mWindow.resize(n);
+    for (size_t i = 0; i < n; i++)
+        mWindow[i] = (float) (0.5 - 0.5 * std::cos(2 * M_PI * i / n));
+
+    mSamples.resize(n);
+    mBins.resize(n);
+
+    mLowest = LOWEST_FREQUENCY;
+    mHighest = std::min(HIGHEST_FREQUENCY, rate / 2.);
+
+    /* Bands narrower than a bin share it */
+    mBandBins.resize(SPECTRUM_BANDS + 1);
+    for (size_t b = 0; b <= SPECTRUM_BANDS; b++) {
+        const double f = mLowest * std::pow(mHighest / mLowest, (double) b / SPECTRUM_BANDS);
+        mBandBins[b] = std::min((size_t) (f * n / rate), n / 2 - 1);
+    }
+
+    mBands.assign(SPECTRUM_BANDS, FLOOR_DB);
+    mResult.assign(SPECTRUM_BANDS, FLOOR_DB);
+
+    start();
+}
+
+void SpectrumWorker::stopAnalysis() {
+    {
+        QMutexLocker lock(&mMutex);
+        mStopping = true;
+        mWake.wakeOne();
+    }
+    wait();
+}
+
+void SpectrumWorker::requestFrame() {
+    QMutexLocker lock(&mMutex);
+    mRequested = true;
+    mWake.wakeOne();
+}
+
+bool SpectrumWorker::takeResult(std::vector<float> &bands) {
+    QMutexLocker lock(&mMutex);
+
+    if (!mFresh)
+        return false;
+
+    mFresh = false;
+    bands.assign(mResult.begin(), mResult.end());
+    return true;
+}
+
+void SpectrumWorker::run() {
+    QMutexLocker lock(&mMutex);
+
+    for (;;) {
+        while (!mRequested && !mStopping)
+            mWake.wait(&mMutex);
+
+        if (mStopping)
+            return;
+
+        mRequested = false;
+
+        lock.unlock();
+        const bool fresh = analyze();
+        lock.relock();
+
+        if (fresh) {
+            std::copy(mBands.begin(), mBands.end(), mResult.begin());
+            mFresh = true;
+        }
+    }
+}
+
+bool SpectrumWorker::analyze() {
+    const size_t n = mPlan.size();
+    const quint64 written = mRing->written();
+
+    /* Nothing new, the stream is corked or the source idle */
+    if (written < n || written == mAnalyzed)
+        return false;
+
+    if (!mRing->read(written - n, mSamples.data(), n))
+        return false;
+
+    mAnalyzed = written;
+
+    for (size_t i = 0; i < n; i++)
+        mBins[i] = std::complex<float>(mSamples[i] * mWindow[i], 0);
+
+    mPlan.transform(mBins.data());
+
+    /* A full scale sine shows at 0 dB: half of its power is in the
+     * mirrored bins, half of its amplitude is lost to the window */
+    const float scale = 4.f / n;
+    const gint64 now = g_get_monotonic_time();
+    const float fall = FALL_DB_PER_SECOND * (now - mLastFrame) / 1e6f;
+
+    mLastFrame = now;
+
+    for (size_t b = 0; b < SPECTRUM_BANDS; b++) {
+        const size_t end = std::max(mBandBins[b + 1], mBandBins[b] + 1);
+        float power = 0;
+
+        for (size_t k = mBandBins[b]; k < end; k++)
+            power = std::max(power, std::norm(mBins[k]));
+
+        const float db = std::max(10 * std::log10(power * scale * scale + 1e-20f), FLOOR_DB);
+        mBands[b] = std::max(db, mBands[b] - fall);
+    }
+
+    return true;
+}
+
+/*** SpectrumView ***/
+
+SpectrumView::SpectrumView(QWidget *parent) :
+    QWidget(parent),
+    bands(SPECTRUM_BANDS, FLOOR_DB),
+    mLowest(LOWEST_FREQUENCY),
+    mHighest(HIGHEST_FREQUENCY),
+    mPolygon(SPECTRUM_BANDS + 2),
+    mCacheDpr(0) {
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void SpectrumView::setRange(double lowest, double highest) {
+    mLowest = lowest;
+    mHighest = highest;
+    mCacheSize = QSize();
+    update();
+}
+
+QSize SpectrumView::sizeHint() const {
+    return QSize(fontMetrics().averageCharWidth() * 80, fontMetrics().height() * 16);
+}
+
+void SpectrumView::changeEvent(QEvent *event) {
+    if (event->type() == QEvent::PaletteChange || event->type() == QEvent::StyleChange || event->type() == QEvent::FontChange)
+        mCacheSize = QSize();
+    QWidget::changeEvent(event);
+}
+
+void SpectrumView::updateCache() {
+    const qreal dpr = devicePixelRatioF();
+
+    if (mCacheSize == size() && mCacheDpr == dpr)
+        return;
+
+    mCacheSize = size();
+    mCacheDpr = dpr;
+
+    mBackground = QPixmap(size() * dpr);
+    mBackground.setDevicePixelRatio(dpr);
+
+    QPainter p(&mBackground);
+    const double span = std::log(mHighest / mLowest);
+    QColor grid = palette().color(QPalette::Mid);
+
+    p.fillRect(rect(), palette().color(QPalette::Base));
+    p.setPen(grid);
+
+    for (float db = 0; db > FLOOR_DB; db -= 20) {
+        const int y = qRound(db / FLOOR_DB * height());
+        p.drawLine(0, y, width(), y);
+        p.drawText(2, y + fontMetrics().ascent() + 1, tr("%1 dB").arg(db));
+    }
+
+    for (double f : {50., 100., 200., 500., 1000., 2000., 5000., 10000., 20000.}) {
+        if (f < mLowest || f > mHighest)
+            continue;
+
+        const int x = qRound(std::log(f / mLowest) / span * width());
+        p.drawLine(x, 0, x, height());
+        p.drawText(x + 2, height() - fontMetrics().descent() - 1,
+                   f >= 1000 ? tr("%1k").arg(f / 1000) : QString::number(f));
+    }
+}
+
+void SpectrumView::paintEvent(QPaintEvent *) {
+    QPainter p(this);
+    const double w = width(), h = height();
+
+    updateCache();
+    p.drawPixmap(0, 0, mBackground);
+
+    /* The points are updated in place, the polygon keeps its storage */
+    mPolygon[0] = QPointF(0, h);
+    for (size_t b = 0; b < bands.size(); b++)
+        mPolygon[b + 1] = QPointF((b + 0.5) / bands.size() * w, bands[b] / FLOOR_DB * h);
+    mPolygon[bands.size() + 1] = QPointF(w, h);
+
+    QColor c = palette().color(QPalette::Highlight);
+    p.setPen(c);
+    c.setAlpha(128);
+    p.setBrush(c);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.drawPolygon(mPolygon);
+}
+
+/*** SpectrumDialog ***/
+
+SpectrumDialog::SpectrumDialog(const QString &title, QWidget *parent) :
+    QDialog(parent),
+    mTap(true, 1, [this] { ready(); }, nullptr, [this] { close(); }),
+    mView(new SpectrumView(this)) {
+
+    setAttribute(Qt::WA_DeleteOnClose);
+    setWindowTitle(tr("Spectrum of %1").arg(title));
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(mView);
+
+    /* One analysis per refresh of the screen */
+    const qreal refresh = QGuiApplication::primaryScreen()->refreshRate();
+    mTimer.setInterval(refresh > 0 ? qRound(1000 / refresh) : 16);
+    connect(&mTimer, &QTimer::timeout, this, &SpectrumDialog::frame);
+}
+
+SpectrumDialog::~SpectrumDialog() {
+    mWorker.stopAnalysis();
+}
+
+bool SpectrumDialog::monitor(uint32_t source_idx, uint32_t stream_idx) {
+    return mTap.connect(source_idx, stream_idx);
+}
+
+void SpectrumDialog::ready() {
+    mWorker.startAnalysis(mTap.ring(), mTap.rate());
+    mView->setRange(mWorker.lowestFrequency(), mWorker.highestFrequency());
+}
+
+void SpectrumDialog::showEvent(QShowEvent *event) {
+    mTap.setCorked(false);
+    mTimer.start();
+    QDialog::showEvent(event);
+}
+
+void SpectrumDialog::hideEvent(QHideEvent *event) {
+    mTap.setCorked(true);
+    mTimer.stop();
+    QDialog::hideEvent(event);
+}
+
+void SpectrumDialog::frame() {
+    if (!mWorker.isRunning())
+        return;
+
+    if (mWorker.takeResult(mView->bands))
+        mView->update();
+
+    mWorker.requestFrame();
+}
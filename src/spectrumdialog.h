@@ -0,0 +1,130 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef spectrumdialog_h
+#define spectrumdialog_h
+
+#include "pavucontrol.h"
+#include "fftplan.h"
+#include "sampletap.h"
+
+#include <QDialog>
+#include <QMutex>
+#include <QPixmap>
+#include <QPolygonF>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+#include <complex>
+#include <vector>
+
+/* Runs a windowed FFT over the latest samples of a ring, once per frame
+ * asked for, and reduces it to log-spaced bands in dB. Every buffer is
+ * allocated when started, so that frames do not allocate. */
+class SpectrumWorker : public QThread {
+public:
+    SpectrumWorker(QObject *parent = nullptr);
+    ~SpectrumWorker();
+
+    void startAnalysis(const SampleRing *ring, uint32_t rate);
+    void stopAnalysis();
+
+    /* Analyzes the samples as they are once the thread gets to it */
+    void requestFrame();
+    /* Copies the latest bands, if there are new ones since last taken */
+    bool takeResult(std::vector<float> &bands);
+
+    double lowestFrequency() const { return mLowest; }
+    double highestFrequency() const { return mHighest; }
+
+protected:
+    void run() override;
+
+private:
+    bool analyze();
+
+    FftPlan mPlan;
+    const SampleRing *mRing;
+    quint64 mAnalyzed;
+    gint64 mLastFrame;
+    double mLowest, mHighest;
+
+    std::vector<float> mWindow;
+    std::vector<float> mSamples;
+    std::vector<std::complex<float> > mBins;
+    /* First bin of each band, and the end of the last */
+    std::vector<size_t> mBandBins;
+    std::vector<float> mBands;
+
+    QMutex mMutex;
+    QWaitCondition mWake;
+    bool mRequested, mStopping, mFresh;
+    std::vector<float> mResult;
+};
+
+/* Draws bands in dB over a log frequency scale */
+class SpectrumView : public QWidget {
+    Q_OBJECT
+public:
+    SpectrumView(QWidget *parent = nullptr);
+
+    void setRange(double lowest, double highest);
+    std::vector<float> bands;
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void changeEvent(QEvent *event) override;
+
+private:
+    void updateCache();
+
+    double mLowest, mHighest;
+    QPolygonF mPolygon;
+
+    /* Grid and labels, per size and device pixel ratio */
+    QPixmap mBackground;
+    QSize mCacheSize;
+    qreal mCacheDpr;
+};
+
+/* The spectrum of a source, or of a sink input. The stream only runs while
+ * the dialog is shown, which is deleted once closed. */
+class SpectrumDialog : public QDialog {
+    Q_OBJECT
+public:
+    SpectrumDialog(const QString &title, QWidget *parent = nullptr);
+    ~SpectrumDialog();
+
+    bool monitor(uint32_t source_idx, uint32_t stream_idx = PA_INVALID_INDEX);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void ready();
+    void frame();
+
+    SampleTap mTap;
+    SpectrumWorker mWorker;
+    SpectrumView *mView;
+    QTimer mTimer;
+};
+
+#endif
@@ -0,0 +1,194 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+/* Checks the FFT against a plain DFT and on sines of known frequency, and
+ * the sample ring across its wrap-around and when a reader falls behind,
+ * and prints how long a transform of the spectrum dialog's size takes */
+
+#include "fftplan.h"
+#include "samplering.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static int failures = 0;
+
+static void fail(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static void fail(const char *format, ...) {
+    va_list ap;
+
+    if (failures++ >= 10)
+        return;
+
+    va_start(ap, format);
+    std::vfprintf(stderr, format, ap);
+    va_end(ap);
+    std::fputc('\n', stderr);
+}
+
+static std::vector<std::complex<float> > dft(const std::vector<std::complex<float> > &data) {
+    const size_t n = data.size();
+    std::vector<std::complex<float> > out(n);
+
+    for (size_t k = 0; k < n; k++) {
+        std::complex<double> s = 0;
+        for (size_t i = 0; i < n; i++)
+            s += std::complex<double>(data[i]) * std::polar(1.0, -2 * M_PI * ((k * i) % n) / n);
+        out[k] = std::complex<float>(s);
+    }
+
+    return out;
+}
+
+static void check_dft() {
+    srand(1);
+
+    for (unsigned order = 0; order <= 9; order++) {
+        const FftPlan plan(order);
+        std::vector<std::complex<float> > data(plan.size());
+
+        for (auto & v : data)
+            v = std::complex<float>(static_cast<float>(rand()) / RAND_MAX * 2 - 1,
+                                    static_cast<float>(rand()) / RAND_MAX * 2 - 1);
+
+        const std::vector<std::complex<float> > ref = dft(data);
+        plan.transform(data.data());
+
+        for (size_t k = 0; k < data.size(); k++)
+            if (std::abs(data[k] - ref[k]) > 1e-4f * data.size())
+                fail("order %u, bin %zu: %g%+gi, expected %g%+gi", order, k,
+                     data[k].real(), data[k].imag(), ref[k].real(), ref[k].imag());
+    }
+}
+
+/* A real sine of a whole number of periods lands in its bin and the mirror
+ * of it, each with half of its amplitude times the size */
+static void check_sine() {
+    const FftPlan plan(10);
+    const size_t n = plan.size();
+    std::vector<std::complex<float> > data(n);
+
+    for (size_t bin : {1, 5, 64, 100, 511}) {
+        for (size_t i = 0; i < n; i++)
+            data[i] = 0.5f * std::sin(static_cast<float>(2 * M_PI * bin * i / n));
+
+        plan.transform(data.data());
+
+        for (size_t k = 0; k < n; k++) {
+            const float expected = k == bin || k == n - bin ? 0.25f * n : 0;
+            if (std::fabs(std::abs(data[k]) - expected) > 1e-2f)
+                fail("sine in bin %zu: |bin %zu| = %g, expected %g", bin, k, std::abs(data[k]), expected);
+        }
+    }
+}
+
+static bool read_back(const SampleRing &ring, quint64 from, size_t n) {
+    std::vector<float> dst(n);
+
+    if (!ring.read(from, dst.data(), n))
+        return false;
+
+    for (size_t i = 0; i < n; i++)
+        if (dst[i] != static_cast<float>(from + i)) {
+            fail("ring: sample %llu is %g", (unsigned long long) (from + i), dst[i]);
+            break;
+        }
+
+    return true;
+}
+
+/* Each sample is its own position */
+static void write_counting(SampleRing &ring, size_t n) {
+    std::vector<float> data(n);
+
+    for (size_t i = 0; i < n; i++)
+        data[i] = static_cast<float>(ring.written() + i);
+
+    ring.write(data.data(), n);
+}
+
+static void check_ring() {
+    SampleRing ring(1000);
+
+    if (ring.capacity() != 1024)
+        fail("ring: capacity %zu, expected 1024", ring.capacity());
+
+    /* Blocks that do not divide the ring, so that some of them wrap */
+    for (int i = 0; i < 40; i++) {
+        write_counting(ring, 300);
+
+        const quint64 written = ring.written();
+        if (written != 300u * (i + 1))
+            fail("ring: %llu written, expected %u", (unsigned long long) written, 300u * (i + 1));
+
+        const size_t n = std::min<quint64>(written, ring.capacity());
+        if (!read_back(ring, written - n, n))
+            fail("ring: the last %zu of %llu samples are gone", n, (unsigned long long) written);
+        if (!read_back(ring, written - std::min<quint64>(written, 7), std::min<quint64>(written, 7)))
+            fail("ring: the last 7 of %llu samples are gone", (unsigned long long) written);
+    }
+
+    /* One more than the ring holds is overwritten */
+    const quint64 written = ring.written();
+    std::vector<float> dst(ring.capacity() + 1);
+    if (read_back(ring, written - ring.capacity() - 1, 1))
+        fail("ring: an overwritten sample was read");
+    if (ring.read(written - ring.capacity() - 1, dst.data(), dst.size()))
+        fail("ring: read more than it holds");
+
+    /* Only the end of a block larger than the ring is kept */
+    write_counting(ring, 3000);
+    if (ring.written() != written + 3000)
+        fail("ring: %llu written, expected %llu", (unsigned long long) ring.written(), (unsigned long long) (written + 3000));
+    if (!read_back(ring, ring.written() - ring.capacity(), ring.capacity()))
+        fail("ring: the end of a large block is gone");
+}
+
+int main() {
+    check_dft();
+    check_sine();
+    check_ring();
+
+    /* The size the spectrum dialog analyzes */
+    const FftPlan plan(13);
+    const std::vector<std::complex<float> > input(plan.size(), 0.5f);
+    std::vector<std::complex<float> > data(plan.size());
+    const int rounds = 1000;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < rounds; i++) {
+        std::copy(input.begin(), input.end(), data.begin());
+        plan.transform(data.data());
+    }
+
+    const std::chrono::duration<double, std::micro> took = std::chrono::steady_clock::now() - start;
+    std::printf("%zu points: %.1f us per transform\n", plan.size(), took.count() / rounds);
+
+    if (failures) {
+        std::fprintf(stderr, "%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "streamlistmodel.h"
+#include "channel.h"
+#include "operationcoalescer.h"
+
+#include <algorithm>
+
+StreamListModel::StreamListModel(Kind kind, OperationCoalescer *operations, QObject *parent) :
+    QAbstractListModel(parent),
+    mKind(kind),
+    mOperations(operations) {
+}
+
+std::vector<StreamListModel::Entry>::iterator StreamListModel::find(uint32_t index) {
+    return std::lower_bound(mEntries.begin(), mEntries.end(), index,
+                            [] (const Entry &e, uint32_t i) { return e.index < i; });
+}
+
+int StreamListModel::rowCount(const QModelIndex &parent) const {
+    if (parent.isValid())
+        return 0;
+    return static_cast<int>(mEntries.size());
+}
+
+Qt::ItemFlags StreamListModel::flags(const QModelIndex &index) const {
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
+}
+
+QVariant StreamListModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= rowCount())
+        return QVariant();
+
+    const Entry &e = mEntries[index.row()];
+
+    switch (role) {
+        case Qt::DisplayRole:
+            if (e.clientName.isEmpty())
+                return e.name;
+            return tr("%1: %2").arg(e.clientName, e.name);
+        case Qt::ToolTipRole:
+        case NameRole:
+            return e.name;
+        case Qt::DecorationRole:
+            return e.icon;
+        case IndexRole:
+            return e.index;
+        case TypeRole:
+            return e.type;
+        case ClientNameRole:
+            return e.clientName;
+        case DeviceRole:
+            return e.device;
+        case DeviceNameRole:
+            return e.deviceName;
+        case VolumeRole:
+            return paVolume2Percent(pa_cvolume_max(&e.volume));
+        case MuteRole:
+            return e.mute;
+        case HasVolumeRole:
+            return e.hasVolume;
+    }
+
+    return QVariant();
+}
+
+bool StreamListModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    if (!index.isValid() || index.row() >= rowCount())
+        return false;
+
+    Entry &e = mEntries[index.row()];
+    const uint32_t idx = e.index;
+
+    if (role == VolumeRole && e.hasVolume) {
+        pa_cvolume volume = e.volume;
+
+        /* Scale all channels so the balance is kept */
+        pa_cvolume_scale(&volume, percent2PaVolume(value.toInt()));
+
+        if (mKind == SinkInputs) {
+            mOperations->submit(OperationCoalescer::SinkInputVolume, idx, tr("pa_context_set_sink_input_volume() failed"),
+                [idx, volume] (pa_context_success_cb_t cb, void *userdata) {
+                    return pa_context_set_sink_input_volume(get_context(), idx, &volume, cb, userdata);
+                });
+        } else {
+#if HAVE_SOURCE_OUTPUT_VOLUMES
+            mOperations->submit(OperationCoalescer::SourceOutputVolume, idx, tr("pa_context_set_source_output_volume() failed"),
+                [idx, volume] (pa_context_success_cb_t cb, void *userdata) {
+                    return pa_context_set_source_output_volume(get_context(), idx, &volume, cb, userdata);
+                });
+#endif
+        }
+        e.volume = volume;
+
+    } else if (role == MuteRole && e.hasVolume) {
+        const int mute = value.toBool();
+
+        if (mKind == SinkInputs) {
+            mOperations->submit(OperationCoalescer::SinkInputMute, idx, tr("pa_context_set_sink_input_mute() failed"),
+                [idx, mute] (pa_context_success_cb_t cb, void *userdata) {
+                    return pa_context_set_sink_input_mute(get_context(), idx, mute, cb, userdata);
+                });
+        } else {
+#if HAVE_SOURCE_OUTPUT_VOLUMES
+            mOperations->submit(OperationCoalescer::SourceOutputMute, idx, tr("pa_context_set_source_output_mute() failed"),
+                [idx, mute] (pa_context_success_cb_t cb, void *userdata) {
+                    return pa_context_set_source_output_mute(get_context(), idx, mute, cb, userdata);
+                });
+#endif
+        }
+        e.mute = mute;
+
+    } else
+        return false;
+
+    Q_EMIT dataChanged(index, index, {role});
+    return true;
+}
+
+void StreamListModel::update(const Entry &entry) {
+    auto it = find(entry.index);
+    const int row = static_cast<int>(it - mEntries.begin());
+
+    if (it != mEntries.end() && it->index == entry.index) {
+        *it = entry;
+        Q_EMIT dataChanged(index(row), index(row));
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), row, row);
+    mEntries.insert(it, entry);
+    endInsertRows();
+}
+
+void StreamListModel::remove(uint32_t index) {
+    auto it = find(index);
+
+    if (it == mEntries.end() || it->index != index)
+        return;
+
+    const int row = static_cast<int>(it - mEntries.begin());
+    beginRemoveRows(QModelIndex(), row, row);
+    mEntries.erase(it);
+    endRemoveRows();
+}
+
+void StreamListModel::clear() {
+    beginResetModel();
+    mEntries.clear();
+    endResetModel();
+}
+
+void StreamListModel::setClientName(uint32_t client, const QString &name) {
+    for (int row = 0; row < rowCount(); ++row) {
+        Entry &e = mEntries[row];
+
+        if (e.client != client || e.clientName == name)
+            continue;
+
+        e.clientName = name;
+        Q_EMIT dataChanged(index(row), index(row), {Qt::DisplayRole, ClientNameRole});
+    }
+}
+
+void StreamListModel::setDeviceName(uint32_t device, const QString &name) {
+    for (int row = 0; row < rowCount(); ++row) {
+        Entry &e = mEntries[row];
+
+        if (e.device != device || e.deviceName == name)
+            continue;
+
+        e.deviceName = name;
+        Q_EMIT dataChanged(index(row), index(row), {DeviceNameRole});
+    }
+}
+
+void StreamListModel::moveStream(uint32_t index, uint32_t device) {
+    pa_operation *o;
+
+    if (mKind == SinkInputs) {
+        if (!(o = pa_context_move_sink_input_by_index(get_context(), index, device, nullptr, nullptr))) {
+            show_error(tr("pa_context_move_sink_input_by_index() failed").toUtf8().constData());
+            return;
+        }
+    } else {
+        if (!(o = pa_context_move_source_output_by_index(get_context(), index, device, nullptr, nullptr))) {
+            show_error(tr("pa_context_move_source_output_by_index() failed").toUtf8().constData());
+            return;
+        }
+    }
+
+    pa_operation_unref(o);
+}
+
+void StreamListModel::killStream(uint32_t index) {
+    pa_operation *o;
+
+    if (mKind == SinkInputs) {
+        if (!(o = pa_context_kill_sink_input(get_context(), index, nullptr, nullptr))) {
+            show_error(tr("pa_context_kill_sink_input() failed").toUtf8().constData());
+            return;
+        }
+    } else {
+        if (!(o = pa_context_kill_source_output(get_context(), index, nullptr, nullptr))) {
+            show_error(tr("pa_context_kill_source_output() failed").toUtf8().constData());
+            return;
+        }
+    }
+
+    pa_operation_unref(o);
+}
@@ -0,0 +1,92 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef streamlistmodel_h
+#define streamlistmodel_h
+
+#include "pavucontrol.h"
+
+#include <QAbstractListModel>
+#include <QIcon>
+#include <vector>
+
+class OperationCoalescer;
+
+/* Flat registry of the playback or recording streams, used by the list view
+ * that replaces the per-stream widgets when there are many streams. Rows are
+ * kept sorted by stream index. */
+class StreamListModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum Kind {
+        SinkInputs,
+        SourceOutputs
+    };
+
+    enum Roles {
+        IndexRole = Qt::UserRole + 1,
+        TypeRole,
+        NameRole,
+        ClientNameRole,
+        DeviceRole,
+        DeviceNameRole,
+        VolumeRole,
+        MuteRole,
+        HasVolumeRole
+    };
+
+    struct Entry {
+        uint32_t index;
+        uint32_t client;
+        uint32_t device;
+        int type;
+        QString name;
+        QString clientName;
+        QString deviceName;
+        QIcon icon;
+        pa_cvolume volume;
+        bool mute;
+        bool hasVolume;
+    };
+
+    StreamListModel(Kind kind, OperationCoalescer *operations, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    Kind kind() const { return mKind; }
+
+    void update(const Entry &entry);
+    void remove(uint32_t index);
+    void clear();
+    void setClientName(uint32_t client, const QString &name);
+    void setDeviceName(uint32_t device, const QString &name);
+
+    void moveStream(uint32_t index, uint32_t device);
+    void killStream(uint32_t index);
+
+private:
+    std::vector<Entry>::iterator find(uint32_t index);
+
+    Kind mKind;
+    OperationCoalescer *mOperations;
+    std::vector<Entry> mEntries;
+};
+
+#endif
@@ -0,0 +1,254 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "streamlistview.h"
+#include "streamlistmodel.h"
+#include "channel.h"
+
+#include <QApplication>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QSlider>
+#include <QToolButton>
+
+#define ROW_MARGIN 4
+
+static int iconSize(const QWidget *widget) {
+    const QStyle *style = widget ? widget->style() : QApplication::style();
+    return style->pixelMetric(QStyle::PM_ToolBarIconSize);
+}
+
+/*** StreamRowEditor ***/
+StreamRowEditor::StreamRowEditor(QWidget *parent) :
+    QWidget(parent),
+    muteToggleButton(new QToolButton(this)),
+    volumeScale(new QSlider(Qt::Horizontal, this)),
+    volumeLabel(new QLabel(this)) {
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(volumeScale, 1);
+    layout->addWidget(volumeLabel);
+    layout->addWidget(muteToggleButton);
+
+    muteToggleButton->setIcon(QIcon::fromTheme(QStringLiteral("audio-volume-muted")));
+    muteToggleButton->setToolTip(tr("Mute audio"));
+    muteToggleButton->setCheckable(true);
+
+    volumeScale->setRange(paVolume2Percent(PA_VOLUME_MUTED), paVolume2Percent(PA_VOLUME_UI_MAX));
+    volumeScale->setPageStep(5);
+    volumeScale->setTracking(false);
+
+    volumeLabel->setFixedWidth(QFontMetrics{volumeLabel->font()}.size(Qt::TextSingleLine, QStringLiteral("100%")).width());
+    volumeLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+    setAutoFillBackground(true);
+
+    connect(muteToggleButton, &QToolButton::toggled, this, &StreamRowEditor::changed);
+    connect(volumeScale, &QSlider::valueChanged, this, &StreamRowEditor::changed);
+    connect(volumeScale, &QSlider::sliderMoved, this, &StreamRowEditor::setVolume);
+}
+
+void StreamRowEditor::setVolume(int percent) {
+    volumeLabel->setText(tr("%1%", "volume slider label [X%]").arg(percent));
+}
+
+/*** StreamItemDelegate ***/
+StreamItemDelegate::StreamItemDelegate(QObject *parent) :
+    QStyledItemDelegate(parent) {
+}
+
+QSize StreamItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &/*index*/) const {
+    const int line = option.fontMetrics.height();
+    const int editor = qMax(line + 2 * ROW_MARGIN, iconSize(option.widget));
+    return QSize(line * 10, 3 * ROW_MARGIN + line + editor);
+}
+
+void StreamItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const {
+    QStyleOptionViewItem opt(option);
+    initStyleOption(&opt, index);
+
+    const QWidget *widget = option.widget;
+    const QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, widget);
+
+    const int icon = iconSize(widget);
+    const QRect r = option.rect.adjusted(ROW_MARGIN, ROW_MARGIN, -ROW_MARGIN, -ROW_MARGIN);
+    const QPalette::ColorRole textRole = option.state & QStyle::State_Selected ? QPalette::HighlightedText : QPalette::Text;
+
+    painter->save();
+
+    opt.icon.paint(painter, QRect(r.left(), r.top(), icon, icon));
+
+    QRect text(r.left() + icon + ROW_MARGIN, r.top(), r.width() - icon - ROW_MARGIN, option.fontMetrics.height());
+
+    /* Device on the right, the rest of the line for client and stream name */
+    const QString device = directionText + QLatin1Char(' ') + index.data(StreamListModel::DeviceNameRole).toString();
+    const int deviceWidth = qMin(option.fontMetrics.horizontalAdvance(device), text.width() / 3);
+    painter->setPen(option.palette.color(QPalette::Disabled, textRole));
+    painter->drawText(text, Qt::AlignRight | Qt::AlignVCenter,
+                      option.fontMetrics.elidedText(device, Qt::ElideMiddle, deviceWidth));
+    text.setRight(text.right() - deviceWidth - ROW_MARGIN);
+
+    painter->setPen(option.palette.color(QPalette::Normal, textRole));
+
+    const QString client = index.data(StreamListModel::ClientNameRole).toString();
+    if (!client.isEmpty()) {
+        QFont bold = option.font;
+        bold.setBold(true);
+        const QFontMetrics boldMetrics(bold);
+        const QString clientText = boldMetrics.elidedText(client, Qt::ElideRight, text.width() / 2);
+
+        painter->setFont(bold);
+        painter->drawText(text, Qt::AlignLeft | Qt::AlignVCenter, clientText);
+        text.setLeft(text.left() + boldMetrics.horizontalAdvance(clientText));
+        painter->setFont(option.font);
+    }
+
+    const QString name = client.isEmpty() ? index.data(StreamListModel::NameRole).toString()
+                                          : tr(": %1").arg(index.data(StreamListModel::NameRole).toString());
+    painter->drawText(text, Qt::AlignLeft | Qt::AlignVCenter,
+                      option.fontMetrics.elidedText(name, Qt::ElideMiddle, text.width()));
+
+    painter->restore();
+}
+
+QWidget *StreamItemDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &/*option*/, const QModelIndex &/*index*/) const {
+    StreamRowEditor *editor = new StreamRowEditor(parent);
+    connect(editor, &StreamRowEditor::changed, this, [this, editor] {
+        Q_EMIT const_cast<StreamItemDelegate*>(this)->commitData(editor);
+    });
+    return editor;
+}
+
+void StreamItemDelegate::setEditorData(QWidget *editor, const QModelIndex &index) const {
+    StreamRowEditor *e = static_cast<StreamRowEditor*>(editor);
+
+    /* Do not fight the user while the slider is being dragged */
+    if (e->volumeScale->isSliderDown())
+        return;
+
+    const bool hasVolume = index.data(StreamListModel::HasVolumeRole).toBool();
+    const int volume = index.data(StreamListModel::VolumeRole).toInt();
+    const bool mute = index.data(StreamListModel::MuteRole).toBool();
+
+    e->blockSignals(true);
+    e->volumeScale->blockSignals(true);
+    e->muteToggleButton->blockSignals(true);
+
+    e->volumeScale->setValue(volume);
+    e->volumeScale->setEnabled(hasVolume && !mute);
+    e->muteToggleButton->setChecked(mute);
+    e->muteToggleButton->setEnabled(hasVolume);
+    e->setVolume(volume);
+
+    e->muteToggleButton->blockSignals(false);
+    e->volumeScale->blockSignals(false);
+    e->blockSignals(false);
+}
+
+void StreamItemDelegate::setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const {
+    StreamRowEditor *e = static_cast<StreamRowEditor*>(editor);
+
+    if (e->muteToggleButton->isChecked() != index.data(StreamListModel::MuteRole).toBool())
+        model->setData(index, e->muteToggleButton->isChecked(), StreamListModel::MuteRole);
+
+    if (e->volumeScale->value() != index.data(StreamListModel::VolumeRole).toInt())
+        model->setData(index, e->volumeScale->value(), StreamListModel::VolumeRole);
+}
+
+void StreamItemDelegate::updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem &option, const QModelIndex &/*index*/) const {
+    const int icon = iconSize(option.widget);
+    const QRect r = option.rect.adjusted(ROW_MARGIN, ROW_MARGIN, -ROW_MARGIN, -ROW_MARGIN);
+    const int top = r.top() + option.fontMetrics.height() + ROW_MARGIN;
+
+    editor->setGeometry(r.left() + icon + ROW_MARGIN, top, r.width() - icon - ROW_MARGIN, r.bottom() - top + 1);
+}
+
+/*** StreamListView ***/
+StreamListView::StreamListView(QWidget *parent) :
+    QListView(parent) {
+
+    setItemDelegate(new StreamItemDelegate(this));
+    setUniformItemSizes(true);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setContextMenuPolicy(Qt::CustomContextMenu);
+
+    mEditorTimer.setSingleShot(true);
+    mEditorTimer.setInterval(0);
+    connect(&mEditorTimer, &QTimer::timeout, this, &StreamListView::updateEditors);
+}
+
+void StreamListView::setModel(QAbstractItemModel *model) {
+    QListView::setModel(model);
+    mEditors.clear();
+
+    connect(model, &QAbstractItemModel::rowsInserted, this, &StreamListView::scheduleEditorUpdate);
+    connect(model, &QAbstractItemModel::rowsRemoved, this, &StreamListView::scheduleEditorUpdate);
+    connect(model, &QAbstractItemModel::modelReset, this, &StreamListView::scheduleEditorUpdate);
+    connect(model, &QAbstractItemModel::layoutChanged, this, &StreamListView::scheduleEditorUpdate);
+    scheduleEditorUpdate();
+}
+
+void StreamListView::scrollContentsBy(int dx, int dy) {
+    QListView::scrollContentsBy(dx, dy);
+    scheduleEditorUpdate();
+}
+
+void StreamListView::resizeEvent(QResizeEvent *event) {
+    QListView::resizeEvent(event);
+    scheduleEditorUpdate();
+}
+
+void StreamListView::scheduleEditorUpdate() {
+    if (!mEditorTimer.isActive())
+        mEditorTimer.start();
+}
+
+void StreamListView::updateEditors() {
+    QAbstractItemModel *m = model();
+    QList<QPersistentModelIndex> visible;
+
+    if (m && m->rowCount() > 0) {
+        const QRect r = viewport()->rect();
+        const QModelIndex first = indexAt(r.topLeft());
+        const QModelIndex last = indexAt(QPoint(r.left(), r.bottom()));
+        const int lastRow = last.isValid() ? last.row() : m->rowCount() - 1;
+
+        for (int row = first.isValid() ? first.row() : 0; row <= lastRow; ++row) {
+            const QModelIndex idx = m->index(row, 0);
+            if (visualRect(idx).intersects(r))
+                visible.append(idx);
+        }
+    }
+
+    for (const QPersistentModelIndex &idx : qAsConst(mEditors))
+        if (idx.isValid() && !visible.contains(idx))
+            closePersistentEditor(idx);
+
+    for (const QPersistentModelIndex &idx : qAsConst(visible))
+        if (!mEditors.contains(idx))
+            openPersistentEditor(idx);
+
+    mEditors = visible;
+}
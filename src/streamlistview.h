@@ -0,0 +1,85 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef streamlistview_h
+#define streamlistview_h
+
+#include <QListView>
+#include <QStyledItemDelegate>
+#include <QPersistentModelIndex>
+#include <QTimer>
+#include <QList>
+
+class QLabel;
+class QSlider;
+class QToolButton;
+
+/* Live controls of one row, only created for rows inside the viewport */
+class StreamRowEditor : public QWidget {
+    Q_OBJECT
+public:
+    explicit StreamRowEditor(QWidget *parent = nullptr);
+
+    QToolButton *muteToggleButton;
+    QSlider *volumeScale;
+    QLabel *volumeLabel;
+
+    void setVolume(int percent);
+
+Q_SIGNALS:
+    void changed();
+};
+
+/* Paints the name line of a stream row, the volume line is left to the
+ * row's editor */
+class StreamItemDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+public:
+    explicit StreamItemDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    void setEditorData(QWidget *editor, const QModelIndex &index) const override;
+    void setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const override;
+    void updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    QString directionText;
+};
+
+/* List view that keeps persistent editors open for the visible rows only */
+class StreamListView : public QListView {
+    Q_OBJECT
+public:
+    explicit StreamListView(QWidget *parent = nullptr);
+
+    void setModel(QAbstractItemModel *model) override;
+
+protected:
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    void scheduleEditorUpdate();
+    void updateEditors();
+
+    QTimer mEditorTimer;
+    QList<QPersistentModelIndex> mEditors;
+};
+
+#endif
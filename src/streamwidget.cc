@@ -26,19 +26,21 @@
 #include "mainwindow.h"
 #include "channel.h"
 #include <QAction>
+#include <QMouseEvent>
 
 /*** StreamWidget ***/
 StreamWidget::StreamWidget(MainWindow *parent) :
     MinimalStreamWidget(parent),
+    selected(false),
     mpMainWindow(parent),
-    terminate{new QAction{tr("Terminate"), this}} {
+    terminate{new QAction{tr("Terminate"), this}},
+    select{new QAction{tr("Select"), this}} {
 
     setupUi(this);
-    initPeakProgressBar(channelsGrid);
+    initPeakMeter(channelsGrid);
 
     timeout.setSingleShot(true);
     timeout.setInterval(100);
-    connect(&timeout, &QTimer::timeout, this, &StreamWidget::timeoutEvent);
 
     connect(muteToggleButton, &QToolButton::toggled, this, &StreamWidget::onMuteToggleButton);
     connect(lockToggleButton, &QToolButton::toggled, this, &StreamWidget::onLockToggleButton);
@@ -46,7 +48,16 @@ StreamWidget::StreamWidget(MainWindow *parent) :
 
     connect(terminate, &QAction::triggered, this, &StreamWidget::onKill);
     addAction(terminate);
-    setContextMenuPolicy(Qt::ActionsContextMenu);
+
+    select->setCheckable(true);
+    connect(select, &QAction::toggled, this, &StreamWidget::setSelected);
+    addAction(select);
+
+    /* The main window adds the changes to the selected streams */
+    setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(this, &QWidget::customContextMenuRequested, this, [this] (const QPoint &pos) {
+        mpMainWindow->showStreamMenu(this, mapToGlobal(pos));
+    });
 
     for (auto & channel : channels)
         channel = nullptr;
@@ -95,9 +106,8 @@ void StreamWidget::updateChannelVolume(int channel, pa_volume_t v) {
 
     setVolume(n, true);
 
-    if(!timeout.isActive()) {
-        timeout.start();
-    }
+    executeVolumeUpdate();
+    timeout.start();
 }
 
 void StreamWidget::hideLockedChannels(bool hide) {
@@ -119,11 +129,6 @@ void StreamWidget::onLockToggleButton() {
     hideLockedChannels(lockToggleButton->isChecked());
 }
 
-bool StreamWidget::timeoutEvent() {
-    executeVolumeUpdate();
-    return false;
-}
-
 void StreamWidget::executeVolumeUpdate() {
 }
 
@@ -132,3 +137,24 @@ void StreamWidget::onDeviceChangePopup() {
 
 void StreamWidget::onKill() {
 }
+
+void StreamWidget::setSelected(bool s) {
+    if (s == selected)
+        return;
+
+    selected = s;
+    select->setChecked(s);
+
+    setAutoFillBackground(s);
+    setBackgroundRole(s ? QPalette::Midlight : QPalette::Window);
+}
+
+void StreamWidget::mousePressEvent(QMouseEvent *event) {
+    if (select->isEnabled() && event->button() == Qt::LeftButton && (event->modifiers() & Qt::ControlModifier)) {
+        setSelected(!selected);
+        event->accept();
+        return;
+    }
+
+    MinimalStreamWidget::mousePressEvent(event);
+}
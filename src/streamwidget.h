@@ -30,6 +30,7 @@
 class MainWindow;
 class Channel;
 class QAction;
+class QMouseEvent;
 
 class StreamWidget : public MinimalStreamWidget, public Ui::StreamWidget {
     Q_OBJECT
@@ -45,6 +46,9 @@ public:
     pa_channel_map channelMap;
     pa_cvolume volume;
 
+    /* Finds the same stream again after a reconnect, when its index changed */
+    QByteArray reconnectKey;
+
     Channel *channels[PA_CHANNELS_MAX];
 
     virtual void onMuteToggleButton();
@@ -52,17 +56,25 @@ public:
     virtual void onDeviceChangePopup();
     // virtual bool onContextTriggerEvent(GdkEventButton*);
 
+    /* Runs while a volume change made here may still be echoed back by the
+     * server, incoming volumes are not shown meanwhile */
     QTimer timeout;
 
-    bool timeoutEvent();
-
     virtual void executeVolumeUpdate();
     virtual void onKill();
 
+    /* Picked for changes to several streams at once, with Ctrl+click or
+     * from the context menu */
+    bool selected;
+    void setSelected(bool s);
+
 protected:
+    void mousePressEvent(QMouseEvent *event) override;
+
     MainWindow* mpMainWindow;
 
     QAction * terminate;
+    QAction * select;
 };
 
 #endif
@@ -0,0 +1,887 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "trace.h"
+#include "mainwindow.h"
+
+#include <QApplication>
+#include <QDataStream>
+#include <QFile>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#define TRACE_MAGIC "PAVT"
+#define TRACE_VERSION 1
+
+/* Sanity limits when reading, a trace may come from anywhere */
+#define TRACE_MAX_RECORD_SIZE (1024 * 1024)
+#define TRACE_MAX_STRING_SIZE (64 * 1024)
+#define TRACE_MAX_ITEMS 1024
+
+/* Time spent replaying before letting the UI paint */
+#define REPLAY_SLICE_US 20000
+
+/* Owns everything a decoded info struct points to */
+class TraceArena {
+public:
+    ~TraceArena() {
+        for (pa_proplist *p : mProplists)
+            pa_proplist_free(p);
+    }
+
+    template<typename T> T *alloc(size_t n) {
+        std::shared_ptr<T> p(new T[n ? n : 1](), std::default_delete<T[]>());
+        mBlocks.push_back(p);
+        return p.get();
+    }
+
+    pa_proplist *proplist() {
+        pa_proplist *p = pa_proplist_new();
+        mProplists.push_back(p);
+        return p;
+    }
+
+private:
+    std::vector<std::shared_ptr<void> > mBlocks;
+    std::vector<pa_proplist*> mProplists;
+};
+
+/*** Encoding ***/
+
+static void put_string(QDataStream &s, const char *str) {
+    if (!str) {
+        s << quint32(0xffffffff);
+        return;
+    }
+
+    const quint32 n = strlen(str);
+    s << n;
+    s.writeRawData(str, n);
+}
+
+static void put_channel_map(QDataStream &s, const pa_channel_map &m) {
+    s << quint8(m.channels);
+    for (unsigned i = 0; i < m.channels; ++i)
+        s << qint32(m.map[i]);
+}
+
+static void put_cvolume(QDataStream &s, const pa_cvolume &v) {
+    s << quint8(v.channels);
+    for (unsigned i = 0; i < v.channels; ++i)
+        s << quint32(v.values[i]);
+}
+
+static void put_proplist(QDataStream &s, pa_proplist *p) {
+    std::vector<std::pair<const char*, const char*> > strings;
+    void *state = nullptr;
+    const char *key;
+
+    /* Only string properties are kept, nothing here looks at the others */
+    while (p && (key = pa_proplist_iterate(p, &state))) {
+        const char *value = pa_proplist_gets(p, key);
+        if (value)
+            strings.push_back(std::make_pair(key, value));
+    }
+
+    s << quint32(strings.size());
+    for (auto & string : strings) {
+        put_string(s, string.first);
+        put_string(s, string.second);
+    }
+}
+
+template<typename Port>
+static void put_device_ports(QDataStream &s, Port **ports, uint32_t n_ports, Port *active_port) {
+    s << quint32(n_ports);
+    for (uint32_t i = 0; i < n_ports; ++i) {
+        put_string(s, ports[i]->name);
+        put_string(s, ports[i]->description);
+        s << quint32(ports[i]->priority) << qint32(ports[i]->available);
+    }
+    put_string(s, active_port ? active_port->name : nullptr);
+}
+
+static void put_card(QDataStream &s, const pa_card_info &i) {
+    uint32_t n_profiles = 0;
+
+    while (i.profiles2 && i.profiles2[n_profiles])
+        n_profiles++;
+
+    s << quint32(i.index);
+    put_string(s, i.name);
+    put_string(s, i.driver);
+    put_proplist(s, i.proplist);
+
+    s << quint32(n_profiles);
+    for (uint32_t j = 0; j < n_profiles; ++j) {
+        const pa_card_profile_info2 *p = i.profiles2[j];
+        put_string(s, p->name);
+        put_string(s, p->description);
+        s << quint32(p->n_sinks) << quint32(p->n_sources) << quint32(p->priority) << qint32(p->available);
+    }
+    put_string(s, i.active_profile2 ? i.active_profile2->name : nullptr);
+
+    s << quint32(i.n_ports);
+    for (uint32_t j = 0; j < i.n_ports; ++j) {
+        const pa_card_port_info *p = i.ports[j];
+        std::vector<quint32> profiles;
+
+        put_string(s, p->name);
+        put_string(s, p->description);
+        s << quint32(p->priority) << qint32(p->available) << qint32(p->direction) << qint64(p->latency_offset);
+
+        /* Port profiles are stored as indexes into the card's profiles */
+        for (pa_card_profile_info2 **pp = p->profiles2; pp && *pp; ++pp)
+            for (uint32_t k = 0; k < n_profiles; ++k)
+                if (strcmp((*pp)->name, i.profiles2[k]->name) == 0) {
+                    profiles.push_back(k);
+                    break;
+                }
+
+        s << quint32(profiles.size());
+        for (quint32 k : profiles)
+            s << k;
+    }
+}
+
+static void put_sink(QDataStream &s, const pa_sink_info &i) {
+    s << quint32(i.index);
+    put_string(s, i.name);
+    put_string(s, i.description);
+    put_channel_map(s, i.channel_map);
+    put_cvolume(s, i.volume);
+    s << quint8(!!i.mute) << quint32(i.monitor_source) << quint32(i.flags) << quint32(i.base_volume) << quint32(i.card);
+    put_proplist(s, i.proplist);
+    put_device_ports(s, i.ports, i.n_ports, i.active_port);
+}
+
+static void put_source(QDataStream &s, const pa_source_info &i) {
+    s << quint32(i.index);
+    put_string(s, i.name);
+    put_string(s, i.description);
+    put_channel_map(s, i.channel_map);
+    put_cvolume(s, i.volume);
+    s << quint8(!!i.mute) << quint32(i.monitor_of_sink) << quint32(i.flags) << quint32(i.base_volume) << quint32(i.card);
+    put_proplist(s, i.proplist);
+    put_device_ports(s, i.ports, i.n_ports, i.active_port);
+}
+
+static void put_sink_input(QDataStream &s, const pa_sink_input_info &i) {
+    s << quint32(i.index);
+    put_string(s, i.name);
+    s << quint32(i.client) << quint32(i.sink);
+    put_channel_map(s, i.channel_map);
+    put_cvolume(s, i.volume);
+    s << quint8(!!i.mute);
+    put_proplist(s, i.proplist);
+}
+
+static void put_source_output(QDataStream &s, const pa_source_output_info &i) {
+    s << quint32(i.index);
+    put_string(s, i.name);
+    s << quint32(i.client) << quint32(i.source);
+    put_channel_map(s, i.channel_map);
+#if HAVE_SOURCE_OUTPUT_VOLUMES
+    put_cvolume(s, i.volume);
+    s << quint8(!!i.mute);
+#else
+    pa_cvolume v;
+    put_cvolume(s, *pa_cvolume_init(&v));
+    s << quint8(0);
+#endif
+    put_proplist(s, i.proplist);
+}
+
+/*** Decoding ***/
+
+static const char *get_string(QDataStream &s, TraceArena &a) {
+    quint32 n;
+
+    s >> n;
+    if (s.status() != QDataStream::Ok || n == 0xffffffff)
+        return nullptr;
+
+    if (n > TRACE_MAX_STRING_SIZE) {
+        s.setStatus(QDataStream::ReadCorruptData);
+        return nullptr;
+    }
+
+    char *str = a.alloc<char>(n + 1);
+    if (s.readRawData(str, n) != (int) n)
+        s.setStatus(QDataStream::ReadPastEnd);
+    return str;
+}
+
+/* For fields the UI expects to be set */
+static const char *get_nonnull_string(QDataStream &s, TraceArena &a) {
+    const char *str = get_string(s, a);
+    return str ? str : "";
+}
+
+static quint32 get_count(QDataStream &s) {
+    quint32 n;
+
+    s >> n;
+    if (n > TRACE_MAX_ITEMS) {
+        s.setStatus(QDataStream::ReadCorruptData);
+        return 0;
+    }
+    return n;
+}
+
+static void get_channel_map(QDataStream &s, pa_channel_map &m) {
+    quint8 channels;
+
+    s >> channels;
+    if (channels > PA_CHANNELS_MAX) {
+        s.setStatus(QDataStream::ReadCorruptData);
+        channels = 0;
+    }
+
+    pa_channel_map_init(&m);
+    m.channels = channels;
+    for (unsigned i = 0; i < channels; ++i) {
+        qint32 position;
+        s >> position;
+        m.map[i] = (pa_channel_position_t) position;
+    }
+}
+
+static void get_cvolume(QDataStream &s, pa_cvolume &v) {
+    quint8 channels;
+
+    s >> channels;
+    if (channels > PA_CHANNELS_MAX) {
+        s.setStatus(QDataStream::ReadCorruptData);
+        channels = 0;
+    }
+
+    pa_cvolume_init(&v);
+    v.channels = channels;
+    for (unsigned i = 0; i < channels; ++i) {
+        quint32 value;
+        s >> value;
+        v.values[i] = value;
+    }
+}
+
+static pa_proplist *get_proplist(QDataStream &s, TraceArena &a) {
+    pa_proplist *p = a.proplist();
+    const quint32 n = get_count(s);
+
+    for (quint32 i = 0; i < n && s.status() == QDataStream::Ok; ++i) {
+        const char *key = get_string(s, a);
+        const char *value = get_string(s, a);
+
+        if (key && value)
+            pa_proplist_sets(p, key, value);
+    }
+    return p;
+}
+
+template<typename Port>
+static void get_device_ports(QDataStream &s, TraceArena &a, Port **&ports, uint32_t &n_ports, Port *&active_port) {
+    n_ports = get_count(s);
+
+    Port *storage = a.alloc<Port>(n_ports);
+    ports = a.alloc<Port*>(n_ports + 1);
+    active_port = nullptr;
+
+    for (uint32_t i = 0; i < n_ports; ++i) {
+        quint32 priority;
+        qint32 available;
+
+        storage[i].name = get_nonnull_string(s, a);
+        storage[i].description = get_nonnull_string(s, a);
+        s >> priority >> available;
+        storage[i].priority = priority;
+        storage[i].available = available;
+        ports[i] = &storage[i];
+    }
+
+    const char *active = get_string(s, a);
+    for (uint32_t i = 0; active && i < n_ports; ++i)
+        if (strcmp(storage[i].name, active) == 0)
+            active_port = &storage[i];
+}
+
+static bool get_card(QDataStream &s, TraceArena &a, pa_card_info &i) {
+    quint32 index;
+
+    s >> index;
+    i.index = index;
+    i.owner_module = PA_INVALID_INDEX;
+    i.name = get_nonnull_string(s, a);
+    i.driver = get_string(s, a);
+    i.proplist = get_proplist(s, a);
+
+    i.n_profiles = get_count(s);
+    i.profiles = a.alloc<pa_card_profile_info>(i.n_profiles);
+    pa_card_profile_info2 *profiles = a.alloc<pa_card_profile_info2>(i.n_profiles);
+    i.profiles2 = a.alloc<pa_card_profile_info2*>(i.n_profiles + 1);
+
+    for (uint32_t j = 0; j < i.n_profiles; ++j) {
+        pa_card_profile_info2 &p = profiles[j];
+        quint32 n_sinks, n_sources, priority;
+        qint32 available;
+
+        p.name = get_nonnull_string(s, a);
+        p.description = get_nonnull_string(s, a);
+        s >> n_sinks >> n_sources >> priority >> available;
+        p.n_sinks = n_sinks;
+        p.n_sources = n_sources;
+        p.priority = priority;
+        p.available = available;
+
+        i.profiles[j].name = p.name;
+        i.profiles[j].description = p.description;
+        i.profiles[j].n_sinks = p.n_sinks;
+        i.profiles[j].n_sources = p.n_sources;
+        i.profiles[j].priority = p.priority;
+
+        i.profiles2[j] = &p;
+    }
+
+    const char *active = get_string(s, a);
+    i.active_profile = nullptr;
+    i.active_profile2 = nullptr;
+    for (uint32_t j = 0; active && j < i.n_profiles; ++j)
+        if (strcmp(profiles[j].name, active) == 0) {
+            i.active_profile = &i.profiles[j];
+            i.active_profile2 = &profiles[j];
+        }
+
+    i.n_ports = get_count(s);
+    pa_card_port_info *ports = a.alloc<pa_card_port_info>(i.n_ports);
+    i.ports = a.alloc<pa_card_port_info*>(i.n_ports + 1);
+
+    for (uint32_t j = 0; j < i.n_ports; ++j) {
+        pa_card_port_info &p = ports[j];
+        quint32 priority;
+        qint32 available, direction;
+        qint64 latency_offset;
+
+        p.name = get_nonnull_string(s, a);
+        p.description = get_nonnull_string(s, a);
+        s >> priority >> available >> direction >> latency_offset;
+        p.priority = priority;
+        p.available = available;
+        p.direction = direction;
+        p.latency_offset = latency_offset;
+        p.proplist = a.proplist();
+
+        p.n_profiles = get_count(s);
+        p.profiles2 = a.alloc<pa_card_profile_info2*>(p.n_profiles + 1);
+        for (uint32_t k = 0; k < p.n_profiles; ++k) {
+            quint32 profile;
+            s >> profile;
+            if (profile >= i.n_profiles) {
+                s.setStatus(QDataStream::ReadCorruptData);
+                return false;
+            }
+            p.profiles2[k] = &profiles[profile];
+        }
+
+        i.ports[j] = &p;
+    }
+
+    return s.status() == QDataStream::Ok;
+}
+
+static bool get_sink(QDataStream &s, TraceArena &a, pa_sink_info &i) {
+    quint32 index, monitor_source, flags, base_volume, card;
+    quint8 mute;
+
+    s >> index;
+    i.index = index;
+    i.name = get_nonnull_string(s, a);
+    i.description = get_nonnull_string(s, a);
+    get_channel_map(s, i.channel_map);
+    get_cvolume(s, i.volume);
+    s >> mute >> monitor_source >> flags >> base_volume >> card;
+    i.mute = mute;
+    i.monitor_source = monitor_source;
+    i.flags = (pa_sink_flags_t) flags;
+    i.base_volume = base_volume;
+    i.card = card;
+    i.owner_module = PA_INVALID_INDEX;
+    i.proplist = get_proplist(s, a);
+    get_device_ports(s, a, i.ports, i.n_ports, i.active_port);
+
+    return s.status() == QDataStream::Ok;
+}
+
+static bool get_source(QDataStream &s, TraceArena &a, pa_source_info &i) {
+    quint32 index, monitor_of_sink, flags, base_volume, card;
+    quint8 mute;
+
+    s >> index;
+    i.index = index;
+    i.name = get_nonnull_string(s, a);
+    i.description = get_nonnull_string(s, a);
+    get_channel_map(s, i.channel_map);
+    get_cvolume(s, i.volume);
+    s >> mute >> monitor_of_sink >> flags >> base_volume >> card;
+    i.mute = mute;
+    i.monitor_of_sink = monitor_of_sink;
+    i.flags = (pa_source_flags_t) flags;
+    i.base_volume = base_volume;
+    i.card = card;
+    i.owner_module = PA_INVALID_INDEX;
+    i.proplist = get_proplist(s, a);
+    get_device_ports(s, a, i.ports, i.n_ports, i.active_port);
+
+    return s.status() == QDataStream::Ok;
+}
+
+static bool get_sink_input(QDataStream &s, TraceArena &a, pa_sink_input_info &i) {
+    quint32 index, client, sink;
+    quint8 mute;
+
+    s >> index;
+    i.index = index;
+    i.name = get_nonnull_string(s, a);
+    s >> client >> sink;
+    i.client = client;
+    i.sink = sink;
+    i.owner_module = PA_INVALID_INDEX;
+    get_channel_map(s, i.channel_map);
+    get_cvolume(s, i.volume);
+    s >> mute;
+    i.mute = mute;
+    i.proplist = get_proplist(s, a);
+
+    return s.status() == QDataStream::Ok;
+}
+
+static bool get_source_output(QDataStream &s, TraceArena &a, pa_source_output_info &i) {
+    quint32 index, client, source;
+    pa_cvolume volume;
+    quint8 mute;
+
+    s >> index;
+    i.index = index;
+    i.name = get_nonnull_string(s, a);
+    s >> client >> source;
+    i.client = client;
+    i.source = source;
+    i.owner_module = PA_INVALID_INDEX;
+    get_channel_map(s, i.channel_map);
+    get_cvolume(s, volume);
+    s >> mute;
+#if HAVE_SOURCE_OUTPUT_VOLUMES
+    i.volume = volume;
+    i.mute = mute;
+#endif
+    i.proplist = get_proplist(s, a);
+
+    return s.status() == QDataStream::Ok;
+}
+
+/*** Recording ***/
+
+static QFile *record_file = nullptr;
+static QDataStream *record_stream = nullptr;
+static gint64 record_start = 0;
+
+bool trace_record_open(const char *path) {
+    trace_record_close();
+
+    record_file = new QFile(QString::fromLocal8Bit(path));
+    if (!record_file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        delete record_file;
+        record_file = nullptr;
+        return false;
+    }
+
+    record_stream = new QDataStream(record_file);
+    record_stream->setVersion(QDataStream::Qt_5_0);
+    record_stream->writeRawData(TRACE_MAGIC, 4);
+    *record_stream << quint32(TRACE_VERSION);
+
+    record_start = g_get_monotonic_time();
+    return true;
+}
+
+void trace_record_close(void) {
+    if (!record_file)
+        return;
+
+    delete record_stream;
+    record_stream = nullptr;
+    record_file->close();
+    delete record_file;
+    record_file = nullptr;
+}
+
+static void write_record(TraceRecordType type, const QByteArray &payload) {
+    *record_stream << quint8(type) << quint64(g_get_monotonic_time() - record_start) << quint32(payload.size());
+    record_stream->writeRawData(payload.constData(), payload.size());
+}
+
+template<typename Info>
+static void record(TraceRecordType type, void (*put)(QDataStream&, const Info&), const Info &i) {
+    if (!record_stream)
+        return;
+
+    QByteArray payload;
+    QDataStream s(&payload, QIODevice::WriteOnly);
+    put(s, i);
+    write_record(type, payload);
+}
+
+void trace_record_event(pa_subscription_event_type_t t, uint32_t index) {
+    if (!record_stream)
+        return;
+
+    QByteArray payload;
+    QDataStream s(&payload, QIODevice::WriteOnly);
+    s << quint32(t) << quint32(index);
+    write_record(TRACE_EVENT, payload);
+}
+
+void trace_record_card(const pa_card_info &i) {
+    record(TRACE_CARD, put_card, i);
+}
+
+void trace_record_sink(const pa_sink_info &i) {
+    record(TRACE_SINK, put_sink, i);
+}
+
+void trace_record_source(const pa_source_info &i) {
+    record(TRACE_SOURCE, put_source, i);
+}
+
+void trace_record_sink_input(const pa_sink_input_info &i) {
+    record(TRACE_SINK_INPUT, put_sink_input, i);
+}
+
+void trace_record_source_output(const pa_source_output_info &i) {
+    record(TRACE_SOURCE_OUTPUT, put_source_output, i);
+}
+
+void trace_record_client(const pa_client_info &i) {
+    if (!record_stream)
+        return;
+
+    QByteArray payload;
+    QDataStream s(&payload, QIODevice::WriteOnly);
+    s << quint32(i.index);
+    put_string(s, i.name);
+    write_record(TRACE_CLIENT, payload);
+}
+
+void trace_record_server(const pa_server_info &i, uint32_t protocol_version) {
+    if (!record_stream)
+        return;
+
+    QByteArray payload;
+    QDataStream s(&payload, QIODevice::WriteOnly);
+    put_string(s, i.default_sink_name);
+    put_string(s, i.default_source_name);
+    s << quint32(protocol_version);
+    write_record(TRACE_SERVER, payload);
+}
+
+/*** Replay ***/
+
+struct TraceRecord {
+    quint8 type;
+    quint64 timestamp;
+    QByteArray payload;
+};
+
+struct TraceReplay {
+    MainWindow *window;
+    QFile file;
+    QDataStream stream;
+    bool fast;
+    bool pending;
+    TraceRecord record;
+    gint64 start;
+    gint64 busy;
+    quint64 records;
+    std::vector<gint64> latencies;
+};
+
+static TraceReplay *replay = nullptr;
+static uint32_t replay_protocol_version = 0;
+
+uint32_t trace_replay_protocol_version(void) {
+    return replay_protocol_version;
+}
+
+static bool read_record(QDataStream &s, TraceRecord &r) {
+    quint32 length;
+
+    s >> r.type >> r.timestamp >> length;
+    if (s.status() != QDataStream::Ok || length > TRACE_MAX_RECORD_SIZE)
+        return false;
+
+    r.payload.resize(length);
+    return s.readRawData(r.payload.data(), length) == (int) length;
+}
+
+static void apply_event(MainWindow *w, pa_subscription_event_type_t t, uint32_t index) {
+    /* New and changed objects are followed by their info record */
+    if ((t & PA_SUBSCRIPTION_EVENT_TYPE_MASK) != PA_SUBSCRIPTION_EVENT_REMOVE)
+        return;
+
+    switch (t & PA_SUBSCRIPTION_EVENT_FACILITY_MASK) {
+        case PA_SUBSCRIPTION_EVENT_SINK:
+            w->removeSink(index);
+            break;
+        case PA_SUBSCRIPTION_EVENT_SOURCE:
+            w->removeSource(index);
+            break;
+        case PA_SUBSCRIPTION_EVENT_SINK_INPUT:
+            w->removeSinkInput(index);
+            break;
+        case PA_SUBSCRIPTION_EVENT_SOURCE_OUTPUT:
+            w->removeSourceOutput(index);
+            break;
+        case PA_SUBSCRIPTION_EVENT_CLIENT:
+            w->removeClient(index);
+            break;
+        case PA_SUBSCRIPTION_EVENT_CARD:
+            w->removeCard(index);
+            break;
+    }
+}
+
+static bool apply_record(MainWindow *w, const TraceRecord &r) {
+    QDataStream s(r.payload);
+    TraceArena a;
+
+    switch (r.type) {
+        case TRACE_EVENT: {
+            quint32 t, index;
+            s >> t >> index;
+            if (s.status() != QDataStream::Ok)
+                return false;
+            apply_event(w, (pa_subscription_event_type_t) t, index);
+            return true;
+        }
+
+        case TRACE_CARD: {
+            pa_card_info i = {};
+            if (!get_card(s, a, i))
+                return false;
+            w->updateCard(i);
+            return true;
+        }
+
+        case TRACE_SINK: {
+            pa_sink_info i = {};
+            if (!get_sink(s, a, i))
+                return false;
+            w->updateSink(i);
+            return true;
+        }
+
+        case TRACE_SOURCE: {
+            pa_source_info i = {};
+            if (!get_source(s, a, i))
+                return false;
+            w->updateSource(i);
+            return true;
+        }
+
+        case TRACE_SINK_INPUT: {
+            pa_sink_input_info i = {};
+            if (!get_sink_input(s, a, i))
+                return false;
+            w->updateSinkInput(i);
+            return true;
+        }
+
+        case TRACE_SOURCE_OUTPUT: {
+            pa_source_output_info i = {};
+            if (!get_source_output(s, a, i))
+                return false;
+            w->updateSourceOutput(i);
+            return true;
+        }
+
+        case TRACE_CLIENT: {
+            pa_client_info i = {};
+            quint32 index;
+            s >> index;
+            i.index = index;
+            i.name = get_nonnull_string(s, a);
+            i.owner_module = PA_INVALID_INDEX;
+            i.proplist = a.proplist();
+            if (s.status() != QDataStream::Ok)
+                return false;
+            w->updateClient(i);
+            return true;
+        }
+
+        case TRACE_SERVER: {
+            pa_server_info i = {};
+            quint32 protocol_version;
+            i.default_sink_name = get_string(s, a);
+            i.default_source_name = get_string(s, a);
+            s >> protocol_version;
+            if (s.status() != QDataStream::Ok)
+                return false;
+            replay_protocol_version = protocol_version;
+            w->updateServer(i);
+            return true;
+        }
+    }
+
+    /* Unknown records from newer versions are skipped */
+    return true;
+}
+
+static gint64 percentile(std::vector<gint64> &sorted, unsigned p) {
+    if (sorted.empty())
+        return 0;
+    return sorted[std::min(sorted.size() - 1, sorted.size() * p / 100)];
+}
+
+static void finish_replay(bool ok) {
+    const gint64 elapsed = g_get_monotonic_time() - replay->start;
+    const bool fast = replay->fast;
+    std::vector<gint64> &latencies = replay->latencies;
+
+    if (!ok)
+        g_warning("%s", QObject::tr("Trace is truncated or corrupt, replay stopped after %1 records").arg(replay->records).toUtf8().constData());
+
+    g_print("%s\n", QObject::tr("Replayed %1 records in %2 ms, %3 ms spent updating the window (%4 records/s)")
+            .arg(replay->records)
+            .arg(elapsed / 1000.0, 0, 'f', 1)
+            .arg(replay->busy / 1000.0, 0, 'f', 1)
+            .arg(replay->busy > 0 ? replay->records * 1000000.0 / replay->busy : 0.0, 0, 'f', 0)
+            .toUtf8().constData());
+
+    std::sort(latencies.begin(), latencies.end());
+    g_print("%s\n", QObject::tr("Time per record: median %1 us, 95% %2 us, 99% %3 us, max %4 us")
+            .arg(percentile(latencies, 50))
+            .arg(percentile(latencies, 95))
+            .arg(percentile(latencies, 99))
+            .arg(latencies.empty() ? 0 : latencies.back())
+            .toUtf8().constData());
+
+    delete replay;
+    replay = nullptr;
+
+    if (fast)
+        qApp->quit();
+}
+
+static gboolean replay_cb(gpointer) {
+    const gint64 slice_end = g_get_monotonic_time() + REPLAY_SLICE_US;
+
+    for (;;) {
+        if (!replay->pending) {
+            if (replay->stream.atEnd()) {
+                finish_replay(true);
+                return FALSE;
+            }
+            if (!read_record(replay->stream, replay->record)) {
+                finish_replay(false);
+                return FALSE;
+            }
+            replay->pending = true;
+        }
+
+        if (!replay->fast) {
+            const gint64 wait = (gint64) replay->record.timestamp - (g_get_monotonic_time() - replay->start);
+            if (wait > 0) {
+                g_timeout_add((guint) ((wait + 999) / 1000), replay_cb, nullptr);
+                return FALSE;
+            }
+        }
+
+        const gint64 before = g_get_monotonic_time();
+        const bool ok = apply_record(replay->window, replay->record);
+        const gint64 latency = g_get_monotonic_time() - before;
+        replay->busy += latency;
+        replay->latencies.push_back(latency);
+        replay->pending = false;
+
+        if (!ok) {
+            finish_replay(false);
+            return FALSE;
+        }
+        replay->records++;
+
+        /* Let the window paint between slices */
+        if (g_get_monotonic_time() >= slice_end) {
+            g_idle_add(replay_cb, nullptr);
+            return FALSE;
+        }
+    }
+}
+
+bool trace_replay_start(MainWindow *w, const char *path, bool fast) {
+    char magic[4];
+    quint32 version;
+
+    if (replay)
+        return false;
+
+    replay = new TraceReplay();
+    replay->window = w;
+    replay->file.setFileName(QString::fromLocal8Bit(path));
+
+    if (!replay->file.open(QIODevice::ReadOnly)) {
+        delete replay;
+        replay = nullptr;
+        return false;
+    }
+
+    replay->stream.setDevice(&replay->file);
+    replay->stream.setVersion(QDataStream::Qt_5_0);
+
+    if (replay->stream.readRawData(magic, 4) != 4 || memcmp(magic, TRACE_MAGIC, 4) != 0) {
+        delete replay;
+        replay = nullptr;
+        return false;
+    }
+
+    replay->stream >> version;
+    if (replay->stream.status() != QDataStream::Ok || version != TRACE_VERSION) {
+        delete replay;
+        replay = nullptr;
+        return false;
+    }
+
+    replay->fast = fast;
+    replay->pending = false;
+    replay->start = g_get_monotonic_time();
+    replay->busy = 0;
+    replay->records = 0;
+
+    /* There is no server to fetch hidden tabs from or to send changes to */
+    w->markAllTabsBuilt();
+    for (int i = 0; i < w->notebook->count(); ++i)
+        w->notebook->widget(i)->setEnabled(false);
+    w->setConnectionState(true);
+
+    g_idle_add(replay_cb, nullptr);
+    return true;
+}
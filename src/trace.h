@@ -0,0 +1,66 @@
+/***
+  This file is part of pavucontrol-qt.
+
+  pavucontrol-qt is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  pavucontrol-qt is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with pavucontrol-qt. If not, see <https://www.gnu.org/licenses/>.
+***/
+
+#ifndef trace_h
+#define trace_h
+
+#include "pavucontrol.h"
+
+/* Binary traces of what the server sent us, for reproducing and measuring
+ * UI update problems without a server.
+ *
+ * A trace starts with the "PAVT" magic and a format version, followed by
+ * records made of a type byte, a timestamp in microseconds since the start
+ * of the recording, the payload length and the payload. All numbers are
+ * big endian. */
+
+enum TraceRecordType {
+    TRACE_EVENT = 1,
+    TRACE_CARD,
+    TRACE_SINK,
+    TRACE_SOURCE,
+    TRACE_SINK_INPUT,
+    TRACE_SOURCE_OUTPUT,
+    TRACE_CLIENT,
+    TRACE_SERVER
+};
+
+class MainWindow;
+
+bool trace_record_open(const char *path);
+void trace_record_close(void);
+
+/* These do nothing unless a recording is open */
+void trace_record_event(pa_subscription_event_type_t t, uint32_t index);
+void trace_record_card(const pa_card_info &i);
+void trace_record_sink(const pa_sink_info &i);
+void trace_record_source(const pa_source_info &i);
+void trace_record_sink_input(const pa_sink_input_info &i);
+void trace_record_source_output(const pa_source_output_info &i);
+void trace_record_client(const pa_client_info &i);
+void trace_record_server(const pa_server_info &i, uint32_t protocol_version);
+
+/* Feeds a trace into the window, at the recorded pace or as fast as
+ * possible, and prints the time spent per record at the end. A fast replay
+ * quits the application when done. */
+bool trace_replay_start(MainWindow *w, const char *path, bool fast);
+
+/* Protocol version of the server the trace being replayed was recorded
+ * from, 0 when not replaying */
+uint32_t trace_replay_protocol_version(void);
+
+#endif